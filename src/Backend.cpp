@@ -1,6 +1,7 @@
 #include "Backend.h"
 #include "Interpreter.h"
 #include "Compiler.h"
+#include "OutputBuffer.h"
 
 #include <cstdlib>
 
@@ -25,14 +26,15 @@ void RuntimeErrorHandler::flag(const std::shared_ptr<const ICodeNodeImplBase>& n
   std::shared_ptr<const ICodeNodeImplBase> ptr = node;
   int line_number = 0;
   do {
-    const auto line_attr = ptr->getAttribute(ICodeKeyTypeImpl::LINE);
-    if (line_attr.has_value()) {
-      line_number = cast_by_enum<ICodeKeyTypeImpl::LINE>(line_attr);
+    if (ptr->hasAttribute(ICodeKeyTypeImpl::LINE)) {
+      line_number = ptr->getAttribute<ICodeKeyTypeImpl::LINE>();
       break;
     }
     ptr = ptr->parent();
   } while (ptr != nullptr);
   backend->runtimeErrorMessage(line_number, runtimeErrorCodeToString(error_code));
+  // the output up to the error is not held back
+  OutputBuffer::instance().flush();
   if (++mErrorCount > MAX_ERRORS) {
     std::cerr << "ABORTED AFTER TOO MANY RUNTIME ERRORS.\n";
     std::exit(-1);
@@ -91,7 +91,8 @@ enum class PascalErrorCode {
   UNRECOGNIZABLE,
   WRONG_NUMBER_OF_PARMS,
   IO_ERROR,
-  TOO_MANY_ERRORS
+  TOO_MANY_ERRORS,
+  DEFERRED_BODY_ERRORS
 };
 
 enum class SymbolTableKeyTypeImpl {
@@ -99,9 +100,7 @@ enum class SymbolTableKeyTypeImpl {
   CONSTANT_VALUE,
   // Procedure of function
   ROUTINE_CODE, ROUTINE_SYMTAB, ROUTINE_ICODE,
-  ROUTINE_PARMS, ROUTINE_ROUTINES,
-  // Variable or record field value
-  DATA_VALUE
+  ROUTINE_PARMS, ROUTINE_ROUTINES
 };
 
 enum class ICodeKeyTypeImpl {
@@ -159,23 +158,6 @@ enum class RoutineCodeImpl {
   pred, round, sin, sqr, sqrt, succ, trunc,
 };
 
-extern std::map<PascalTokenTypeImpl, std::string> reservedWordsMap;
-extern std::map<std::string, PascalTokenTypeImpl> reservedWordsMapRev;
-extern std::map<PascalTokenTypeImpl, std::string> specialSymbolsMap;
-extern std::map<std::string, PascalTokenTypeImpl> specialSymbolsMapRev;
-extern std::map<PascalTokenTypeImpl, std::string> specialWordsMap;
-extern std::map<std::string, PascalTokenTypeImpl> specialWordsMapRev;
-
-// assume no key shares a same value
-template <typename T1, typename T2>
-std::map<T2, T1> reverse_map(const std::map<T1, T2>& map_in) {
-  std::map<T2, T1> map_out;
-  for (auto it = map_in.begin(); it != map_in.end(); ++it) {
-    map_out[it->second] = it->first;
-  }
-  return map_out;
-}
-
 std::string variable_value_to_string(const VariableValueT& a);
 
 void clear_line_ending(std::string& line);
@@ -0,0 +1,170 @@
+#ifndef CONTAINERS_H
+#define CONTAINERS_H
+
+#include "NameTable.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// alternative containers for the template aliases in Intermediate.h,
+// selected by the CONTAINER_POLICY option of CMake
+
+// vector keeping up to N elements inline
+// most ICode nodes have no more than three children.
+template <typename T, size_t N>
+class SmallVector {
+public:
+  using value_type = T;
+  using iterator = T*;
+  using const_iterator = const T*;
+  SmallVector(): mData(inlineData()), mSize(0), mCapacity(N) {}
+  SmallVector(const SmallVector& other): SmallVector() {
+    reserve(other.mSize);
+    std::uninitialized_copy(other.begin(), other.end(), mData);
+    mSize = other.mSize;
+  }
+  SmallVector(SmallVector&& other) noexcept: SmallVector() {
+    swap(other);
+  }
+  SmallVector& operator=(SmallVector other) noexcept {
+    swap(other);
+    return *this;
+  }
+  ~SmallVector() {
+    std::destroy(begin(), end());
+    if (!isInline()) ::operator delete(mData);
+  }
+  void push_back(T value) {
+    if (mSize == mCapacity) reserve(2 * mCapacity);
+    new (mData + mSize) T(std::move(value));
+    ++mSize;
+  }
+  void reserve(size_t capacity) {
+    if (capacity <= mCapacity) return;
+    T* data = static_cast<T*>(::operator new(capacity * sizeof(T)));
+    std::uninitialized_move(begin(), end(), data);
+    std::destroy(begin(), end());
+    if (!isInline()) ::operator delete(mData);
+    mData = data;
+    mCapacity = capacity;
+  }
+  [[nodiscard]] size_t size() const { return mSize; }
+  [[nodiscard]] bool empty() const { return mSize == 0; }
+  T& operator[](size_t i) { return mData[i]; }
+  const T& operator[](size_t i) const { return mData[i]; }
+  T& back() { return mData[mSize - 1]; }
+  const T& back() const { return mData[mSize - 1]; }
+  iterator begin() { return mData; }
+  iterator end() { return mData + mSize; }
+  const_iterator begin() const { return mData; }
+  const_iterator end() const { return mData + mSize; }
+  const_iterator cbegin() const { return mData; }
+  const_iterator cend() const { return mData + mSize; }
+private:
+  T* inlineData() { return std::launder(reinterpret_cast<T*>(mInline)); }
+  [[nodiscard]] bool isInline() const { return mCapacity == N; }
+  void swap(SmallVector& other) noexcept {
+    if (!isInline() && !other.isInline()) {
+      std::swap(mData, other.mData);
+    } else {
+      // at least one side is inline: move the elements through a temporary
+      SmallVector tmp;
+      tmp.takeFrom(*this);
+      takeFrom(other);
+      other.takeFrom(tmp);
+      return;
+    }
+    std::swap(mSize, other.mSize);
+    std::swap(mCapacity, other.mCapacity);
+  }
+  // move the elements of an other vector into this empty vector
+  void takeFrom(SmallVector& other) noexcept {
+    if (other.isInline()) {
+      std::uninitialized_move(other.begin(), other.end(), mData);
+      std::destroy(other.begin(), other.end());
+    } else {
+      mData = other.mData;
+      mCapacity = other.mCapacity;
+      other.mData = other.inlineData();
+      other.mCapacity = N;
+    }
+    mSize = other.mSize;
+    other.mSize = 0;
+  }
+  T* mData;
+  size_t mSize;
+  size_t mCapacity;
+  alignas(T) std::byte mInline[N * sizeof(T)];
+};
+
+// map as a vector of pairs sorted by key, for a handful of attributes
+template <typename KeyT, typename ValueT>
+class FlatMap {
+public:
+  using value_type = std::pair<KeyT, ValueT>;
+  using iterator = typename std::vector<value_type>::iterator;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+  iterator find(const KeyT& key) {
+    auto it = lowerBound(key);
+    return (it != mData.end() && it->first == key) ? it : mData.end();
+  }
+  const_iterator find(const KeyT& key) const {
+    auto it = lowerBound(key);
+    return (it != mData.end() && it->first == key) ? it : mData.end();
+  }
+  ValueT& operator[](const KeyT& key) {
+    auto it = lowerBound(key);
+    if (it == mData.end() || it->first != key) {
+      it = mData.emplace(it, key, ValueT{});
+    }
+    return it->second;
+  }
+  [[nodiscard]] size_t size() const { return mData.size(); }
+  [[nodiscard]] bool empty() const { return mData.empty(); }
+  iterator begin() { return mData.begin(); }
+  iterator end() { return mData.end(); }
+  const_iterator begin() const { return mData.begin(); }
+  const_iterator end() const { return mData.end(); }
+  const_iterator cbegin() const { return mData.cbegin(); }
+  const_iterator cend() const { return mData.cend(); }
+private:
+  iterator lowerBound(const KeyT& key) {
+    return std::lower_bound(mData.begin(), mData.end(), key,
+                            [](const value_type& a, const KeyT& b){return a.first < b;});
+  }
+  const_iterator lowerBound(const KeyT& key) const {
+    return std::lower_bound(mData.begin(), mData.end(), key,
+                            [](const value_type& a, const KeyT& b){return a.first < b;});
+  }
+  std::vector<value_type> mData;
+};
+
+// the FlatIdMap interface on top of std::unordered_map
+template <typename ValueT>
+class UnorderedIdMap {
+public:
+  [[nodiscard]] const ValueT* find(NameId id) const {
+    const auto search = mMap.find(id);
+    return search != mMap.end() ? &search->second : nullptr;
+  }
+  ValueT* find(NameId id) {
+    const auto search = mMap.find(id);
+    return search != mMap.end() ? &search->second : nullptr;
+  }
+  ValueT& operator[](NameId id) { return mMap[id]; }
+  [[nodiscard]] size_t size() const { return mMap.size(); }
+  [[nodiscard]] bool empty() const { return mMap.empty(); }
+  template <typename F>
+  void forEach(F&& f) const {
+    for (const auto& [id, value]: mMap) f(id, value);
+  }
+private:
+  std::unordered_map<NameId, ValueT> mMap;
+};
+
+#endif // CONTAINERS_H
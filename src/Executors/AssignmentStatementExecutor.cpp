@@ -17,12 +17,10 @@ std::shared_ptr<SubExecutorBase> AssignmentStatementExecutor::execute(const std:
   ExpressionExecutor expression_executor(currentExecutor());
   expression_executor.execute(expression_node);
   auto expression_value = expression_executor.value();
-  const auto variable_id = cast_by_enum<ICodeKeyTypeImpl::ID>(variable_node->getAttribute(ICodeKeyTypeImpl::ID));
-  variable_id->setAttribute(SymbolTableKeyTypeImpl::DATA_VALUE, expression_value);
-//  variable_id->setAttribute(SymbolTableKeyTypeImpl::DATA_INTERNAL_TYPE, expression_executor.valueType());
-  const auto line_number_attribute = node->getAttribute(ICodeKeyTypeImpl::LINE);
-  if (line_number_attribute.has_value()) {
-    const auto line_number = cast_by_enum<ICodeKeyTypeImpl::LINE>(line_number_attribute);
+  runtimeStack().value(variable_node->slotLevel(), variable_node->slot()) = expression_value;
+  if (node->hasAttribute(ICodeKeyTypeImpl::LINE)) {
+    const auto line_number = node->getAttribute<ICodeKeyTypeImpl::LINE>();
+    const auto variable_id = variable_node->getAttribute<ICodeKeyTypeImpl::ID>();
     currentExecutor()->assignmentMessage(line_number, variable_id->name(), expression_value);
   }
   ++executionCount();
@@ -0,0 +1,409 @@
+#include "CallExecutor.h"
+#include "ExpressionExecutor.h"
+#include "StatementExecutor.h"
+#include "Predefined.h"
+#include "OutputBuffer.h"
+#include "InputBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+CallExecutor::CallExecutor(const std::shared_ptr<Executor>& executor): SubExecutorBase(executor), mValue(VariableValueT{})
+{
+
+}
+
+std::shared_ptr<SubExecutorBase> CallExecutor::execute(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  const auto routine_id = node->getAttribute<ICodeKeyTypeImpl::ID>();
+  const auto* routine_code = routine_id->findAttribute<SymbolTableKeyTypeImpl::ROUTINE_CODE>();
+  if (!routine_code) {
+    BUG("the called routine has no routine code");
+  } else if ((*routine_code == RoutineCodeImpl::declared) ||
+             (*routine_code == RoutineCodeImpl::forward)) {
+    CallDeclaredExecutor call_executor(currentExecutor());
+    call_executor.execute(node);
+    mValue = call_executor.value();
+  } else {
+    CallStandardExecutor call_executor(currentExecutor());
+    call_executor.execute(node, *routine_code);
+    mValue = call_executor.value();
+  }
+  return nullptr;
+}
+
+VariableValueT CallExecutor::value() const
+{
+  return mValue;
+}
+
+CallDeclaredExecutor::CallDeclaredExecutor(const std::shared_ptr<Executor>& executor): CallExecutor(executor)
+{
+
+}
+
+std::shared_ptr<SubExecutorBase> CallDeclaredExecutor::execute(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  const auto routine_id = node->getAttribute<ICodeKeyTypeImpl::ID>();
+  // look the attributes up in place, copying them out of std::any would allocate
+  const auto* symbol_table = routine_id->findAttribute<SymbolTableKeyTypeImpl::ROUTINE_SYMTAB>();
+  const auto* icode = routine_id->findAttribute<SymbolTableKeyTypeImpl::ROUTINE_ICODE>();
+  const auto* formal_parms = routine_id->findAttribute<SymbolTableKeyTypeImpl::ROUTINE_PARMS>();
+  if (!symbol_table || !icode) {
+    BUG("the called routine has no symbol table or intermediate code");
+    return nullptr;
+  }
+  auto& runtime_stack = runtimeStack();
+  if (nativeStackUsed() >= MAX_NATIVE_STACK) {
+    errorHandler()->flag(node, RuntimeErrorCode::STACK_OVERFLOW, currentExecutor());
+    return nullptr;
+  }
+  const int nesting_level = (*symbol_table)->nestingLevel();
+  const size_t record_start = runtime_stack.push(nesting_level, (*symbol_table)->slotCount());
+  if (formal_parms && node->numChildren() > 0) {
+    passParameters(*node->childrenBegin(), *formal_parms, record_start);
+  }
+  runtime_stack.activate();
+  // execute the routine's body
+  const auto root = (*icode)->getRoot();
+  if (root != nullptr) {
+    StatementExecutor statement_executor(currentExecutor());
+    statement_executor.execute(root);
+  }
+  // a function leaves its result in its own slot
+  if (routine_id->getDefinition() == DefinitionImpl::FUNCTION) {
+    mValue = std::move(runtime_stack.at(record_start + routine_id->slot()));
+  }
+  runtime_stack.pop();
+  ++executionCount();
+  return nullptr;
+}
+
+void CallDeclaredExecutor::passParameters(
+  const std::shared_ptr<ICodeNodeImplBase>& parms_node,
+  const std::vector<std::shared_ptr<SymbolTableEntryImplBase>>& formal_parms,
+  size_t record_start)
+{
+  auto& runtime_stack = runtimeStack();
+  auto actual_it = parms_node->childrenBegin();
+  for (const auto& formal_id: formal_parms) {
+    if (actual_it == parms_node->childrenEnd()) break;
+    const auto& actual_node = *actual_it++;
+    const size_t location = record_start + formal_id->slot();
+    if (formal_id->getDefinition() == DefinitionImpl::VAR_PARM) {
+      // the formal parameter refers to the actual variable
+      runtime_stack.bind(location, runtime_stack.location(actual_node->slotLevel(), actual_node->slot()));
+    } else {
+      // the actual parameters are evaluated before the callee's record is activated
+      ExpressionExecutor expression_executor(currentExecutor());
+      expression_executor.execute(actual_node);
+      auto value = expression_executor.value();
+      // an integer passed to a real parameter
+      if (std::holds_alternative<PascalInteger>(value) &&
+          formal_id->getTypeSpec()->rawBaseType() == Predefined::instance().realType.get()) {
+        value = static_cast<PascalFloat>(std::get<PascalInteger>(value));
+      }
+      runtime_stack.at(location) = std::move(value);
+    }
+  }
+}
+
+namespace {
+
+PascalFloat standardArctan(PascalFloat x) { return std::atan(x); }
+PascalFloat standardCos(PascalFloat x) { return std::cos(x); }
+PascalFloat standardExp(PascalFloat x) { return std::exp(x); }
+PascalFloat standardSin(PascalFloat x) { return std::sin(x); }
+
+}
+
+const CallStandardExecutor::RoutineTableT CallStandardExecutor::mRoutines = [](){
+  RoutineTableT table;
+  table.fill(&CallStandardExecutor::executeUnimplemented);
+  const auto set = [&table](RoutineCodeImpl code, StandardRoutineT routine) {
+    table[static_cast<size_t>(code)] = routine;
+  };
+  using enum RoutineCodeImpl;
+  set(abs, &CallStandardExecutor::executeAbs);
+  set(arctan, &CallStandardExecutor::executeReal<standardArctan>);
+  set(chr, &CallStandardExecutor::executeChr);
+  set(cos, &CallStandardExecutor::executeReal<standardCos>);
+  set(eof, &CallStandardExecutor::executeEof);
+  set(eoln, &CallStandardExecutor::executeEoln);
+  set(exp, &CallStandardExecutor::executeReal<standardExp>);
+  set(ln, &CallStandardExecutor::executeLn);
+  set(odd, &CallStandardExecutor::executeOdd);
+  set(ord, &CallStandardExecutor::executeOrd);
+  set(pred, &CallStandardExecutor::executePredSucc<-1>);
+  set(read, &CallStandardExecutor::executeReadReadln<false>);
+  set(readln, &CallStandardExecutor::executeReadReadln<true>);
+  set(round, &CallStandardExecutor::executeRound);
+  set(sin, &CallStandardExecutor::executeReal<standardSin>);
+  set(sqr, &CallStandardExecutor::executeSqr);
+  set(sqrt, &CallStandardExecutor::executeSqrt);
+  set(succ, &CallStandardExecutor::executePredSucc<1>);
+  set(trunc, &CallStandardExecutor::executeTrunc);
+  set(write, &CallStandardExecutor::executeWriteWriteln<false>);
+  set(writeln, &CallStandardExecutor::executeWriteWriteln<true>);
+  return table;
+}();
+
+CallStandardExecutor::CallStandardExecutor(const std::shared_ptr<Executor>& executor): CallExecutor(executor)
+{
+
+}
+
+std::shared_ptr<SubExecutorBase> CallStandardExecutor::execute(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  const auto routine_id = node->getAttribute<ICodeKeyTypeImpl::ID>();
+  const auto* routine_code = routine_id->findAttribute<SymbolTableKeyTypeImpl::ROUTINE_CODE>();
+  if (routine_code) execute(node, *routine_code);
+  return nullptr;
+}
+
+void CallStandardExecutor::execute(const std::shared_ptr<ICodeNodeImplBase>& node, RoutineCodeImpl routine_code)
+{
+  (this->*mRoutines[static_cast<size_t>(routine_code)])(node);
+  ++executionCount();
+}
+
+VariableValueT CallStandardExecutor::argument(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  // CALL -> PARAMETERS -> the expression
+  const auto& parms_node = *node->childrenBegin();
+  ExpressionExecutor expression_executor(currentExecutor());
+  expression_executor.execute(*parms_node->childrenBegin());
+  return expression_executor.value();
+}
+
+PascalFloat CallStandardExecutor::realArgument(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  const auto value = argument(node);
+  if (const auto* x = std::get_if<PascalInteger>(&value)) return static_cast<PascalFloat>(*x);
+  return std::get<PascalFloat>(value);
+}
+
+void CallStandardExecutor::executeAbs(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  const auto value = argument(node);
+  if (const auto* x = std::get_if<PascalInteger>(&value)) {
+    mValue = (*x < 0) ? -*x : *x;
+  } else {
+    mValue = std::fabs(std::get<PascalFloat>(value));
+  }
+}
+
+void CallStandardExecutor::executeSqr(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  const auto value = argument(node);
+  if (const auto* x = std::get_if<PascalInteger>(&value)) {
+    mValue = *x * *x;
+  } else {
+    const auto y = std::get<PascalFloat>(value);
+    mValue = y * y;
+  }
+}
+
+template <PascalFloat (*Function)(PascalFloat)>
+void CallStandardExecutor::executeReal(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  mValue = Function(realArgument(node));
+}
+
+void CallStandardExecutor::executeLn(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  const auto x = realArgument(node);
+  if (x > 0.0) {
+    mValue = std::log(x);
+  } else {
+    mValue = 0.0;
+    errorHandler()->flag(node, RuntimeErrorCode::INVALID_STANDARD_FUNCTION_ARGUMENT, currentExecutor());
+  }
+}
+
+void CallStandardExecutor::executeSqrt(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  const auto x = realArgument(node);
+  if (x >= 0.0) {
+    mValue = std::sqrt(x);
+  } else {
+    mValue = 0.0;
+    errorHandler()->flag(node, RuntimeErrorCode::INVALID_STANDARD_FUNCTION_ARGUMENT, currentExecutor());
+  }
+}
+
+void CallStandardExecutor::executeChr(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  const auto value = argument(node);
+  // a one character string is kept inline, so this does not allocate
+  mValue.emplace<std::string>(1, static_cast<char>(std::get<PascalInteger>(value)));
+}
+
+void CallStandardExecutor::executeOdd(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  const auto value = argument(node);
+  mValue = (std::get<PascalInteger>(value) & 1) != 0;
+}
+
+void CallStandardExecutor::executeOrd(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  const auto value = argument(node);
+  std::visit(overloaded{
+    [this](const std::string& x){mValue = static_cast<PascalInteger>(static_cast<unsigned char>(x.empty() ? 0 : x[0]));},
+    [this](const bool x){mValue = static_cast<PascalInteger>(x ? 1 : 0);},
+    [this](const PascalInteger x){mValue = x;},
+    [this, &node](const auto&){
+      errorHandler()->flag(node, RuntimeErrorCode::INVALID_STANDARD_FUNCTION_ARGUMENT, currentExecutor());
+    },
+  }, value);
+}
+
+template <int Step>
+void CallStandardExecutor::executePredSucc(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  const auto value = argument(node);
+  // the constants false and true are integers, but the relational operators give a bool
+  if (const auto* x = std::get_if<bool>(&value)) {
+    if (*x == (Step > 0)) {
+      mValue = *x;
+      errorHandler()->flag(node, RuntimeErrorCode::VALUE_RANGE, currentExecutor());
+    } else {
+      mValue = !*x;
+    }
+    return;
+  }
+  const auto result = std::get<PascalInteger>(value) + Step;
+  mValue = result;
+  // an enumeration value must stay within its constants
+  const auto type_spec = node->getTypeSpec();
+  if (type_spec && type_spec->form() == TypeFormImpl::ENUMERATION) {
+    const auto count = static_cast<PascalInteger>(type_spec->getAttribute<TypeKeyImpl::ENUMERATION_CONSTANTS>().size());
+    if (result < 0 || result >= count) {
+      mValue = value;
+      errorHandler()->flag(node, RuntimeErrorCode::VALUE_RANGE, currentExecutor());
+    }
+  }
+}
+
+void CallStandardExecutor::executeRound(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  // halfway cases are rounded away from zero
+  mValue = static_cast<PascalInteger>(std::llround(realArgument(node)));
+}
+
+void CallStandardExecutor::executeTrunc(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  mValue = static_cast<PascalInteger>(realArgument(node));
+}
+
+template <bool Newline>
+void CallStandardExecutor::executeReadReadln(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  // readln without parameters has no PARAMETERS node
+  if (node->numChildren() > 0) {
+    const auto& parms_node = *node->childrenBegin();
+    for (auto it = parms_node->childrenBegin(); it != parms_node->childrenEnd(); ++it) {
+      readParameter(node, *it);
+    }
+  }
+  if constexpr (Newline) InputBuffer::instance().skipLine();
+}
+
+void CallStandardExecutor::readParameter(const std::shared_ptr<ICodeNodeImplBase>& node,
+                                         const std::shared_ptr<ICodeNodeImplBase>& variable_node)
+{
+  auto& input = InputBuffer::instance();
+  auto& target = runtimeStack().value(variable_node->slotLevel(), variable_node->slot());
+  const auto* type = variable_node->getTypeSpec()->rawBaseType();
+  const auto& predefined = Predefined::instance();
+  // the variable gets a zero of its type if the input is not a value of it
+  bool valid = false;
+  if (type == predefined.integerType.get()) {
+    PascalInteger x = 0;
+    valid = input.readInteger(x);
+    target = valid ? x : 0;
+  } else if (type == predefined.realType.get()) {
+    PascalFloat x = 0.0;
+    valid = input.readReal(x);
+    target = valid ? x : 0.0;
+  } else if (type == predefined.charType.get()) {
+    char x = ' ';
+    valid = input.readChar(x);
+    target.emplace<std::string>(1, x);
+  } else if (type == predefined.booleanType.get()) {
+    bool x = false;
+    valid = input.readBoolean(x);
+    target = x;
+  }
+  // not on the variable, which may be a shared leaf
+  if (!valid) {
+    errorHandler()->flag(node, RuntimeErrorCode::INVALID_INPUT, currentExecutor());
+  }
+}
+
+void CallStandardExecutor::executeEof(const std::shared_ptr<ICodeNodeImplBase>&)
+{
+  mValue = InputBuffer::instance().eof();
+}
+
+void CallStandardExecutor::executeEoln(const std::shared_ptr<ICodeNodeImplBase>&)
+{
+  mValue = InputBuffer::instance().eoln();
+}
+
+template <bool Newline>
+void CallStandardExecutor::executeWriteWriteln(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  // writeln without parameters has no PARAMETERS node
+  if (node->numChildren() > 0) {
+    const auto& parms_node = *node->childrenBegin();
+    for (auto it = parms_node->childrenBegin(); it != parms_node->childrenEnd(); ++it) {
+      writeParameter(*it);
+    }
+  }
+  if constexpr (Newline) OutputBuffer::instance().newline();
+}
+
+void CallStandardExecutor::writeParameter(const std::shared_ptr<ICodeNodeImplBase>& write_parm_node)
+{
+  auto it = write_parm_node->childrenBegin();
+  const auto& expression_node = *it++;
+  // the width and the precision are integer constants, and a zero means the minimum
+  int width = 0;
+  int precision = 0;
+  bool has_precision = false;
+  if (it != write_parm_node->childrenEnd()) {
+    width = static_cast<int>(std::get<PascalInteger>((*it++)->getAttribute<ICodeKeyTypeImpl::VALUE>()));
+  }
+  if (it != write_parm_node->childrenEnd()) {
+    precision = static_cast<int>(std::get<PascalInteger>((*it)->getAttribute<ICodeKeyTypeImpl::VALUE>()));
+    has_precision = true;
+  }
+  ExpressionExecutor expression_executor(currentExecutor());
+  expression_executor.execute(expression_node);
+  const auto value = expression_executor.value();
+  auto& output = OutputBuffer::instance();
+  std::visit(overloaded{
+    [&](const PascalInteger x){
+      // the constants false and true are integers
+      const auto type_spec = expression_node->getTypeSpec();
+      if (type_spec && type_spec->rawBaseType() == Predefined::instance().booleanType.get()) {
+        output.writeString(x != 0 ? "true" : "false", width);
+      } else {
+        output.writeInteger(x, width);
+      }
+    },
+    [&](const PascalFloat x){output.writeReal(x, width, has_precision ? std::max(precision, 1) : 6);},
+    [&](const bool x){output.writeString(x ? "true" : "false", width);},
+    [&](const std::string& x){output.writeString(x, width);},
+    [&](const auto&){
+      // not on the expression, which may be a shared leaf
+      errorHandler()->flag(write_parm_node, RuntimeErrorCode::UNINITIALIZED_VALUE, currentExecutor());
+    },
+  }, value);
+}
+
+void CallStandardExecutor::executeUnimplemented(const std::shared_ptr<ICodeNodeImplBase>& node)
+{
+  errorHandler()->flag(node, RuntimeErrorCode::UNIMPLEMENTED_FEATURE, currentExecutor());
+}
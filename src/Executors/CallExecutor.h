@@ -0,0 +1,78 @@
+#ifndef CALLEXECUTOR_H
+#define CALLEXECUTOR_H
+
+#include "Interpreter.h"
+
+#include <array>
+
+class CallExecutor : public SubExecutorBase
+{
+public:
+  explicit CallExecutor(const std::shared_ptr<Executor>& executor);
+  virtual std::shared_ptr<SubExecutorBase> execute(const std::shared_ptr<ICodeNodeImplBase>& node) override;
+  // the result of a function call
+  [[nodiscard]] VariableValueT value() const;
+protected:
+  VariableValueT mValue;
+};
+
+class CallDeclaredExecutor : public CallExecutor
+{
+public:
+  explicit CallDeclaredExecutor(const std::shared_ptr<Executor>& executor);
+  virtual std::shared_ptr<SubExecutorBase> execute(const std::shared_ptr<ICodeNodeImplBase>& node) override;
+private:
+  // the executors recurse for every nested call, so the depth of the
+  // recursion is bounded by the native stack they have used, which is
+  // half of the usual 8 MiB of the main thread
+  static const size_t MAX_NATIVE_STACK = 4 << 20;
+  // evaluate the actual parameters into the slots of the callee's record
+  void passParameters(const std::shared_ptr<ICodeNodeImplBase>& parms_node,
+                      const std::vector<std::shared_ptr<SymbolTableEntryImplBase>>& formal_parms,
+                      size_t record_start);
+};
+
+class CallStandardExecutor : public CallExecutor
+{
+public:
+  explicit CallStandardExecutor(const std::shared_ptr<Executor>& executor);
+  virtual std::shared_ptr<SubExecutorBase> execute(const std::shared_ptr<ICodeNodeImplBase>& node) override;
+  // the same, when the caller already knows the routine code
+  void execute(const std::shared_ptr<ICodeNodeImplBase>& node, RoutineCodeImpl routine_code);
+private:
+  using StandardRoutineT = void (CallStandardExecutor::*)(const std::shared_ptr<ICodeNodeImplBase>& node);
+  using RoutineTableT = std::array<StandardRoutineT, static_cast<size_t>(RoutineCodeImpl::trunc) + 1>;
+  // indexed by RoutineCodeImpl
+  static const RoutineTableT mRoutines;
+  // the value of the single actual parameter
+  VariableValueT argument(const std::shared_ptr<ICodeNodeImplBase>& node);
+  PascalFloat realArgument(const std::shared_ptr<ICodeNodeImplBase>& node);
+  void executeAbs(const std::shared_ptr<ICodeNodeImplBase>& node);
+  void executeSqr(const std::shared_ptr<ICodeNodeImplBase>& node);
+  // arctan, cos, exp and sin, defined for every real argument
+  template <PascalFloat (*Function)(PascalFloat)>
+  void executeReal(const std::shared_ptr<ICodeNodeImplBase>& node);
+  void executeLn(const std::shared_ptr<ICodeNodeImplBase>& node);
+  void executeSqrt(const std::shared_ptr<ICodeNodeImplBase>& node);
+  void executeChr(const std::shared_ptr<ICodeNodeImplBase>& node);
+  void executeOdd(const std::shared_ptr<ICodeNodeImplBase>& node);
+  void executeOrd(const std::shared_ptr<ICodeNodeImplBase>& node);
+  template <int Step>
+  void executePredSucc(const std::shared_ptr<ICodeNodeImplBase>& node);
+  void executeRound(const std::shared_ptr<ICodeNodeImplBase>& node);
+  void executeTrunc(const std::shared_ptr<ICodeNodeImplBase>& node);
+  template <bool Newline>
+  void executeReadReadln(const std::shared_ptr<ICodeNodeImplBase>& node);
+  // read one value of the variable's type into its slot
+  void readParameter(const std::shared_ptr<ICodeNodeImplBase>& node,
+                     const std::shared_ptr<ICodeNodeImplBase>& variable_node);
+  void executeEof(const std::shared_ptr<ICodeNodeImplBase>& node);
+  void executeEoln(const std::shared_ptr<ICodeNodeImplBase>& node);
+  template <bool Newline>
+  void executeWriteWriteln(const std::shared_ptr<ICodeNodeImplBase>& node);
+  // one WRITE_PARM: the expression, and optionally the width and the precision
+  void writeParameter(const std::shared_ptr<ICodeNodeImplBase>& write_parm_node);
+  void executeUnimplemented(const std::shared_ptr<ICodeNodeImplBase>& node);
+};
+
+#endif // CALLEXECUTOR_H
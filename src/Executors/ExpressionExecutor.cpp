@@ -1,4 +1,5 @@
 #include "ExpressionExecutor.h"
+#include "CallExecutor.h"
 
 const std::set<ICodeNodeTypeImpl> ExpressionExecutor::mArithOps = {
     ICodeNodeTypeImpl::ADD, ICodeNodeTypeImpl::SUBTRACT,
@@ -13,20 +14,19 @@ std::shared_ptr<SubExecutorBase> ExpressionExecutor::execute(
   const auto node_type = node->type();
   switch (node_type) {
   case ICodeNodeTypeImpl::VARIABLE: {
-    const auto entry = cast_by_enum<ICodeKeyTypeImpl::ID>(node->getAttribute(ICodeKeyTypeImpl::ID));
-    mValue = cast_by_enum<SymbolTableKeyTypeImpl::DATA_VALUE>(entry->getAttribute(SymbolTableKeyTypeImpl::DATA_VALUE));
+    mValue = runtimeStack().value(node->slotLevel(), node->slot());
     break;
   }
-  case ICodeNodeTypeImpl::INTEGER_CONSTANT: {
-    mValue = std::any_cast<PascalInteger>(node->getAttribute(ICodeKeyTypeImpl::VALUE));
-    break;
-  }
-  case ICodeNodeTypeImpl::REAL_CONSTANT: {
-    mValue = std::any_cast<PascalFloat>(node->getAttribute(ICodeKeyTypeImpl::VALUE));
+  case ICodeNodeTypeImpl::INTEGER_CONSTANT:
+  case ICodeNodeTypeImpl::REAL_CONSTANT:
+  case ICodeNodeTypeImpl::STRING_CONSTANT: {
+    mValue = node->getAttribute<ICodeKeyTypeImpl::VALUE>();
     break;
   }
-  case ICodeNodeTypeImpl::STRING_CONSTANT: {
-    mValue = std::any_cast<std::string>(node->getAttribute(ICodeKeyTypeImpl::VALUE));
+  case ICodeNodeTypeImpl::CALL: {
+    CallExecutor call_executor(currentExecutor());
+    call_executor.execute(node);
+    mValue = call_executor.value();
     break;
   }
   case ICodeNodeTypeImpl::NEGATE: {
@@ -4,6 +4,7 @@
 #include "LoopExecutor.h"
 #include "IfExecutor.h"
 #include "SelectExecutor.h"
+#include "CallExecutor.h"
 
 StatementExecutor::StatementExecutor(const std::shared_ptr<Executor>& executor): SubExecutorBase(executor)
 {
@@ -36,6 +37,10 @@ std::shared_ptr<SubExecutorBase> StatementExecutor::execute(const std::shared_pt
     SelectExecutorOpt select_executor(currentExecutor());
     return select_executor.execute(node);
   }
+  case ICodeNodeTypeImpl::CALL: {
+    CallExecutor call_executor(currentExecutor());
+    return call_executor.execute(node);
+  }
   case ICodeNodeTypeImpl::NO_OP: {
     return nullptr;
   }
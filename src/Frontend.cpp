@@ -1,37 +1,189 @@
 #include "Frontend.h"
 
 #include <istream>
+#include <cstring>
 
-Source::Source(std::shared_ptr<std::ifstream> ifs): mStream(std::move(ifs))
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define SOURCE_USE_MMAP
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// blanks are ' ', '\t', '\n', '\v', '\f' and '\r', like isspace in the C locale
+inline bool isBlank(const char c) {
+  return c == ' ' || static_cast<unsigned char>(c - '\t') <= '\r' - '\t';
+}
+
+#if defined(__AVX2__)
+inline unsigned nonBlankMask(const char* p) {
+  const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  const __m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+  const __m256i control = _mm256_cmpeq_epi8(
+    _mm256_min_epu8(shifted, _mm256_set1_epi8('\r' - '\t')), shifted);
+  const __m256i space = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+  return ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(control, space)));
+}
+constexpr size_t simdWidth = 32;
+#elif defined(__SSE2__)
+inline unsigned nonBlankMask(const char* p) {
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  const __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+  const __m128i control = _mm_cmpeq_epi8(
+    _mm_min_epu8(shifted, _mm_set1_epi8('\r' - '\t')), shifted);
+  const __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+  return ~static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(control, space))) & 0xFFFFu;
+}
+constexpr size_t simdWidth = 16;
+#endif
+
+// return the first non-blank character in [first, last), or last
+const char* findNonBlank(const char* first, const char* last) {
+#if defined(__AVX2__) || defined(__SSE2__)
+  while (static_cast<size_t>(last - first) >= simdWidth) {
+    const unsigned mask = nonBlankMask(first);
+    if (mask != 0) {
+      return first + __builtin_ctz(mask);
+    }
+    first += simdWidth;
+  }
+#endif
+  while (first != last && isBlank(*first)) ++first;
+  return first;
+}
+
+// count the line endings in [first, last)
+size_t countLines(const char* first, const char* last) {
+  size_t count = 0;
+#if defined(__AVX2__)
+  const __m256i eol = _mm256_set1_epi8('\n');
+  for (; last - first >= 32; first += 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+    count += static_cast<size_t>(__builtin_popcount(
+      static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, eol)))));
+  }
+#elif defined(__SSE2__)
+  const __m128i eol = _mm_set1_epi8('\n');
+  for (; last - first >= 16; first += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+    count += static_cast<size_t>(__builtin_popcount(
+      static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, eol)))));
+  }
+#endif
+  for (; first != last; ++first) {
+    if (*first == '\n') ++count;
+  }
+  return count;
+}
+
+}
+
+Source::Source(std::shared_ptr<std::ifstream> ifs):
+  mMappedData(nullptr), mMappedSize(0), mOpen(false),
+  mBegin(nullptr), mEnd(nullptr), mNextLine(nullptr), mLine(nullptr), mLineSize(0)
+{
+  mLineNum = 0;
+  mCurrentPos = -2;
+  mReadOk = false;
+  if (ifs != nullptr && ifs->is_open()) {
+    readStream(*ifs);
+  }
+}
+
+Source::Source(const std::string& filename):
+  mMappedData(nullptr), mMappedSize(0), mOpen(false),
+  mBegin(nullptr), mEnd(nullptr), mNextLine(nullptr), mLine(nullptr), mLineSize(0)
 {
   mLineNum = 0;
   mCurrentPos = -2;
   mReadOk = false;
+  if (!mapFile(filename)) {
+    // fall back to reading the whole file in large blocks
+    std::ifstream ifs(filename, std::ios::in | std::ios::binary);
+    if (ifs.is_open()) {
+      readStream(ifs);
+    }
+  }
+}
+
+Source::Source(std::string_view text, int line_offset):
+  mMappedData(nullptr), mMappedSize(0), mOpen(true),
+  mBegin(text.data()), mEnd(text.data() + text.size()), mNextLine(text.data()),
+  mLine(nullptr), mLineSize(0)
+{
+  mLineNum = line_offset;
+  mCurrentPos = -2;
+  mReadOk = false;
 }
 
-char Source::currentChar()
+void Source::readStream(std::istream& is)
 {
-  if (mCurrentPos == -2 || mCurrentPos > mLine.length()) {
+  static const size_t block_size = 1 << 16;
+  size_t size = 0;
+  while (is) {
+    mBuffer.resize(size + block_size);
+    is.read(mBuffer.data() + size, block_size);
+    size += static_cast<size_t>(is.gcount());
+  }
+  mBuffer.resize(size);
+  mBegin = mBuffer.data();
+  mEnd = mBegin + size;
+  mNextLine = mBegin;
+  mOpen = true;
+}
+
+bool Source::mapFile(const std::string& filename)
+{
+#ifdef SOURCE_USE_MMAP
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st{};
+  if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+    // empty files cannot be mapped, and pipes have no size
+    ::close(fd);
+    return false;
+  }
+  void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) return false;
+  // the source is scanned from the beginning to the end
+  ::madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+  mMappedData = data;
+  mMappedSize = static_cast<size_t>(st.st_size);
+  mBegin = static_cast<const char*>(data);
+  mEnd = mBegin + mMappedSize;
+  mNextLine = mBegin;
+  mOpen = true;
+  return true;
+#else
+  return false;
+#endif
+}
+
+char Source::currentCharSlow()
+{
+  if (mCurrentPos == -2 || mCurrentPos > mLineSize) {
     // first time?
     readLine();
     return nextChar();
   } else if (!mReadOk) {
     // at the end of file?
     return std::char_traits<char>::eof();
-  } else if ((mCurrentPos == -1) || (mCurrentPos == mLine.size())) {
+  } else if ((mCurrentPos == -1) || (mCurrentPos == mLineSize)) {
     // at the end of line?
     return EOL;
   } else {
-    return mLine.at(mCurrentPos);
+    return mLine[mCurrentPos];
   }
 }
 
-char Source::nextChar()
-{
-  ++mCurrentPos;
-  return currentChar();
-}
-
 char Source::peekChar()
 {
   currentChar();
@@ -39,24 +191,97 @@ char Source::peekChar()
     return std::char_traits<char>::eof();
   }
   const int nextPos = mCurrentPos + 1;
-  if (nextPos < mLine.size()) {
-    return mLine.at(nextPos);
+  if (nextPos < mLineSize) {
+    return mLine[nextPos];
   } else {
     return EOL;
   }
 }
 
+char Source::skipBlanks()
+{
+  char current_char = currentChar();
+  while (mReadOk) {
+    if (mCurrentPos >= 0 && mCurrentPos < mLineSize) {
+      const char* p = findNonBlank(mLine + mCurrentPos, mLine + mLineSize);
+      mCurrentPos = static_cast<int>(p - mLine);
+      if (mCurrentPos < mLineSize) {
+        return *p;
+      }
+    }
+    // the end of line is also blank
+    current_char = nextChar();
+  }
+  return current_char;
+}
+
+char Source::skipTo(const char target)
+{
+  char current_char = currentChar();
+  while (mReadOk) {
+    if (mCurrentPos >= 0 && mCurrentPos < mLineSize) {
+      // memchr is vectorized in the C library
+      const auto* p = static_cast<const char*>(
+        std::memchr(mLine + mCurrentPos, target, static_cast<size_t>(mLineSize - mCurrentPos)));
+      if (p != nullptr) {
+        mCurrentPos = static_cast<int>(p - mLine);
+        return target;
+      }
+      mCurrentPos = mLineSize;
+    }
+    if (jumpTo(target)) {
+      return target;
+    }
+    current_char = nextChar();
+  }
+  return current_char;
+}
+
+bool Source::jumpTo(const char target)
+{
+  // the skipped lines have to be listed one by one
+  if (!sendMessage.empty() || mNextLine >= mEnd) return false;
+  const auto* p = static_cast<const char*>(
+    std::memchr(mNextLine, target, static_cast<size_t>(mEnd - mNextLine)));
+  if (p == nullptr) return false;
+  // find the line containing the target
+  const char* line_begin = p;
+  while (line_begin != mNextLine && *(line_begin - 1) != EOL) --line_begin;
+  mLineNum += 1 + static_cast<int>(countLines(mNextLine, line_begin));
+  mLine = line_begin;
+  const auto* eol = static_cast<const char*>(
+    std::memchr(p, EOL, static_cast<size_t>(mEnd - p)));
+  const char* line_end = (eol == nullptr) ? mEnd : eol;
+  mNextLine = (eol == nullptr) ? mEnd : eol + 1;
+  if (line_end > mLine && *(line_end - 1) == '\r') --line_end;
+  mLineSize = static_cast<int>(line_end - mLine);
+  mCurrentPos = static_cast<int>(p - mLine);
+  mReadOk = true;
+  return true;
+}
+
 void Source::readLine()
 {
-  mReadOk = std::getline(*mStream, mLine).good();
   mCurrentPos = -1;
+  mReadOk = mNextLine < mEnd;
   if (mReadOk) {
-    // not EOF or error
+    // not EOF
     ++mLineNum;
-    clear_line_ending(mLine);
-    sendMessage(mLineNum, mLine);
+    mLine = mNextLine;
+    const auto* eol = static_cast<const char*>(
+      std::memchr(mNextLine, EOL, static_cast<size_t>(mEnd - mNextLine)));
+    const char* line_end = (eol == nullptr) ? mEnd : eol;
+    mNextLine = (eol == nullptr) ? mEnd : eol + 1;
+    // remove the CR of a CRLF line ending
+    if (line_end > mLine && *(line_end - 1) == '\r') --line_end;
+    mLineSize = static_cast<int>(line_end - mLine);
+    // only build the line string if someone is listening
+    if (!sendMessage.empty()) {
+      sendMessage(mLineNum, std::string(mLine, static_cast<size_t>(mLineSize)));
+    }
   } else {
-    mLine = "";
+    mLine = nullptr;
+    mLineSize = 0;
   }
 }
 
@@ -65,11 +290,33 @@ int Source::currentPos() const
   return mCurrentPos;
 }
 
+bool Source::isOpen() const
+{
+  return mOpen;
+}
+
+std::string_view Source::text() const
+{
+  return {mBegin, static_cast<size_t>(mEnd - mBegin)};
+}
+
+void Source::readLinesUntil(const int line_num)
+{
+  while (mLineNum < line_num && mNextLine < mEnd) {
+    readLine();
+  }
+}
+
 Source::~Source()
 {
 #ifdef DEBUG_DESTRUCTOR
   std::cerr << "Destructor: " << BOOST_CURRENT_FUNCTION << std::endl;
 #endif
+#ifdef SOURCE_USE_MMAP
+  if (mMappedData != nullptr) {
+    ::munmap(mMappedData, mMappedSize);
+  }
+#endif
 }
 
 int Source::lineNum() const
@@ -11,6 +11,10 @@
 #include <cstdio>
 #include <memory>
 #include <utility>
+#include <array>
+#include <atomic>
+#include <vector>
+#include <string_view>
 #include <any>
 
 using std::unique_ptr;
@@ -19,103 +23,148 @@ using std::unique_ptr;
 class Source;
 
 // the class that represents the source program
+// the whole program text is kept in one contiguous buffer (memory-mapped
+// if possible, otherwise bulk-read from the stream), and lines are just
+// views into it
 class Source {
 public:
   // constructor from an input stream
   explicit Source(std::shared_ptr<std::ifstream> ifs);
+  // constructor from a file path (memory-mapped if possible)
+  explicit Source(const std::string& filename);
+  // constructor from a part of another source, which must outlive this one;
+  // line_offset is the number of lines before the part
+  Source(std::string_view text, int line_offset);
+  Source(const Source&) = delete;
+  Source& operator=(const Source&) = delete;
   // return the source character of the current position
   char currentChar();
   // consume the current source character and return the next one
   char nextChar();
   // return the character following the current one with consuming
   char peekChar();
+  // consume blanks (including line endings) and return the first non-blank character
+  char skipBlanks();
+  // consume characters until the target is found (not consumed) and return it,
+  // or return EOF
+  char skipTo(char target);
   int lineNum() const;
   int currentPos() const;
+  // whether the input could be opened and read
+  bool isOpen() const;
+  // the whole source text
+  std::string_view text() const;
+  // read (and send) the lines up to line_num without scanning them
+  void readLinesUntil(int line_num);
   virtual ~Source();
   boost::signals2::signal<void(int, std::string)> sendMessage;
 
 private:
+  // read the whole stream into mBuffer
+  void readStream(std::istream& is);
+  // try to map the file into memory
+  bool mapFile(const std::string& filename);
   // read the next source line
   void readLine();
+  char currentCharSlow();
+  // move directly to the next target in the following lines
+  // (only when nobody listens to the skipped lines)
+  bool jumpTo(char target);
 
 private:
   static const char EOL = '\n';
-  std::shared_ptr<std::ifstream> mStream; // input stream of the source program
-  std::string mLine;        // source line
+  std::string mBuffer;        // owns the text if it is not mapped
+  void* mMappedData;          // start of the mapping, or nullptr
+  size_t mMappedSize;
+  bool mOpen;
+  const char* mBegin;         // start of the source text
+  const char* mEnd;           // end of the source text
+  const char* mNextLine;      // start of the next unread line
+  const char* mLine;          // start of the current source line
+  int mLineSize;              // length of the current line without the line ending
   bool mReadOk;
   int mLineNum;         // current source line number
   int mCurrentPos;      // current source line position
 };
 
+inline char Source::currentChar()
+{
+  // fast path: inside the current line
+  if (mCurrentPos >= 0 && mCurrentPos < mLineSize) {
+    return mLine[mCurrentPos];
+  }
+  return currentCharSlow();
+}
+
+inline char Source::nextChar()
+{
+  ++mCurrentPos;
+  return currentChar();
+}
+
+// a token is a plain value: the scanner refills recycled tokens in place
+// instead of allocating a new one for every token it extracts
 template <typename T> class Token {
 public:
   Token();
-  explicit Token(std::weak_ptr<Source> source, bool use_default_extract = true);
-  virtual ~Token();
   [[nodiscard]] int lineNum() const;
   [[nodiscard]] int position() const;
   [[nodiscard]] const VariableValueT &value() const;
   [[nodiscard]] const std::string &text() const;
-  [[nodiscard]] virtual bool isEof() const;
-  virtual T type() const;
-  virtual std::unique_ptr<Token<T>> clone() const;
-  std::shared_ptr<Source> currentSource() const;
-protected:
-  // default method to extract only one-character tokens from the source
-  virtual void extract();
-  // Call the corresponding methods in source
-  char currentChar();
-  char nextChar();
-  char peekChar();
+  [[nodiscard]] bool isEof() const;
+  // the interned lowercase name of an identifier
+  [[nodiscard]] NameId nameId() const;
+  T type() const;
+  std::unique_ptr<Token<T>> clone() const;
+  // start a new token at the given source position,
+  // keeping the capacity of the text buffer
+  void reset(int line_num, int position);
+  void setType(T type);
+  void setValue(VariableValueT value);
+  void setEof(bool eof);
+  void setNameId(NameId name_id);
+  std::string &mutableText();
 
 protected:
-  std::weak_ptr<Source> mSource;
   std::string mText;
   VariableValueT mValue;
   int mLineNum;
   int mPosition;
   T mType;
+  bool mEof;
+  NameId mNameId;
 };
 
-template <typename T> Token<T>::Token() /*: mSource(nullptr)*/ {
+template <typename T> Token<T>::Token(): mType(), mEof(false), mNameId(invalidNameId) {
   mLineNum = -1;
   mPosition = -2;
 }
 
-template <typename T>
-Token<T>::Token(std::weak_ptr<Source> source, bool use_default_extract)
-    : mSource(source) {
-  mLineNum = currentSource()->lineNum();
-  mPosition = currentSource()->currentPos();
-  // NOTE: C++ code should call extract() explicitly in the derived class
-  if (use_default_extract) {
-    Token<T>::extract();
-  }
+template <typename T> void Token<T>::reset(int line_num, int position) {
+  mText.clear();
+  if (mValue.index() != 0) mValue = VariableValueT();
+  mLineNum = line_num;
+  mPosition = position;
+  mType = T();
+  mEof = false;
+  mNameId = invalidNameId;
 }
 
-template <typename T> Token<T>::~Token() {
-//#ifdef DEBUG_DESTRUCTOR
-//  std::cerr << "Destructor: " << BOOST_CURRENT_FUNCTION << std::endl;
-//#endif
-}
+template <typename T> void Token<T>::setType(T type) { mType = type; }
 
-template <typename T> void Token<T>::extract() {
-  mText = std::string{currentChar()};
-  mValue = VariableValueT();
-  nextChar();
-}
+template <typename T> void Token<T>::setValue(VariableValueT value) { mValue = std::move(value); }
 
-template <typename T> char Token<T>::currentChar() {
-  return currentSource()->currentChar();
-}
+template <typename T> void Token<T>::setEof(bool eof) { mEof = eof; }
 
-template <typename T> char Token<T>::nextChar() { return currentSource()->nextChar(); }
+template <typename T> void Token<T>::setNameId(NameId name_id) { mNameId = name_id; }
 
-template <typename T> char Token<T>::peekChar() { return currentSource()->peekChar(); }
+template <typename T> std::string &Token<T>::mutableText() { return mText; }
 
 template <typename T> const std::string &Token<T>::text() const { return mText; }
 
-template <typename T> bool Token<T>::isEof() const { return false; }
+template <typename T> bool Token<T>::isEof() const { return mEof; }
+
+template <typename T> NameId Token<T>::nameId() const { return mNameId; }
 
 template <typename T> T Token<T>::type() const { return mType; }
 
@@ -131,54 +180,15 @@ std::unique_ptr<Token<T>> Token<T>::clone() const {
   return result;
 }
 
-template<typename T>
-std::shared_ptr<Source> Token<T>::currentSource() const
-{
-  return mSource.lock();
-}
-
-template <typename T> class EofToken : public Token<T> {
-public:
-  EofToken();
-  explicit EofToken(std::shared_ptr<Source> source);
-  virtual void extract() override;
-  virtual ~EofToken();
-  [[nodiscard]] virtual bool isEof() const override;
-  virtual std::unique_ptr<Token<T>> clone() const override;
-};
-
-template <typename T> EofToken<T>::EofToken() {}
-
-template <typename T>
-EofToken<T>::EofToken(std::shared_ptr<Source> source)
-    : Token<T>(source, false) {
-  EofToken::extract();
-}
-
-template <typename T> void EofToken<T>::extract() {}
-
-template <typename T> EofToken<T>::~EofToken() {
-#ifdef DEBUG_DESTRUCTOR
-  std::cerr << "Destructor: " << BOOST_CURRENT_FUNCTION << std::endl;
-#endif
-}
-
-template <typename T> bool EofToken<T>::isEof() const { return true; }
-
-template <typename T>
-std::unique_ptr<Token<T>> EofToken<T>::clone() const {
-  std::unique_ptr<Token<T>> result = std::make_unique<EofToken<T>>(*this);
-  return result;
-}
-
 template <typename TokenT> class Scanner {
 public:
   Scanner();
   explicit Scanner(std::shared_ptr<Source> source);
   virtual ~Scanner();
-  std::shared_ptr<Token<TokenT>> currentToken() const;
-  virtual std::shared_ptr<Token<TokenT>> extractToken() = 0;
-  std::shared_ptr<Token<TokenT>> nextToken();
+  const std::shared_ptr<Token<TokenT>>& currentToken() const;
+  // fill the token with the next token from the source
+  virtual void extractToken(Token<TokenT>& token) = 0;
+  const std::shared_ptr<Token<TokenT>>& nextToken();
   char currentChar();
   char nextChar();
 
@@ -186,15 +196,19 @@ protected:
   std::shared_ptr<Source> mSource;
 
 private:
+  // return a token from the pool that nobody else holds
+  std::shared_ptr<Token<TokenT>> recycleToken();
   std::shared_ptr<Token<TokenT>> mCurrentToken;
+  std::vector<std::shared_ptr<Token<TokenT>>> mTokenPool;
+  size_t mPoolIndex;
 };
 
 template <typename TokenT>
-Scanner<TokenT>::Scanner() : mSource(nullptr), mCurrentToken(nullptr) {}
+Scanner<TokenT>::Scanner() : mSource(nullptr), mCurrentToken(nullptr), mPoolIndex(0) {}
 
 template <typename TokenT>
 Scanner<TokenT>::Scanner(std::shared_ptr<Source> source)
-    : mSource(std::move(source)), mCurrentToken(nullptr) {}
+    : mSource(std::move(source)), mCurrentToken(nullptr), mPoolIndex(0) {}
 
 template <typename TokenT> Scanner<TokenT>::~Scanner() {
 #ifdef DEBUG_DESTRUCTOR
@@ -203,14 +217,31 @@ template <typename TokenT> Scanner<TokenT>::~Scanner() {
 }
 
 template <typename TokenT>
-std::shared_ptr<Token<TokenT>> Scanner<TokenT>::currentToken() const {
+const std::shared_ptr<Token<TokenT>>& Scanner<TokenT>::currentToken() const {
   return mCurrentToken;
 }
 
 template <typename TokenT>
-std::shared_ptr<Token<TokenT>> Scanner<TokenT>::nextToken() {
-  mCurrentToken = extractToken();
-  return currentToken();
+const std::shared_ptr<Token<TokenT>>& Scanner<TokenT>::nextToken() {
+  auto token = recycleToken();
+  extractToken(*token);
+  mCurrentToken = std::move(token);
+  return mCurrentToken;
+}
+
+template <typename TokenT>
+std::shared_ptr<Token<TokenT>> Scanner<TokenT>::recycleToken() {
+  // parsers may keep a token (for error messages, for example),
+  // so only reuse the ones referenced by the pool alone
+  for (size_t i = 0; i < mTokenPool.size(); ++i) {
+    mPoolIndex = (mPoolIndex + 1) % mTokenPool.size();
+    if (mTokenPool[mPoolIndex].use_count() == 1) {
+      return mTokenPool[mPoolIndex];
+    }
+  }
+  mTokenPool.push_back(std::make_shared<Token<TokenT>>());
+  mPoolIndex = mTokenPool.size() - 1;
+  return mTokenPool.back();
 }
 
 template <typename TokenT> char Scanner<TokenT>::currentChar() {
@@ -221,6 +252,61 @@ template <typename TokenT> char Scanner<TokenT>::nextChar() {
   return mSource->nextChar();
 }
 
+// bounded single-producer/single-consumer lock-free ring,
+// the slots are filled and drained in place
+template <typename T, size_t Capacity> class SpscRing {
+  static_assert((Capacity & (Capacity - 1)) == 0, "the capacity should be a power of 2");
+public:
+  SpscRing();
+  // producer: return a free slot, or nullptr if the ring is full
+  T* beginPush();
+  // producer: publish the slot returned by beginPush()
+  void endPush();
+  // consumer: return the oldest published slot, or nullptr if the ring is empty
+  T* beginPop();
+  // consumer: release the slot returned by beginPop()
+  void endPop();
+
+private:
+  std::unique_ptr<std::array<T, Capacity>> mSlots;
+  // keep the indices of the two threads on different cache lines
+  alignas(64) std::atomic<size_t> mHead; // written by the producer
+  size_t mTailCache;
+  alignas(64) std::atomic<size_t> mTail; // written by the consumer
+  size_t mHeadCache;
+};
+
+template <typename T, size_t Capacity>
+SpscRing<T, Capacity>::SpscRing():
+  mSlots(std::make_unique<std::array<T, Capacity>>()),
+  mHead(0), mTailCache(0), mTail(0), mHeadCache(0) {}
+
+template <typename T, size_t Capacity> T* SpscRing<T, Capacity>::beginPush() {
+  const size_t head = mHead.load(std::memory_order_relaxed);
+  if (head - mTailCache == Capacity) {
+    mTailCache = mTail.load(std::memory_order_acquire);
+    if (head - mTailCache == Capacity) return nullptr;
+  }
+  return &(*mSlots)[head & (Capacity - 1)];
+}
+
+template <typename T, size_t Capacity> void SpscRing<T, Capacity>::endPush() {
+  mHead.store(mHead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+template <typename T, size_t Capacity> T* SpscRing<T, Capacity>::beginPop() {
+  const size_t tail = mTail.load(std::memory_order_relaxed);
+  if (tail == mHeadCache) {
+    mHeadCache = mHead.load(std::memory_order_acquire);
+    if (tail == mHeadCache) return nullptr;
+  }
+  return &(*mSlots)[tail & (Capacity - 1)];
+}
+
+template <typename T, size_t Capacity> void SpscRing<T, Capacity>::endPop() {
+  mTail.store(mTail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
 template <typename SymbolTableKeyT, typename DefinitionT,
           typename TypeFormT, typename TypeKeyT,
           typename ICodeNodeT, typename ICodeKeyT,
@@ -231,10 +317,10 @@ public:
   virtual ~Parser();
   virtual void parse() = 0;
   [[nodiscard]] virtual int errorCount() const = 0;
-  std::shared_ptr<Token<TokenT>> currentToken() const;
-  std::shared_ptr<Token<TokenT>> nextToken();
-  [[nodiscard]] std::shared_ptr<SymbolTableStackImplBase> getSymbolTableStack() const;
-  [[nodiscard]] std::shared_ptr<ScannerT> scanner() const;
+  const std::shared_ptr<Token<TokenT>>& currentToken() const;
+  const std::shared_ptr<Token<TokenT>>& nextToken();
+  [[nodiscard]] const std::shared_ptr<SymbolTableStackImplBase>& getSymbolTableStack() const;
+  [[nodiscard]] const std::shared_ptr<ScannerT>& scanner() const;
 
 protected:
   std::shared_ptr<SymbolTableStackImplBase> mSymbolTableStack;
@@ -267,7 +353,7 @@ template <typename SymbolTableKeyT, typename DefinitionT,
           typename TypeFormT, typename TypeKeyT,
           typename ICodeNodeT, typename ICodeKeyT,
           typename TokenT, typename ScannerT>
-std::shared_ptr<Token<TokenT>>
+const std::shared_ptr<Token<TokenT>>&
 Parser<SymbolTableKeyT, DefinitionT, TypeFormT, TypeKeyT, ICodeNodeT, ICodeKeyT, TokenT, ScannerT>::currentToken()
     const {
   return mScanner->currentToken();
@@ -277,7 +363,7 @@ template <typename SymbolTableKeyT, typename DefinitionT,
           typename TypeFormT, typename TypeKeyT,
           typename ICodeNodeT, typename ICodeKeyT,
           typename TokenT, typename ScannerT>
-std::shared_ptr<Token<TokenT>>
+const std::shared_ptr<Token<TokenT>>&
 Parser<SymbolTableKeyT, DefinitionT, TypeFormT, TypeKeyT, ICodeNodeT, ICodeKeyT, TokenT, ScannerT>::nextToken() {
   return mScanner->nextToken();
 }
@@ -286,7 +372,7 @@ template <typename SymbolTableKeyT, typename DefinitionT,
           typename TypeFormT, typename TypeKeyT,
           typename ICodeNodeT, typename ICodeKeyT,
           typename TokenT, typename ScannerT>
-std::shared_ptr<SymbolTableStackImplBase> Parser<SymbolTableKeyT, DefinitionT, TypeFormT, TypeKeyT, ICodeNodeT, ICodeKeyT, TokenT, ScannerT>::getSymbolTableStack() const {
+const std::shared_ptr<SymbolTableStackImplBase>& Parser<SymbolTableKeyT, DefinitionT, TypeFormT, TypeKeyT, ICodeNodeT, ICodeKeyT, TokenT, ScannerT>::getSymbolTableStack() const {
   return mSymbolTableStack;
 }
 
@@ -304,7 +390,7 @@ template <typename SymbolTableKeyT, typename DefinitionT,
           typename TypeFormT, typename TypeKeyT,
           typename ICodeNodeT, typename ICodeKeyT,
           typename TokenT, typename ScannerT>
-std::shared_ptr<ScannerT>
+const std::shared_ptr<ScannerT>&
 Parser<SymbolTableKeyT, DefinitionT, TypeFormT, TypeKeyT, ICodeNodeT, ICodeKeyT, TokenT, ScannerT>::scanner()
     const {
   return mScanner;
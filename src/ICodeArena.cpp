@@ -0,0 +1,66 @@
+#include "ICodeArena.h"
+#include "Common.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+
+ICodeArena::ICodeArena(size_t block_size):
+  mCursor(nullptr), mLimit(nullptr), mBlockSize(block_size),
+  mBytesUsed(0), mBytesReserved(0) {}
+
+ICodeArena::~ICodeArena()
+{
+#ifdef DEBUG_DESTRUCTOR
+  std::cerr << "Destructor: " << BOOST_CURRENT_FUNCTION << std::endl;
+#endif
+}
+
+void* ICodeArena::allocate(size_t size, size_t alignment)
+{
+  auto address = reinterpret_cast<std::uintptr_t>(mCursor);
+  auto aligned = (address + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+  if (mCursor == nullptr || aligned + size > reinterpret_cast<std::uintptr_t>(mLimit)) {
+    // oversized requests get a block of their own
+    const size_t block_size = std::max(mBlockSize, size + alignment);
+    mBlocks.push_back(std::make_unique_for_overwrite<std::byte[]>(block_size));
+    mCursor = mBlocks.back().get();
+    mLimit = mCursor + block_size;
+    mBytesReserved += block_size;
+    address = reinterpret_cast<std::uintptr_t>(mCursor);
+    aligned = (address + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+  }
+  mCursor += (aligned - address) + size;
+  mBytesUsed += size;
+  return reinterpret_cast<void*>(aligned);
+}
+
+size_t ICodeArena::bytesUsed() const
+{
+  return mBytesUsed;
+}
+
+size_t ICodeArena::bytesReserved() const
+{
+  return mBytesReserved;
+}
+
+std::shared_ptr<ICodeArena>& ICodeArena::currentRef()
+{
+  static std::shared_ptr<ICodeArena> s;
+  return s;
+}
+
+const std::shared_ptr<ICodeArena>& ICodeArena::current()
+{
+  return currentRef();
+}
+
+ICodeArena::Scope::Scope(std::shared_ptr<ICodeArena> arena):
+  mPrevious(std::exchange(currentRef(), std::move(arena))) {}
+
+ICodeArena::Scope::~Scope()
+{
+  currentRef() = std::move(mPrevious);
+}
@@ -0,0 +1,67 @@
+#ifndef ICODEARENA_H
+#define ICODEARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// bump allocator for the intermediate code of one routine
+// the nodes (and their shared_ptr control blocks) are placed one after
+// another in large blocks, and deallocation is a no-op. all blocks are
+// released at once when the last node of the routine is gone.
+class ICodeArena {
+public:
+  explicit ICodeArena(size_t block_size = 1 << 16);
+  ~ICodeArena();
+  ICodeArena(const ICodeArena&) = delete;
+  ICodeArena& operator=(const ICodeArena&) = delete;
+  void* allocate(size_t size, size_t alignment);
+  // bytes handed out to the nodes
+  [[nodiscard]] size_t bytesUsed() const;
+  // bytes reserved from the heap
+  [[nodiscard]] size_t bytesReserved() const;
+  // the arena used by createICodeNode, or nullptr for the heap
+  // not thread-safe: only the thread running the parser should create nodes.
+  static const std::shared_ptr<ICodeArena>& current();
+  // make an arena current until the end of the scope
+  class Scope {
+  public:
+    explicit Scope(std::shared_ptr<ICodeArena> arena);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  private:
+    std::shared_ptr<ICodeArena> mPrevious;
+  };
+private:
+  static std::shared_ptr<ICodeArena>& currentRef();
+  std::vector<std::unique_ptr<std::byte[]>> mBlocks;
+  std::byte* mCursor;
+  std::byte* mLimit;
+  size_t mBlockSize;
+  size_t mBytesUsed;
+  size_t mBytesReserved;
+};
+
+// allocator for std::allocate_shared
+// every copy keeps the arena alive, including the one stored in the
+// control block, so a node may safely outlive its ICode.
+template <typename T>
+class ICodeArenaAllocator {
+public:
+  using value_type = T;
+  explicit ICodeArenaAllocator(std::shared_ptr<ICodeArena> arena): mArena(std::move(arena)) {}
+  template <typename U>
+  ICodeArenaAllocator(const ICodeArenaAllocator<U>& other): mArena(other.arena()) {}
+  T* allocate(size_t n) {
+    return static_cast<T*>(mArena->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T*, size_t) noexcept {}
+  [[nodiscard]] const std::shared_ptr<ICodeArena>& arena() const { return mArena; }
+  template <typename U>
+  bool operator==(const ICodeArenaAllocator<U>& other) const { return mArena == other.arena(); }
+private:
+  std::shared_ptr<ICodeArena> mArena;
+};
+
+#endif // ICODEARENA_H
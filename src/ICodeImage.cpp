@@ -0,0 +1,772 @@
+#include "ICodeImage.h"
+#include "IntermediateImpl.h"
+#include "Predefined.h"
+#include "Frontend.h"
+
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include <fmt/format.h>
+
+namespace {
+
+constexpr char imageMagic[8] = {'P', 'A', 'S', 'I', 'M', 'G', '\0', '\0'};
+// bump the version whenever a record layout changes
+constexpr std::uint32_t imageVersion = 2;
+constexpr std::uint32_t none = static_cast<std::uint32_t>(-1);
+
+// a VariableValueT, the tag is the index of the alternative
+struct ValueRecord {
+  std::uint32_t tag;
+  std::uint32_t padding;
+  // bool, integer, bits of the float, string index or error code
+  std::uint64_t bits;
+};
+
+struct StringRecord {
+  std::uint32_t offset;
+  std::uint32_t size;
+};
+
+// the entries of a symbol table are contiguous in the entry section
+struct SymbolTableRecord {
+  std::int32_t nestingLevel;
+  std::uint32_t firstEntry;
+  std::uint32_t entryCount;
+  std::int32_t slotCount;
+};
+
+enum EntryFlags: std::uint32_t {
+  HAS_CONSTANT_VALUE = 1u << 0,
+  HAS_ROUTINE_CODE = 1u << 1,
+  HAS_ROUTINE_SYMTAB = 1u << 2,
+  HAS_ROUTINE_ICODE = 1u << 3,
+  HAS_ROUTINE_PARMS = 1u << 4,
+  HAS_ROUTINE_ROUTINES = 1u << 5
+};
+
+struct EntryRecord {
+  std::uint32_t name;
+  // index in Predefined::entries(), or none
+  std::uint32_t predefined;
+  std::uint32_t definition;
+  std::uint32_t typeSpec;
+  std::uint32_t firstLine;
+  std::uint32_t lineCount;
+  std::uint32_t flags;
+  std::uint32_t routineCode;
+  std::uint32_t routineSymtab;
+  // the nodes of the routine's ICode are [icodeRoot, icodeEnd)
+  std::uint32_t icodeRoot;
+  std::uint32_t icodeEnd;
+  std::uint32_t firstParm;
+  std::uint32_t parmCount;
+  std::uint32_t firstRoutine;
+  std::uint32_t routineCount;
+  std::int32_t slot;
+  ValueRecord constantValue;
+};
+
+enum TypeFlags: std::uint32_t {
+  HAS_ENUMERATION_CONSTANTS = 1u << 0,
+  HAS_SUBRANGE_BASE_TYPE = 1u << 1,
+  HAS_SUBRANGE_MIN_VALUE = 1u << 2,
+  HAS_SUBRANGE_MAX_VALUE = 1u << 3,
+  HAS_ARRAY_INDEX_TYPE = 1u << 4,
+  HAS_ARRAY_ELEMENT_TYPE = 1u << 5,
+  HAS_ARRAY_ELEMENT_COUNT = 1u << 6,
+  HAS_RECORD_SYMTAB = 1u << 7
+};
+
+struct TypeRecord {
+  std::uint32_t form;
+  // index in Predefined::types(), or none
+  std::uint32_t predefined;
+  std::uint32_t identifier;
+  std::uint32_t flags;
+  std::uint32_t firstConstant;
+  std::uint32_t constantCount;
+  std::uint32_t baseType;
+  std::uint32_t indexType;
+  std::uint32_t elementType;
+  std::uint32_t recordSymtab;
+  std::int64_t elementCount;
+  ValueRecord minValue;
+  ValueRecord maxValue;
+};
+
+// the children of a node are contiguous in the node section
+struct NodeRecord {
+  std::uint32_t type;
+  // one bit per ICodeKeyTypeImpl
+  std::uint32_t flags;
+  std::uint32_t id;
+  std::uint32_t typeSpec;
+  std::int32_t line;
+  std::uint32_t firstChild;
+  std::uint32_t childCount;
+  std::uint32_t padding;
+  ValueRecord value;
+};
+
+// the sections follow the header in this order, each aligned to 8 bytes
+enum Section {
+  STRINGS, CHARS, SYMTABS, ENTRIES, TYPES, NODES, LINES, REFS, SECTION_COUNT
+};
+
+constexpr size_t sectionElementSize[SECTION_COUNT] = {
+  sizeof(StringRecord), sizeof(char), sizeof(SymbolTableRecord), sizeof(EntryRecord),
+  sizeof(TypeRecord), sizeof(NodeRecord), sizeof(std::int32_t), sizeof(std::uint32_t)
+};
+
+struct ImageHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::int32_t lineCount;
+  std::uint64_t sourceSize;
+  std::uint64_t sourceHash;
+  std::uint32_t programId;
+  std::uint32_t padding;
+  std::uint64_t counts[SECTION_COUNT];
+};
+
+constexpr size_t align8(size_t n) {
+  return (n + 7) & ~static_cast<size_t>(7);
+}
+
+constexpr std::uint32_t keyBit(ICodeKeyTypeImpl key) {
+  return 1u << static_cast<unsigned>(key);
+}
+
+class ImageWriter {
+public:
+  // collect everything reachable from the global symbol table
+  bool collect(const std::shared_ptr<SymbolTableStackImplBase>& symbol_table_stack);
+  std::string serialize(std::string_view source_text, int line_count,
+                        const std::shared_ptr<SymbolTableEntryImplBase>& program_id);
+private:
+  void addSymbolTable(const std::shared_ptr<SymbolTableImplBase>& symbol_table);
+  void addType(const std::shared_ptr<TypeSpecImplBase>& type_spec);
+  void addICode(size_t entry_index);
+  std::uint32_t stringRef(const std::string& s);
+  std::uint32_t entryRef(const std::shared_ptr<SymbolTableEntryImplBase>& entry);
+  std::uint32_t typeRef(const std::shared_ptr<TypeSpecImplBase>& type_spec);
+  std::uint32_t symbolTableRef(const std::shared_ptr<SymbolTableImplBase>& symbol_table);
+  ValueRecord valueRecord(const VariableValueT& value);
+  EntryRecord entryRecord(size_t index);
+  TypeRecord typeRecord(size_t index);
+  NodeRecord nodeRecord(size_t index);
+  std::vector<std::shared_ptr<SymbolTableImplBase>> mSymbolTables;
+  std::vector<std::shared_ptr<SymbolTableEntryImplBase>> mEntries;
+  std::vector<std::shared_ptr<TypeSpecImplBase>> mTypes;
+  std::vector<std::shared_ptr<ICodeNodeImplBase>> mNodes;
+  std::vector<std::uint32_t> mFirstChild;
+  // node range of the ICode of each routine entry
+  std::unordered_map<size_t, std::pair<std::uint32_t, std::uint32_t>> mICodeRanges;
+  std::unordered_map<const void*, std::uint32_t> mSymbolTableIds;
+  std::unordered_map<const void*, std::uint32_t> mEntryIds;
+  std::unordered_map<const void*, std::uint32_t> mTypeIds;
+  std::unordered_map<const void*, std::uint32_t> mPredefinedEntries;
+  std::unordered_map<const void*, std::uint32_t> mPredefinedTypes;
+  std::vector<StringRecord> mStrings;
+  std::string mChars;
+  std::unordered_map<std::string, std::uint32_t> mStringIds;
+  std::vector<std::int32_t> mLines;
+  std::vector<std::uint32_t> mRefs;
+  // set if something refers to an object outside of the collected graph
+  bool mIncomplete = false;
+};
+
+bool ImageWriter::collect(const std::shared_ptr<SymbolTableStackImplBase>& symbol_table_stack)
+{
+  const auto& predefined = Predefined::instance();
+  const auto predefined_entries = predefined.entries();
+  for (std::uint32_t i = 0; i < predefined_entries.size(); ++i) {
+    mPredefinedEntries[predefined_entries[i].get()] = i;
+  }
+  const auto predefined_types = predefined.types();
+  for (std::uint32_t i = 0; i < predefined_types.size(); ++i) {
+    mPredefinedTypes[predefined_types[i].get()] = i;
+  }
+  if (symbol_table_stack->currentNestingLevel() != 0) return false;
+  addSymbolTable(symbol_table_stack->localSymbolTable());
+  // the types of the ICode may add record symbol tables, so repeat until nothing is new
+  size_t next_symbol_table = 0;
+  size_t next_routine = 0;
+  while (next_symbol_table < mSymbolTables.size() || next_routine < mEntries.size()) {
+    for (; next_symbol_table < mSymbolTables.size(); ++next_symbol_table) {
+      const size_t first = mEntries.size();
+      for (const auto& entry: mSymbolTables[next_symbol_table]->sortedEntries()) {
+        if (mEntryIds.contains(entry.get())) return false;
+        mEntryIds[entry.get()] = static_cast<std::uint32_t>(mEntries.size());
+        mEntries.push_back(entry);
+      }
+      for (size_t i = first; i < mEntries.size(); ++i) {
+        if (mPredefinedEntries.contains(mEntries[i].get())) continue;
+        addType(mEntries[i]->getTypeSpec());
+        const auto routine_symtab = mEntries[i]->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_SYMTAB>();
+        if (routine_symtab) addSymbolTable(routine_symtab.value());
+      }
+    }
+    for (; next_routine < mEntries.size(); ++next_routine) {
+      if (mPredefinedEntries.contains(mEntries[next_routine].get())) continue;
+      addICode(next_routine);
+    }
+  }
+  return true;
+}
+
+void ImageWriter::addSymbolTable(const std::shared_ptr<SymbolTableImplBase>& symbol_table)
+{
+  if (symbol_table == nullptr || mSymbolTableIds.contains(symbol_table.get())) return;
+  mSymbolTableIds[symbol_table.get()] = static_cast<std::uint32_t>(mSymbolTables.size());
+  mSymbolTables.push_back(symbol_table);
+}
+
+void ImageWriter::addType(const std::shared_ptr<TypeSpecImplBase>& type_spec)
+{
+  if (type_spec == nullptr || mTypeIds.contains(type_spec.get())) return;
+  mTypeIds[type_spec.get()] = static_cast<std::uint32_t>(mTypes.size());
+  mTypes.push_back(type_spec);
+  if (mPredefinedTypes.contains(type_spec.get())) return;
+  if (const auto t = typeAttribute<TypeKeyImpl::SUBRANGE_BASE_TYPE>(*type_spec)) addType(t.value());
+  if (const auto t = typeAttribute<TypeKeyImpl::ARRAY_INDEX_TYPE>(*type_spec)) addType(t.value());
+  if (const auto t = typeAttribute<TypeKeyImpl::ARRAY_ELEMENT_TYPE>(*type_spec)) addType(t.value());
+  if (const auto t = typeAttribute<TypeKeyImpl::RECORD_SYMTAB>(*type_spec)) addSymbolTable(t.value());
+}
+
+void ImageWriter::addICode(size_t entry_index)
+{
+  const auto icode = mEntries[entry_index]->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_ICODE>();
+  if (!icode || icode.value() == nullptr || icode.value()->getRoot() == nullptr) return;
+  // breadth first, so that the children of each node are contiguous
+  const auto root = static_cast<std::uint32_t>(mNodes.size());
+  mNodes.push_back(icode.value()->getRoot());
+  for (size_t i = root; i < mNodes.size(); ++i) {
+    const auto node = mNodes[i];
+    mFirstChild.push_back(static_cast<std::uint32_t>(mNodes.size()));
+    for (auto it = node->childrenBegin(); it != node->childrenEnd(); ++it) {
+      if (*it == nullptr) {
+        mIncomplete = true;
+        continue;
+      }
+      mNodes.push_back(*it);
+    }
+    addType(node->getTypeSpec());
+  }
+  mICodeRanges[entry_index] = {root, static_cast<std::uint32_t>(mNodes.size())};
+}
+
+std::uint32_t ImageWriter::stringRef(const std::string& s)
+{
+  const auto search = mStringIds.find(s);
+  if (search != mStringIds.end()) return search->second;
+  const auto id = static_cast<std::uint32_t>(mStrings.size());
+  mStrings.push_back({static_cast<std::uint32_t>(mChars.size()), static_cast<std::uint32_t>(s.size())});
+  mChars += s;
+  mStringIds.emplace(s, id);
+  return id;
+}
+
+std::uint32_t ImageWriter::entryRef(const std::shared_ptr<SymbolTableEntryImplBase>& entry)
+{
+  if (entry == nullptr) return none;
+  const auto search = mEntryIds.find(entry.get());
+  if (search == mEntryIds.end()) {
+    mIncomplete = true;
+    return none;
+  }
+  return search->second;
+}
+
+std::uint32_t ImageWriter::typeRef(const std::shared_ptr<TypeSpecImplBase>& type_spec)
+{
+  if (type_spec == nullptr) return none;
+  const auto search = mTypeIds.find(type_spec.get());
+  if (search == mTypeIds.end()) {
+    mIncomplete = true;
+    return none;
+  }
+  return search->second;
+}
+
+std::uint32_t ImageWriter::symbolTableRef(const std::shared_ptr<SymbolTableImplBase>& symbol_table)
+{
+  if (symbol_table == nullptr) return none;
+  const auto search = mSymbolTableIds.find(symbol_table.get());
+  if (search == mSymbolTableIds.end()) {
+    mIncomplete = true;
+    return none;
+  }
+  return search->second;
+}
+
+ValueRecord ImageWriter::valueRecord(const VariableValueT& value)
+{
+  ValueRecord result{static_cast<std::uint32_t>(value.index()), 0, 0};
+  std::visit(overloaded{
+    [](const std::monostate&){},
+    [&result](const bool x){result.bits = x ? 1 : 0;},
+    [&result](const PascalInteger x){result.bits = static_cast<std::uint64_t>(x);},
+    [&result](const PascalFloat x){result.bits = std::bit_cast<std::uint64_t>(static_cast<double>(x));},
+    [&result, this](const std::string& x){result.bits = stringRef(x);},
+    [&result](const PascalErrorCode x){result.bits = static_cast<std::uint64_t>(x);}
+  }, value);
+  return result;
+}
+
+EntryRecord ImageWriter::entryRecord(size_t index)
+{
+  const auto& entry = mEntries[index];
+  EntryRecord r{};
+  r.name = stringRef(entry->name());
+  const auto predefined = mPredefinedEntries.find(entry.get());
+  r.predefined = (predefined == mPredefinedEntries.end()) ? none : predefined->second;
+  r.definition = static_cast<std::uint32_t>(entry->getDefinition());
+  r.firstLine = static_cast<std::uint32_t>(mLines.size());
+  for (const int line: entry->lineNumbers()) mLines.push_back(line);
+  r.lineCount = static_cast<std::uint32_t>(mLines.size()) - r.firstLine;
+  r.typeSpec = none;
+  r.routineSymtab = none;
+  r.icodeRoot = none;
+  r.icodeEnd = none;
+  r.slot = entry->slot();
+  // the attributes of the predefined identifiers are set up by Predefined
+  if (r.predefined != none) return r;
+  r.typeSpec = typeRef(entry->getTypeSpec());
+  if (const auto v = entry->getAttribute<SymbolTableKeyTypeImpl::CONSTANT_VALUE>()) {
+    r.flags |= HAS_CONSTANT_VALUE;
+    r.constantValue = valueRecord(v.value());
+  }
+  if (const auto v = entry->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_CODE>()) {
+    r.flags |= HAS_ROUTINE_CODE;
+    r.routineCode = static_cast<std::uint32_t>(v.value());
+  }
+  if (const auto v = entry->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_SYMTAB>()) {
+    r.flags |= HAS_ROUTINE_SYMTAB;
+    r.routineSymtab = symbolTableRef(v.value());
+  }
+  if (const auto v = entry->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_ICODE>()) {
+    r.flags |= HAS_ROUTINE_ICODE;
+    const auto range = mICodeRanges.find(index);
+    if (range != mICodeRanges.end()) {
+      r.icodeRoot = range->second.first;
+      r.icodeEnd = range->second.second;
+    }
+  }
+  if (const auto v = entry->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_PARMS>()) {
+    r.flags |= HAS_ROUTINE_PARMS;
+    r.firstParm = static_cast<std::uint32_t>(mRefs.size());
+    for (const auto& parm: v.value()) mRefs.push_back(entryRef(parm));
+    r.parmCount = static_cast<std::uint32_t>(mRefs.size()) - r.firstParm;
+  }
+  if (const auto v = entry->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_ROUTINES>()) {
+    r.flags |= HAS_ROUTINE_ROUTINES;
+    r.firstRoutine = static_cast<std::uint32_t>(mRefs.size());
+    for (const auto& routine: v.value()) mRefs.push_back(entryRef(routine));
+    r.routineCount = static_cast<std::uint32_t>(mRefs.size()) - r.firstRoutine;
+  }
+  return r;
+}
+
+TypeRecord ImageWriter::typeRecord(size_t index)
+{
+  const auto& type_spec = mTypes[index];
+  TypeRecord r{};
+  r.form = static_cast<std::uint32_t>(type_spec->form());
+  const auto predefined = mPredefinedTypes.find(type_spec.get());
+  r.predefined = (predefined == mPredefinedTypes.end()) ? none : predefined->second;
+  r.identifier = none;
+  r.baseType = none;
+  r.indexType = none;
+  r.elementType = none;
+  r.recordSymtab = none;
+  if (r.predefined != none) return r;
+  r.identifier = entryRef(type_spec->getIdentifier());
+  if (const auto v = typeAttribute<TypeKeyImpl::ENUMERATION_CONSTANTS>(*type_spec)) {
+    r.flags |= HAS_ENUMERATION_CONSTANTS;
+    r.firstConstant = static_cast<std::uint32_t>(mRefs.size());
+    for (const auto& constant: v.value()) mRefs.push_back(entryRef(constant.lock()));
+    r.constantCount = static_cast<std::uint32_t>(mRefs.size()) - r.firstConstant;
+  }
+  if (const auto v = typeAttribute<TypeKeyImpl::SUBRANGE_BASE_TYPE>(*type_spec)) {
+    r.flags |= HAS_SUBRANGE_BASE_TYPE;
+    r.baseType = typeRef(v.value());
+  }
+  if (const auto v = typeAttribute<TypeKeyImpl::SUBRANGE_MIN_VALUE>(*type_spec)) {
+    r.flags |= HAS_SUBRANGE_MIN_VALUE;
+    r.minValue = valueRecord(v.value());
+  }
+  if (const auto v = typeAttribute<TypeKeyImpl::SUBRANGE_MAX_VALUE>(*type_spec)) {
+    r.flags |= HAS_SUBRANGE_MAX_VALUE;
+    r.maxValue = valueRecord(v.value());
+  }
+  if (const auto v = typeAttribute<TypeKeyImpl::ARRAY_INDEX_TYPE>(*type_spec)) {
+    r.flags |= HAS_ARRAY_INDEX_TYPE;
+    r.indexType = typeRef(v.value());
+  }
+  if (const auto v = typeAttribute<TypeKeyImpl::ARRAY_ELEMENT_TYPE>(*type_spec)) {
+    r.flags |= HAS_ARRAY_ELEMENT_TYPE;
+    r.elementType = typeRef(v.value());
+  }
+  if (const auto v = typeAttribute<TypeKeyImpl::ARRAY_ELEMENT_COUNT>(*type_spec)) {
+    r.flags |= HAS_ARRAY_ELEMENT_COUNT;
+    r.elementCount = v.value();
+  }
+  if (const auto v = typeAttribute<TypeKeyImpl::RECORD_SYMTAB>(*type_spec)) {
+    r.flags |= HAS_RECORD_SYMTAB;
+    r.recordSymtab = symbolTableRef(v.value());
+  }
+  return r;
+}
+
+NodeRecord ImageWriter::nodeRecord(size_t index)
+{
+  const auto& node = mNodes[index];
+  NodeRecord r{};
+  r.type = static_cast<std::uint32_t>(node->type());
+  r.id = none;
+  if (node->hasAttribute(ICodeKeyTypeImpl::LINE)) {
+    r.flags |= keyBit(ICodeKeyTypeImpl::LINE);
+    r.line = node->getAttribute<ICodeKeyTypeImpl::LINE>();
+  }
+  if (node->hasAttribute(ICodeKeyTypeImpl::ID)) {
+    r.flags |= keyBit(ICodeKeyTypeImpl::ID);
+    r.id = entryRef(node->getAttribute<ICodeKeyTypeImpl::ID>());
+  }
+  if (node->hasAttribute(ICodeKeyTypeImpl::VALUE)) {
+    r.flags |= keyBit(ICodeKeyTypeImpl::VALUE);
+    r.value = valueRecord(node->getAttribute<ICodeKeyTypeImpl::VALUE>());
+  }
+  r.typeSpec = typeRef(node->getTypeSpec());
+  r.firstChild = mFirstChild[index];
+  r.childCount = static_cast<std::uint32_t>(node->numChildren());
+  return r;
+}
+
+template <typename T>
+void appendSection(std::string& buffer, const std::vector<T>& records) {
+  buffer.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+  buffer.resize(align8(buffer.size()), '\0');
+}
+
+std::string ImageWriter::serialize(std::string_view source_text, int line_count,
+                                   const std::shared_ptr<SymbolTableEntryImplBase>& program_id)
+{
+  std::vector<SymbolTableRecord> symbol_tables;
+  symbol_tables.reserve(mSymbolTables.size());
+  std::uint32_t first_entry = 0;
+  for (const auto& symbol_table: mSymbolTables) {
+    // the entries were collected symbol table by symbol table
+    const auto count = static_cast<std::uint32_t>(symbol_table->sortedEntries().size());
+    symbol_tables.push_back({symbol_table->nestingLevel(), first_entry, count, symbol_table->slotCount()});
+    first_entry += count;
+  }
+  std::vector<EntryRecord> entries;
+  entries.reserve(mEntries.size());
+  for (size_t i = 0; i < mEntries.size(); ++i) entries.push_back(entryRecord(i));
+  std::vector<TypeRecord> types;
+  types.reserve(mTypes.size());
+  for (size_t i = 0; i < mTypes.size(); ++i) types.push_back(typeRecord(i));
+  std::vector<NodeRecord> nodes;
+  nodes.reserve(mNodes.size());
+  for (size_t i = 0; i < mNodes.size(); ++i) nodes.push_back(nodeRecord(i));
+  ImageHeader header{};
+  std::memcpy(header.magic, imageMagic, sizeof(imageMagic));
+  header.version = imageVersion;
+  header.lineCount = line_count;
+  header.sourceSize = source_text.size();
+  header.sourceHash = ICodeImage::hash(source_text);
+  header.programId = entryRef(program_id);
+  if (mIncomplete || header.programId == none) return {};
+  header.counts[STRINGS] = mStrings.size();
+  header.counts[CHARS] = mChars.size();
+  header.counts[SYMTABS] = symbol_tables.size();
+  header.counts[ENTRIES] = entries.size();
+  header.counts[TYPES] = types.size();
+  header.counts[NODES] = nodes.size();
+  header.counts[LINES] = mLines.size();
+  header.counts[REFS] = mRefs.size();
+  std::string buffer(reinterpret_cast<const char*>(&header), sizeof(header));
+  buffer.resize(align8(buffer.size()), '\0');
+  appendSection(buffer, mStrings);
+  buffer += mChars;
+  buffer.resize(align8(buffer.size()), '\0');
+  appendSection(buffer, symbol_tables);
+  appendSection(buffer, entries);
+  appendSection(buffer, types);
+  appendSection(buffer, nodes);
+  appendSection(buffer, mLines);
+  appendSection(buffer, mRefs);
+  return buffer;
+}
+
+// read-only view of the sections of an image
+class ImageReader {
+public:
+  explicit ImageReader(std::string_view data);
+  [[nodiscard]] const ImageHeader& header() const { return mHeader; }
+  template <typename T>
+  T record(Section section, std::uint64_t index) const {
+    check(index < mHeader.counts[section]);
+    T result;
+    std::memcpy(&result, mData.data() + mOffsets[section] + index * sizeof(T), sizeof(T));
+    return result;
+  }
+  [[nodiscard]] std::string_view string(std::uint32_t index) const;
+  [[nodiscard]] VariableValueT value(const ValueRecord& r) const;
+  static void check(bool condition) {
+    if (!condition) throw std::runtime_error("corrupted ICode image");
+  }
+private:
+  std::string_view mData;
+  ImageHeader mHeader;
+  size_t mOffsets[SECTION_COUNT];
+};
+
+ImageReader::ImageReader(std::string_view data): mData(data), mHeader{}, mOffsets{}
+{
+  check(data.size() >= sizeof(ImageHeader));
+  std::memcpy(&mHeader, data.data(), sizeof(ImageHeader));
+  check(std::memcmp(mHeader.magic, imageMagic, sizeof(imageMagic)) == 0);
+  check(mHeader.version == imageVersion);
+  size_t offset = align8(sizeof(ImageHeader));
+  for (int i = 0; i < SECTION_COUNT; ++i) {
+    mOffsets[i] = offset;
+    check(mHeader.counts[i] <= data.size());
+    offset = align8(offset + mHeader.counts[i] * sectionElementSize[i]);
+    check(offset <= data.size());
+  }
+}
+
+std::string_view ImageReader::string(std::uint32_t index) const
+{
+  const auto r = record<StringRecord>(STRINGS, index);
+  check(static_cast<std::uint64_t>(r.offset) + r.size <= mHeader.counts[CHARS]);
+  return mData.substr(mOffsets[CHARS] + r.offset, r.size);
+}
+
+VariableValueT ImageReader::value(const ValueRecord& r) const
+{
+  switch (r.tag) {
+    case 0: return std::monostate{};
+    case 1: return r.bits != 0;
+    case 2: return static_cast<PascalInteger>(r.bits);
+    case 3: return static_cast<PascalFloat>(std::bit_cast<double>(r.bits));
+    case 4: return std::string(string(static_cast<std::uint32_t>(r.bits)));
+    case 5: return static_cast<PascalErrorCode>(r.bits);
+    default: check(false);
+  }
+  return std::monostate{};
+}
+
+std::shared_ptr<SymbolTableStackImplBase> loadImage(const ImageReader& image)
+{
+  const auto& header = image.header();
+  std::shared_ptr<SymbolTableStackImplBase> symbol_table_stack = createSymbolTableStack();
+  const auto& predefined = Predefined::instance(symbol_table_stack);
+  const auto predefined_entries = predefined.entries();
+  const auto predefined_types = predefined.types();
+  // create the objects
+  std::vector<std::shared_ptr<SymbolTableImplBase>> symbol_tables(header.counts[SYMTABS]);
+  std::vector<std::shared_ptr<SymbolTableEntryImplBase>> entries(header.counts[ENTRIES]);
+  std::vector<std::shared_ptr<TypeSpecImplBase>> types(header.counts[TYPES]);
+  std::vector<std::shared_ptr<ICodeNodeImplBase>> nodes(header.counts[NODES]);
+  ImageReader::check(!symbol_tables.empty());
+  for (std::uint32_t i = 0; i < symbol_tables.size(); ++i) {
+    const auto r = image.record<SymbolTableRecord>(SYMTABS, i);
+    ImageReader::check(static_cast<std::uint64_t>(r.firstEntry) + r.entryCount <= entries.size());
+    // the first one is the global symbol table
+    symbol_tables[i] = (i == 0) ? symbol_table_stack->localSymbolTable()
+                                : std::shared_ptr(createSymbolTable(r.nestingLevel));
+    // restore the size of the activation record
+    while (symbol_tables[i]->slotCount() < r.slotCount) symbol_tables[i]->allocateSlot();
+    for (std::uint32_t j = r.firstEntry; j < r.firstEntry + r.entryCount; ++j) {
+      const auto e = image.record<EntryRecord>(ENTRIES, j);
+      if (e.predefined != none) {
+        ImageReader::check(e.predefined < predefined_entries.size());
+        entries[j] = predefined_entries[e.predefined];
+      } else {
+        entries[j] = symbol_tables[i]->enter(NameTable::instance().intern(image.string(e.name)));
+        // before any ICode refers to the entry, see AttributeSlots<ICodeKeyTypeImpl>
+        entries[j]->setDefinition(static_cast<DefinitionImpl>(e.definition));
+        entries[j]->setSlot(e.slot);
+      }
+    }
+  }
+  for (std::uint32_t i = 0; i < types.size(); ++i) {
+    const auto r = image.record<TypeRecord>(TYPES, i);
+    if (r.predefined != none) {
+      ImageReader::check(r.predefined < predefined_types.size());
+      types[i] = predefined_types[r.predefined];
+    } else {
+      types[i] = createType(static_cast<TypeFormImpl>(r.form));
+    }
+  }
+  const auto entry = [&](std::uint32_t index) -> std::shared_ptr<SymbolTableEntryImplBase> {
+    if (index == none) return nullptr;
+    ImageReader::check(index < entries.size() && entries[index] != nullptr);
+    return entries[index];
+  };
+  const auto type = [&](std::uint32_t index) -> std::shared_ptr<TypeSpecImplBase> {
+    if (index == none) return nullptr;
+    ImageReader::check(index < types.size());
+    return types[index];
+  };
+  const auto symbol_table = [&](std::uint32_t index) -> std::shared_ptr<SymbolTableImplBase> {
+    if (index == none) return nullptr;
+    ImageReader::check(index < symbol_tables.size());
+    return symbol_tables[index];
+  };
+  const auto entry_list = [&](std::uint32_t first, std::uint32_t count) {
+    std::vector<std::shared_ptr<SymbolTableEntryImplBase>> result;
+    result.reserve(count);
+    for (std::uint32_t i = first; i < first + count; ++i) {
+      result.push_back(entry(image.record<std::uint32_t>(REFS, i)));
+    }
+    return result;
+  };
+  // fill in the types
+  for (std::uint32_t i = 0; i < types.size(); ++i) {
+    const auto r = image.record<TypeRecord>(TYPES, i);
+    if (r.predefined != none) continue;
+    auto& t = types[i];
+    if (r.identifier != none) t->setIdentifier(entry(r.identifier));
+    if (r.flags & HAS_ENUMERATION_CONSTANTS) {
+      const auto constants = entry_list(r.firstConstant, r.constantCount);
+      t->setAttribute<TypeKeyImpl::ENUMERATION_CONSTANTS>(
+        std::vector<std::weak_ptr<SymbolTableEntryImplBase>>(constants.begin(), constants.end()));
+    }
+    if (r.flags & HAS_SUBRANGE_BASE_TYPE) t->setAttribute<TypeKeyImpl::SUBRANGE_BASE_TYPE>(type(r.baseType));
+    if (r.flags & HAS_SUBRANGE_MIN_VALUE) t->setAttribute<TypeKeyImpl::SUBRANGE_MIN_VALUE>(image.value(r.minValue));
+    if (r.flags & HAS_SUBRANGE_MAX_VALUE) t->setAttribute<TypeKeyImpl::SUBRANGE_MAX_VALUE>(image.value(r.maxValue));
+    if (r.flags & HAS_ARRAY_INDEX_TYPE) t->setAttribute<TypeKeyImpl::ARRAY_INDEX_TYPE>(type(r.indexType));
+    if (r.flags & HAS_ARRAY_ELEMENT_TYPE) t->setAttribute<TypeKeyImpl::ARRAY_ELEMENT_TYPE>(type(r.elementType));
+    if (r.flags & HAS_ARRAY_ELEMENT_COUNT) t->setAttribute<TypeKeyImpl::ARRAY_ELEMENT_COUNT>(r.elementCount);
+    if (r.flags & HAS_RECORD_SYMTAB) t->setAttribute<TypeKeyImpl::RECORD_SYMTAB>(symbol_table(r.recordSymtab));
+  }
+  // fill in the entries and build the ICode of the routines
+  for (std::uint32_t i = 0; i < entries.size(); ++i) {
+    const auto r = image.record<EntryRecord>(ENTRIES, i);
+    auto& e = entries[i];
+    for (std::uint32_t j = r.firstLine; j < r.firstLine + r.lineCount; ++j) {
+      e->appendLineNumber(image.record<std::int32_t>(LINES, j));
+    }
+    if (r.predefined != none) continue;
+    e->setTypeSpec(type(r.typeSpec));
+    if (r.flags & HAS_CONSTANT_VALUE) e->setAttribute<SymbolTableKeyTypeImpl::CONSTANT_VALUE>(image.value(r.constantValue));
+    if (r.flags & HAS_ROUTINE_CODE) e->setAttribute<SymbolTableKeyTypeImpl::ROUTINE_CODE>(static_cast<RoutineCodeImpl>(r.routineCode));
+    if (r.flags & HAS_ROUTINE_SYMTAB) e->setAttribute<SymbolTableKeyTypeImpl::ROUTINE_SYMTAB>(symbol_table(r.routineSymtab));
+    if (r.flags & HAS_ROUTINE_PARMS) e->setAttribute<SymbolTableKeyTypeImpl::ROUTINE_PARMS>(entry_list(r.firstParm, r.parmCount));
+    if (r.flags & HAS_ROUTINE_ROUTINES) e->setAttribute<SymbolTableKeyTypeImpl::ROUTINE_ROUTINES>(entry_list(r.firstRoutine, r.routineCount));
+    if (r.flags & HAS_ROUTINE_ICODE) {
+      auto icode = std::shared_ptr<ICodeImplBase>(createICode());
+      if (r.icodeRoot != none) {
+        ImageReader::check(r.icodeRoot < r.icodeEnd && r.icodeEnd <= nodes.size());
+        ICodeArena::Scope arena_scope(icode->arena());
+        for (std::uint32_t j = r.icodeRoot; j < r.icodeEnd; ++j) {
+          const auto n = image.record<NodeRecord>(NODES, j);
+          auto node = createICodeNode(static_cast<ICodeNodeTypeImpl>(n.type));
+          if (n.flags & keyBit(ICodeKeyTypeImpl::LINE)) node->setAttribute<ICodeKeyTypeImpl::LINE>(n.line);
+          if (n.flags & keyBit(ICodeKeyTypeImpl::ID)) node->setAttribute<ICodeKeyTypeImpl::ID>(entry(n.id));
+          if (n.flags & keyBit(ICodeKeyTypeImpl::VALUE)) node->setAttribute<ICodeKeyTypeImpl::VALUE>(image.value(n.value));
+          if (n.typeSpec != none) node->setTypeSpec(type(n.typeSpec));
+          nodes[j] = std::move(node);
+        }
+        for (std::uint32_t j = r.icodeRoot; j < r.icodeEnd; ++j) {
+          const auto n = image.record<NodeRecord>(NODES, j);
+          ImageReader::check(n.childCount == 0 ||
+                             (n.firstChild > j && static_cast<std::uint64_t>(n.firstChild) + n.childCount <= r.icodeEnd));
+          for (std::uint32_t k = n.firstChild; k < n.firstChild + n.childCount; ++k) {
+            nodes[j]->addChild(nodes[k]);
+          }
+        }
+        icode->setRoot(nodes[r.icodeRoot]);
+      }
+      e->setAttribute<SymbolTableKeyTypeImpl::ROUTINE_ICODE>(icode);
+    }
+  }
+  symbol_table_stack->setProgramId(entry(header.programId));
+  return symbol_table_stack;
+}
+
+}
+
+std::uint64_t ICodeImage::hash(std::string_view text)
+{
+  // FNV-1a
+  std::uint64_t h = 14695981039346656037ull;
+  for (const char c: text) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+std::string ICodeImage::cachePath(const std::string& cache_dir, std::string_view source_text)
+{
+  return (std::filesystem::path(cache_dir) /
+          fmt::format("{:016x}-{}.pimg", hash(source_text), source_text.size())).string();
+}
+
+bool ICodeImage::save(const std::string& path, std::string_view source_text, int line_count,
+                      const std::shared_ptr<SymbolTableStackImplBase>& symbol_table_stack)
+{
+  ImageWriter writer;
+  if (!writer.collect(symbol_table_stack)) return false;
+  const auto buffer = writer.serialize(source_text, line_count, symbol_table_stack->programId());
+  if (buffer.empty()) return false;
+  std::error_code ec;
+  const std::filesystem::path image_path(path);
+  if (image_path.has_parent_path()) {
+    std::filesystem::create_directories(image_path.parent_path(), ec);
+  }
+  // write to a temporary file and rename it, so that concurrent runs
+  // never see a partial image
+  const auto tmp_path = fmt::format("{}.{:x}.tmp", path,
+    std::chrono::high_resolution_clock::now().time_since_epoch().count());
+  {
+    std::ofstream ofs(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open()) return false;
+    ofs.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (!ofs) {
+      ofs.close();
+      std::filesystem::remove(tmp_path, ec);
+      return false;
+    }
+  }
+  std::filesystem::rename(tmp_path, image_path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp_path, ec);
+    return false;
+  }
+  return true;
+}
+
+std::shared_ptr<SymbolTableStackImplBase> ICodeImage::load(const std::string& path,
+                                                           std::string_view source_text,
+                                                           int& line_count)
+{
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(path, ec)) return nullptr;
+  // Source memory-maps the file
+  const Source image_file(path);
+  if (!image_file.isOpen()) return nullptr;
+  try {
+    const ImageReader image(image_file.text());
+    const auto& header = image.header();
+    if (header.sourceSize != source_text.size() || header.sourceHash != hash(source_text)) {
+      return nullptr;
+    }
+    auto symbol_table_stack = loadImage(image);
+    line_count = header.lineCount;
+    return symbol_table_stack;
+  } catch (const std::runtime_error&) {
+    return nullptr;
+  }
+}
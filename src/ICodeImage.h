@@ -0,0 +1,34 @@
+#ifndef ICODEIMAGE_H
+#define ICODEIMAGE_H
+
+#include "Intermediate.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// binary image of a parsed program: the symbol table stack with all
+// routine symbol tables, the type specifications and the intermediate code.
+// the image is a header followed by arrays of fixed-size records that refer
+// to each other by index, so that a memory-mapped image is turned back into
+// objects in a single pass without scanning, parsing or type checking.
+// the predefined identifiers and types are not stored but referred to by
+// their position in Predefined::entries() and Predefined::types().
+class ICodeImage {
+public:
+  // the image file of a source in the cache directory, keyed by the content hash
+  static std::string cachePath(const std::string& cache_dir, std::string_view source_text);
+  // write the image of an error-free program, return false if it cannot be written
+  static bool save(const std::string& path, std::string_view source_text, int line_count,
+                   const std::shared_ptr<SymbolTableStackImplBase>& symbol_table_stack);
+  // load the image of the source, return nullptr if there is no valid image.
+  // the Predefined singleton must not be initialized yet, since the
+  // predefined identifiers are entered into the new symbol table stack.
+  static std::shared_ptr<SymbolTableStackImplBase> load(const std::string& path,
+                                                        std::string_view source_text,
+                                                        int& line_count);
+  static std::uint64_t hash(std::string_view text);
+};
+
+#endif // ICODEIMAGE_H
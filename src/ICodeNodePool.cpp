@@ -0,0 +1,71 @@
+#include "ICodeNodePool.h"
+#include "Common.h"
+
+#include <boost/container_hash/hash.hpp>
+#include <bit>
+#include <functional>
+#include <iostream>
+
+ICodeNodePool::ICodeNodePool(): mHits(0) {}
+
+ICodeNodePool::~ICodeNodePool()
+{
+#ifdef DEBUG_DESTRUCTOR
+  std::cerr << "Destructor: " << BOOST_CURRENT_FUNCTION << std::endl;
+#endif
+}
+
+std::shared_ptr<ICodeNodeImplBase> ICodeNodePool::constant(
+  ICodeNodeTypeImpl type, const VariableValueT& value,
+  const std::shared_ptr<TypeSpecImplBase>& type_spec)
+{
+  // compare reals by their bits, so that 0.0 and -0.0 stay apart
+  Key key{type, nullptr, type_spec.get(), value};
+  if (std::holds_alternative<PascalFloat>(value)) {
+    key.value = std::bit_cast<PascalInteger>(std::get<PascalFloat>(value));
+  }
+  auto [it, inserted] = mLeaves.try_emplace(std::move(key), nullptr);
+  if (!inserted) {
+    ++mHits;
+    return it->second;
+  }
+  it->second = createICodeNode(type);
+  it->second->setAttribute<ICodeKeyTypeImpl::VALUE>(value);
+  it->second->setTypeSpec(type_spec);
+  return it->second;
+}
+
+std::shared_ptr<ICodeNodeImplBase> ICodeNodePool::variable(
+  const std::shared_ptr<SymbolTableEntryImplBase>& id,
+  const std::shared_ptr<TypeSpecImplBase>& type_spec)
+{
+  auto [it, inserted] = mLeaves.try_emplace(
+    Key{ICodeNodeTypeImpl::VARIABLE, id.get(), type_spec.get(), VariableValueT{}}, nullptr);
+  if (!inserted) {
+    ++mHits;
+    return it->second;
+  }
+  it->second = createICodeNode(ICodeNodeTypeImpl::VARIABLE);
+  it->second->setAttribute<ICodeKeyTypeImpl::ID>(id);
+  it->second->setTypeSpec(type_spec);
+  return it->second;
+}
+
+size_t ICodeNodePool::size() const
+{
+  return mLeaves.size();
+}
+
+size_t ICodeNodePool::hits() const
+{
+  return mHits;
+}
+
+size_t ICodeNodePool::KeyHash::operator()(const Key& key) const
+{
+  size_t seed = std::hash<VariableValueT>{}(key.value);
+  boost::hash_combine(seed, static_cast<int>(key.type));
+  boost::hash_combine(seed, key.id);
+  boost::hash_combine(seed, key.typeSpec);
+  return seed;
+}
@@ -0,0 +1,50 @@
+#ifndef ICODENODEPOOL_H
+#define ICODENODEPOOL_H
+
+#include "Intermediate.h"
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+
+// hash-consing table for the leaves of the intermediate code
+// in the DAG mode the parser asks this table for constant and plain
+// variable leaves, so equal leaves are one node shared by all their users.
+// the rule for per-site state: only nodes without it are shared.
+//   - a shared leaf has no children and never carries a LINE attribute,
+//   - the executors never flag a runtime error on a constant or a VARIABLE,
+//     so no error message depends on where a shared leaf is used,
+//   - the parent of a shared leaf is its latest user, and nothing may rely on it.
+class ICodeNodePool {
+public:
+  ICodeNodePool();
+  ~ICodeNodePool();
+  ICodeNodePool(const ICodeNodePool&) = delete;
+  ICodeNodePool& operator=(const ICodeNodePool&) = delete;
+  // an INTEGER_CONSTANT, REAL_CONSTANT or STRING_CONSTANT node
+  std::shared_ptr<ICodeNodeImplBase> constant(ICodeNodeTypeImpl type, const VariableValueT& value,
+                                              const std::shared_ptr<TypeSpecImplBase>& type_spec);
+  // a VARIABLE node without subscripts or fields
+  std::shared_ptr<ICodeNodeImplBase> variable(const std::shared_ptr<SymbolTableEntryImplBase>& id,
+                                              const std::shared_ptr<TypeSpecImplBase>& type_spec);
+  // distinct leaves created
+  [[nodiscard]] size_t size() const;
+  // requests answered with an existing leaf
+  [[nodiscard]] size_t hits() const;
+private:
+  struct Key {
+    ICodeNodeTypeImpl type;
+    const SymbolTableEntryImplBase* id;
+    const TypeSpecImplBase* typeSpec;
+    VariableValueT value;
+    bool operator==(const Key&) const = default;
+  };
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+  // the leaves hold their entries and types, so the raw pointers of the keys stay valid
+  std::unordered_map<Key, std::shared_ptr<ICodeNodeImplBase>, KeyHash> mLeaves;
+  size_t mHits;
+};
+
+#endif // ICODENODEPOOL_H
@@ -0,0 +1,191 @@
+#include "InputBuffer.h"
+#include "OutputBuffer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <unistd.h>
+#define INPUT_USE_MMAP
+#endif
+
+namespace {
+
+// a leading + is allowed in the input, but not by std::from_chars
+std::string_view withoutPlus(std::string_view text)
+{
+  if (text.size() > 1 && text[0] == '+' && text[1] != '-') text.remove_prefix(1);
+  return text;
+}
+
+bool equalsIgnoreCase(std::string_view text, std::string_view lower)
+{
+  return std::ranges::equal(text, lower, [](char a, char b){
+    return std::tolower(static_cast<unsigned char>(a)) == b;
+  });
+}
+
+}
+
+InputBuffer& InputBuffer::instance()
+{
+  static InputBuffer input;
+  return input;
+}
+
+InputBuffer::InputBuffer():
+  mMappedData(nullptr), mMappedSize(0), mAtEnd(false),
+  mCursor(nullptr), mEnd(nullptr)
+{
+  if (mapInput()) {
+    mAtEnd = true;
+  }
+}
+
+InputBuffer::~InputBuffer()
+{
+#ifdef DEBUG_DESTRUCTOR
+  std::cerr << "Destructor: " << BOOST_CURRENT_FUNCTION << std::endl;
+#endif
+#ifdef INPUT_USE_MMAP
+  if (mMappedData != nullptr) {
+    ::munmap(mMappedData, mMappedSize);
+  }
+#endif
+}
+
+bool InputBuffer::mapInput()
+{
+#ifdef INPUT_USE_MMAP
+  struct stat st{};
+  if (::fstat(STDIN_FILENO, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+    // empty files cannot be mapped, and pipes have no size
+    return false;
+  }
+  // the shell may have consumed a part of the file already
+  const off_t offset = ::lseek(STDIN_FILENO, 0, SEEK_CUR);
+  if (offset < 0 || offset >= st.st_size) return false;
+  void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+  if (data == MAP_FAILED) return false;
+  // the input is read from the beginning to the end
+  ::madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+  mMappedData = data;
+  mMappedSize = static_cast<size_t>(st.st_size);
+  mCursor = static_cast<const char*>(data) + offset;
+  mEnd = static_cast<const char*>(data) + mMappedSize;
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool InputBuffer::fill()
+{
+  if (mAtEnd) return false;
+  // a prompt without a line end must show before the program waits for the input
+  OutputBuffer::instance().flush();
+  const auto unread = static_cast<size_t>(mEnd - mCursor);
+  if (unread > 0) {
+    std::memmove(mBuffer.data(), mCursor, unread);
+  }
+  if (mBuffer.size() < unread + BLOCK_SIZE) {
+    mBuffer.resize(unread + BLOCK_SIZE);
+  }
+  char* const block = mBuffer.data() + unread;
+  const size_t capacity = mBuffer.size() - unread;
+#ifdef INPUT_USE_MMAP
+  // a terminal or a pipe returns what it has, without waiting for a full block
+  ssize_t count;
+  do {
+    count = ::read(STDIN_FILENO, block, capacity);
+  } while (count < 0 && errno == EINTR);
+  const size_t size = (count > 0) ? static_cast<size_t>(count) : 0;
+#else
+  const size_t size = std::fread(block, 1, capacity, stdin);
+#endif
+  if (size == 0) mAtEnd = true;
+  mCursor = mBuffer.data();
+  mEnd = block + size;
+  return size > 0;
+}
+
+std::string_view InputBuffer::token()
+{
+  // skip the blanks and the line ends
+  while (true) {
+    mCursor = std::find_if_not(mCursor, mEnd, isBlank);
+    if (mCursor != mEnd || !fill()) break;
+  }
+  // fill() keeps the unread characters, so the length stays valid
+  size_t length = 0;
+  while (true) {
+    length = static_cast<size_t>(std::find_if(mCursor + length, mEnd, isBlank) - mCursor);
+    if (mCursor + length != mEnd || !fill()) break;
+  }
+  const std::string_view result(mCursor, length);
+  mCursor += length;
+  return result;
+}
+
+bool InputBuffer::readInteger(PascalInteger& value)
+{
+  const auto text = withoutPlus(token());
+  const char* last = text.data() + text.size();
+  const auto [ptr, ec] = std::from_chars(text.data(), last, value);
+  return ec == std::errc{} && ptr == last;
+}
+
+bool InputBuffer::readReal(PascalFloat& value)
+{
+  const auto text = withoutPlus(token());
+  // a real starts with a digit, which also rules out inf and nan
+  const size_t first = (!text.empty() && text[0] == '-') ? 1 : 0;
+  if (text.size() <= first || !std::isdigit(static_cast<unsigned char>(text[first]))) return false;
+  const char* last = text.data() + text.size();
+  const auto [ptr, ec] = std::from_chars(text.data(), last, value);
+  return ec == std::errc{} && ptr == last;
+}
+
+bool InputBuffer::readBoolean(bool& value)
+{
+  const auto text = token();
+  if (equalsIgnoreCase(text, "true")) {
+    value = true;
+  } else if (equalsIgnoreCase(text, "false")) {
+    value = false;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool InputBuffer::readChar(char& value)
+{
+  if (eof()) return false;
+  value = *mCursor++;
+  if (isLineEnd(value)) {
+    // a CR LF line end is one blank
+    if (value == '\r' && !eof() && *mCursor == '\n') ++mCursor;
+    value = ' ';
+  }
+  return true;
+}
+
+void InputBuffer::skipLine()
+{
+  while (true) {
+    mCursor = std::find(mCursor, mEnd, '\n');
+    if (mCursor != mEnd) {
+      ++mCursor;
+      return;
+    }
+    if (!fill()) return;
+  }
+}
@@ -0,0 +1,62 @@
+#ifndef INPUTBUFFER_H
+#define INPUTBUFFER_H
+
+#include "Common.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// the standard input of the interpreted program
+// a regular file is memory-mapped, anything else (a pipe or a terminal)
+// is read in large blocks, and the values are parsed straight out of the
+// buffer with std::from_chars. the character tests are inline, so eof and
+// eoln only go out of line when the buffer has to be refilled.
+class InputBuffer {
+public:
+  static InputBuffer& instance();
+  ~InputBuffer();
+  InputBuffer(const InputBuffer&) = delete;
+  InputBuffer& operator=(const InputBuffer&) = delete;
+  [[nodiscard]] bool eof() {
+    return mCursor == mEnd && !fill();
+  }
+  // a line end, or the end of the input
+  [[nodiscard]] bool eoln() {
+    return eof() || isLineEnd(*mCursor);
+  }
+  // skip the blanks and the line ends before the value, and consume its token.
+  // false if there is no token, or if it is not a value of the type
+  bool readInteger(PascalInteger& value);
+  bool readReal(PascalFloat& value);
+  // true or false, in any case
+  bool readBoolean(bool& value);
+  // the next character, where a line end reads as a blank
+  bool readChar(char& value);
+  // skip the rest of the current line and its line end
+  void skipLine();
+private:
+  InputBuffer();
+  // try to map the standard input into memory
+  bool mapInput();
+  // keep the unread characters and read the next block after them,
+  // false if nothing could be read
+  bool fill();
+  // the next run of non-blank characters, only valid until the next fill
+  std::string_view token();
+  static bool isLineEnd(char c) {
+    return c == '\n' || c == '\r';
+  }
+  static bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+  }
+  static const size_t BLOCK_SIZE = 1 << 20;
+  std::string mBuffer;        // holds the input if it is not mapped
+  void* mMappedData;          // start of the mapping, or nullptr
+  size_t mMappedSize;
+  bool mAtEnd;                // nothing more to read from the standard input
+  const char* mCursor;        // the next unread character
+  const char* mEnd;           // end of the characters read so far
+};
+
+#endif // INPUTBUFFER_H
@@ -2,7 +2,12 @@
 #define INTERMEDIATE_H
 
 #include "Common.h"
+#include "NameTable.h"
+#include "ICodeArena.h"
+#include "Containers.h"
 
+#include <functional>
+#include <optional>
 #include <memory>
 #include <any>
 #include <vector>
@@ -11,12 +16,36 @@
 #include <deque>
 #include <variant>
 
+// container policies, see the CONTAINER_POLICY option in CMakeLists.txt
+#if defined(CONTAINER_POLICY_SMALL)
+template <typename KeyT, typename ValueT>
+using AttributeMapTImpl = FlatMap<KeyT, ValueT>;
+
+template <typename ValueT>
+using ChildrenContainerTImpl = SmallVector<ValueT, 3>;
+
+template <typename ValueT>
+using SymbolMapTImpl = FlatIdMap<ValueT>;
+#elif defined(CONTAINER_POLICY_STD)
+template <typename KeyT, typename ValueT>
+using AttributeMapTImpl = std::unordered_map<KeyT, ValueT>;
+
+template <typename ValueT>
+using ChildrenContainerTImpl = std::vector<ValueT>;
+
+template <typename ValueT>
+using SymbolMapTImpl = UnorderedIdMap<ValueT>;
+#else
 template <typename KeyT, typename ValueT>
 using AttributeMapTImpl = std::unordered_map<KeyT, ValueT>;
 
 template <typename ValueT>
 using ChildrenContainerTImpl = std::vector<ValueT>;
 
+template <typename ValueT>
+using SymbolMapTImpl = FlatIdMap<ValueT>;
+#endif
+
 template <typename ValueT>
 using SymbolStackContainerTImpl = std::vector<ValueT>;
 
@@ -34,6 +63,10 @@ template <typename SymbolTableKeyT, typename DefinitionT, typename TypeFormT, ty
           template <typename...> typename AttributeMapT>
 class SymbolTable;
 
+// typed storage of the ICode node and type attributes, specialized for each key type
+template <typename KeyT>
+class AttributeSlots;
+
 template <typename NodeT,
           typename KeyT,
           template <typename...> typename AttributeMapT,
@@ -41,10 +74,8 @@ template <typename NodeT,
           typename TypeSpecT>
 class ICodeNode: public std::enable_shared_from_this<ICodeNode<NodeT, KeyT, AttributeMapT, ChildrenContainerT, TypeSpecT>> {
 public:
-  using AttributeMapImpl = AttributeMapT<KeyT, std::any>;
+  using AttributeSlotsImpl = AttributeSlots<KeyT>;
   using ChildrenContainerImpl = ChildrenContainerT<std::shared_ptr<ICodeNode>>;
-  using attribute_map_iterator = typename AttributeMapT<KeyT, std::any>::iterator;
-  using const_attribute_map_iterator = typename AttributeMapT<KeyT, std::any>::const_iterator;
   using children_iterator = typename ChildrenContainerT<std::shared_ptr<ICodeNode>>::iterator;
   using const_children_iterator = typename ChildrenContainerT<std::shared_ptr<ICodeNode>>::const_iterator;
   ICodeNode() = default;
@@ -54,22 +85,35 @@ public:
   virtual void setParent(const std::weak_ptr<const ICodeNode>& new_parent) = 0;
   [[nodiscard]] virtual const std::shared_ptr<const ICodeNode> parent() const = 0;
   virtual std::shared_ptr<ICodeNode> addChild(std::shared_ptr<ICodeNode> node) = 0;
-  virtual void setAttribute(const KeyT& key, const std::any& value) = 0;
-  [[nodiscard]] virtual std::any getAttribute(const KeyT& key) const = 0;
+  // the attributes live in fixed typed slots, so that the keyed accessors
+  // below are resolved at compile time without hashing or any_cast
+  void setAttribute(const KeyT& key, const std::any& value) {
+    mAttributes.set(key, value);
+  }
+  [[nodiscard]] std::any getAttribute(const KeyT& key) const {
+    return mAttributes.get(key);
+  }
+  [[nodiscard]] bool hasAttribute(const KeyT& key) const {
+    return mAttributes.contains(key);
+  }
   template <KeyT KeyVal>
-  [[nodiscard]] auto getAttribute() const {
-    return cast_by_enum<KeyVal>(getAttribute(KeyVal));
+  [[nodiscard]] decltype(auto) getAttribute() const {
+    return mAttributes.template get<KeyVal>();
   }
   template <KeyT KeyVal>
   void setAttribute(const typename EnumToType<KeyVal>::type& val) {
-    setAttribute(KeyVal, val);
+    mAttributes.template set<KeyVal>(val);
+  }
+  // the activation record slot of the ID, copied from the entry when the ID is set,
+  // so that the executors reach a variable without locking its entry
+  [[nodiscard]] int slotLevel() const {
+    return mAttributes.slotLevel();
   }
-  virtual std::unique_ptr<ICodeNode> copy() const = 0;
+  [[nodiscard]] int slot() const {
+    return mAttributes.slot();
+  }
+  virtual std::shared_ptr<ICodeNode> copy() const = 0;
   [[nodiscard]] virtual std::string toString() const = 0;
-  virtual attribute_map_iterator attributeMapBegin() = 0;
-  virtual attribute_map_iterator attributeMapEnd() = 0;
-  virtual const_attribute_map_iterator attributeMapBegin() const = 0;
-  virtual const_attribute_map_iterator attributeMapEnd() const = 0;
   virtual children_iterator childrenBegin() = 0;
   virtual children_iterator childrenEnd() = 0;
   virtual const_children_iterator childrenBegin() const = 0;
@@ -77,6 +121,8 @@ public:
   [[nodiscard]] virtual size_t numChildren() const = 0;
   virtual void setTypeSpec(const std::shared_ptr<TypeSpecT>& type_spec) = 0;
   [[nodiscard]] virtual std::shared_ptr<TypeSpecT> getTypeSpec() const = 0;
+protected:
+  AttributeSlotsImpl mAttributes;
 };
 
 template <typename ICodeNodeType, typename ICodeKeyType,
@@ -90,6 +136,12 @@ public:
   virtual ~ICode() = default;
   virtual void setRoot(const std::shared_ptr<ICodeNodeT>& node) = 0;
   [[nodiscard]] virtual std::shared_ptr<ICodeNodeT> getRoot() const = 0;
+  // build the root on the first call of getRoot(), in the arena of this intermediate code
+  virtual void setRootLoader(std::function<std::shared_ptr<ICodeNodeT>()> loader) = 0;
+  // whether the root is built (always true without a loader)
+  [[nodiscard]] virtual bool isLoaded() const = 0;
+  // the arena holding the nodes of this intermediate code
+  [[nodiscard]] virtual const std::shared_ptr<ICodeArena>& arena() const = 0;
 };
 
 template <typename SymbolTableKeyT, typename DefinitionT, typename TypeFormT, typename TypeKeyT,
@@ -104,18 +156,25 @@ public:
   [[nodiscard]] virtual std::string name() const = 0;
   [[nodiscard]] virtual std::shared_ptr<SymbolTableT> symbolTable() const = 0;
   virtual void appendLineNumber(int line_number) = 0;
-  [[nodiscard]]virtual std::vector<int> lineNumbers() const = 0;
+  [[nodiscard]] virtual const std::vector<int>& lineNumbers() const = 0;
   virtual void setAttribute(const SymbolTableKeyT& key, const std::any& value) = 0;
   [[nodiscard]] virtual std::any getAttribute(const SymbolTableKeyT& key) const = 0;
+  // the stored attribute itself, or nullptr if the entry does not have it
+  [[nodiscard]] virtual std::any* findAttribute(const SymbolTableKeyT& key) = 0;
   template <SymbolTableKeyT KeyVal>
   [[nodiscard]] auto getAttribute() const {
     auto result = getAttribute(KeyVal);
-    std::optional<decltype(cast_by_enum<KeyVal>(getAttribute(KeyVal)))> out;
+    std::optional<typename EnumToType<KeyVal>::type> out;
     if (result.has_value()) {
-      out = cast_by_enum<KeyVal>(getAttribute(KeyVal));
+      out = std::any_cast<typename EnumToType<KeyVal>::type>(std::move(result));
     }
     return out;
   }
+  // update an attribute in place, for example to append to a list without copying it
+  template <SymbolTableKeyT KeyVal>
+  [[nodiscard]] typename EnumToType<KeyVal>::type* findAttribute() {
+    return std::any_cast<typename EnumToType<KeyVal>::type>(findAttribute(KeyVal));
+  }
   template <SymbolTableKeyT KeyVal>
   void setAttribute(const typename EnumToType<KeyVal>::type& val) {
     setAttribute(KeyVal, val);
@@ -124,6 +183,10 @@ public:
   [[nodiscard]] virtual DefinitionT getDefinition() const = 0;
   virtual void setTypeSpec(std::shared_ptr<TypeSpecT> type_spec) = 0;
   [[nodiscard]] virtual std::shared_ptr<TypeSpecT> getTypeSpec() const = 0;
+  // the slot of a variable, a parameter or a function result in the
+  // activation record of its symbol table, or -1 if the entry holds no data
+  virtual void setSlot(int slot) = 0;
+  [[nodiscard]] virtual int slot() const = 0;
 };
 
 template <typename SymbolTableKeyT, typename DefinitionT, typename TypeFormT, typename TypeKeyT,
@@ -131,13 +194,20 @@ template <typename SymbolTableKeyT, typename DefinitionT, typename TypeFormT, ty
 class SymbolTable: public std::enable_shared_from_this<SymbolTable<SymbolTableKeyT, DefinitionT, TypeFormT, TypeKeyT, AttributeMapT>> {
 public:
   using SymbolTableEntryT = SymbolTableEntry<SymbolTableKeyT, DefinitionT, TypeFormT, TypeKeyT, AttributeMapT>;
-  using SymbolTableMapT = AttributeMapT<std::string, std::shared_ptr<SymbolTableEntryT>>;
+  // keyed by the interned lowercase names
+  using SymbolTableMapT = SymbolMapTImpl<std::shared_ptr<SymbolTableEntryT>>;
   explicit SymbolTable(int) {}
   virtual ~SymbolTable() = default;
   [[nodiscard]] virtual int nestingLevel() const = 0;
   virtual std::shared_ptr<SymbolTableEntryT> lookup(const std::string& name) const = 0;
   virtual std::shared_ptr<SymbolTableEntryT> enter(const std::string& name) = 0;
+  virtual std::shared_ptr<SymbolTableEntryT> lookup(NameId name_id) const = 0;
+  virtual std::shared_ptr<SymbolTableEntryT> enter(NameId name_id) = 0;
   [[nodiscard]] virtual std::vector<std::shared_ptr<SymbolTableEntryT>> sortedEntries() const = 0;
+  // the next free slot of the activation record
+  virtual int allocateSlot() = 0;
+  // the size of the activation record
+  [[nodiscard]] virtual int slotCount() const = 0;
 };
 
 template <typename SymbolTableKeyT, typename DefinitionT, typename TypeFormT, typename TypeKeyT,
@@ -156,6 +226,10 @@ public:
   [[nodiscard]] virtual std::shared_ptr<SymbolTableEntryT> lookupLocal(const std::string& name) const = 0;
   // lookup an existing symbol table entry throughout the stack
   [[nodiscard]] virtual std::shared_ptr<SymbolTableEntryT> lookup(const std::string& name) const = 0;
+  // same as above, but with the interned names
+  [[nodiscard]] virtual std::shared_ptr<SymbolTableEntryT> enterLocal(NameId name_id) = 0;
+  [[nodiscard]] virtual std::shared_ptr<SymbolTableEntryT> lookupLocal(NameId name_id) const = 0;
+  [[nodiscard]] virtual std::shared_ptr<SymbolTableEntryT> lookup(NameId name_id) const = 0;
   // set the symbol table entry for the main program identifier
   virtual void setProgramId(const std::weak_ptr<SymbolTableEntryT>& entry) = 0;
   // get the symbol table entry for the main program identifier
@@ -182,19 +256,31 @@ public:
   // raw pointers are used to avoid the circular dependency
   virtual void setIdentifier(const std::weak_ptr<SymbolTableEntryT>& identifier) = 0;
   [[nodiscard]] virtual std::shared_ptr<SymbolTableEntryT> getIdentifier() const = 0;
+  // an empty std::any means a missing attribute
   virtual void setAttribute(TypeKeyT key, const std::any& value) = 0;
   [[nodiscard]] virtual std::any getAttribute(TypeKeyT key) const = 0;
+  [[nodiscard]] bool hasAttribute(TypeKeyT key) const {
+    return mAttributes.contains(key);
+  }
+  // resolved to the typed slot at compile time,
+  // a missing attribute reads as a default-constructed value
   template <TypeKeyT KeyVal>
-  [[nodiscard]] auto getAttribute() const {
-    return cast_by_enum<KeyVal>(getAttribute(KeyVal));
+  [[nodiscard]] const auto& getAttribute() const {
+    return mAttributes.template get<KeyVal>();
   }
   template <TypeKeyT KeyVal>
   void setAttribute(const typename EnumToType<KeyVal>::type& val) {
-    setAttribute(KeyVal, val);
+    mAttributes.template set<KeyVal>(val);
   }
   [[nodiscard]] virtual bool isPascalString() const = 0;
   [[nodiscard]] virtual std::shared_ptr<TypeSpec> baseType() = 0;
+  // the same as baseType() without touching the reference counts, for type checks
+  [[nodiscard]] virtual const TypeSpec* rawBaseType() const = 0;
+  // an anonymous copy with the same attributes
+  [[nodiscard]] virtual std::shared_ptr<TypeSpec> copy() const = 0;
   virtual std::string anonymousName() const = 0;
+protected:
+  AttributeSlots<TypeKeyT> mAttributes;
 };
 
 typedef TypeSpec<SymbolTableKeyTypeImpl, DefinitionImpl, TypeFormImpl, TypeKeyImpl, AttributeMapTImpl> TypeSpecImplBase;
@@ -233,14 +319,26 @@ template <typename NodeT, typename KeyT,
           template <typename...> typename AttributeMapT,
           template <typename...> typename ChildrenContainerT,
           typename TypeSpecT>
-std::unique_ptr<ICodeNode<NodeT, KeyT, AttributeMapT, ChildrenContainerT, TypeSpecT>> createICodeNode(const NodeT& type);
-std::unique_ptr<ICodeNodeImplBase> createICodeNode(const ICodeNodeTypeImpl &type);
+std::shared_ptr<ICodeNode<NodeT, KeyT, AttributeMapT, ChildrenContainerT, TypeSpecT>> createICodeNode(const NodeT& type);
+// allocated from ICodeArena::current() if there is one
+std::shared_ptr<ICodeNodeImplBase> createICodeNode(const ICodeNodeTypeImpl &type);
 
 template <typename SymbolTableKeyT, typename DefinitionT, typename TypeFormT, typename TypeKeyT,
           template <typename...> typename AttributeMapT>
 std::unique_ptr<TypeSpec<SymbolTableKeyT, DefinitionT, TypeFormT, TypeKeyT, AttributeMapT>> createType(const TypeFormT& form);
 std::unique_ptr<TypeSpecImplBase> createType(const TypeFormImpl& form);
-std::unique_ptr<TypeSpecImplBase> createStringType(const std::string& value);
+// the anonymous subrange, array and string types are interned, so that
+// structurally identical types are the same object and compare by pointer.
+// an interned type must not be given an identifier, see ownedType().
+std::shared_ptr<TypeSpecImplBase> createSubrangeType(const std::shared_ptr<TypeSpecImplBase>& base_type,
+                                                     const VariableValueT& min_value,
+                                                     const VariableValueT& max_value);
+std::shared_ptr<TypeSpecImplBase> createArrayType(const std::shared_ptr<TypeSpecImplBase>& index_type,
+                                                  const std::shared_ptr<TypeSpecImplBase>& element_type,
+                                                  const std::optional<PascalInteger>& element_count);
+std::shared_ptr<TypeSpecImplBase> createStringType(const std::string& value);
+// the type itself, or a copy of it if it is interned
+std::shared_ptr<TypeSpecImplBase> ownedType(const std::shared_ptr<TypeSpecImplBase>& type_spec);
 
 template <SymbolTableKeyTypeImpl> struct SymbolTableKeyToEnum;
 template <> struct SymbolTableKeyToEnum<SymbolTableKeyTypeImpl::CONSTANT_VALUE> { using type = VariableValueT; };
@@ -248,7 +346,6 @@ template <> struct SymbolTableKeyToEnum<SymbolTableKeyTypeImpl::ROUTINE_SYMTAB>
 template <> struct SymbolTableKeyToEnum<SymbolTableKeyTypeImpl::ROUTINE_ICODE> { using type = std::shared_ptr<ICodeImplBase>; };
 template <> struct SymbolTableKeyToEnum<SymbolTableKeyTypeImpl::ROUTINE_ROUTINES> { using type = std::vector<std::shared_ptr<SymbolTableEntryImplBase>>; };
 template <> struct SymbolTableKeyToEnum<SymbolTableKeyTypeImpl::ROUTINE_PARMS> { using type = std::vector<std::shared_ptr<SymbolTableEntryImplBase>>; };
-template <> struct SymbolTableKeyToEnum<SymbolTableKeyTypeImpl::DATA_VALUE> { using type = VariableValueT; };
 template <> struct SymbolTableKeyToEnum<SymbolTableKeyTypeImpl::ROUTINE_CODE> { using type = RoutineCodeImpl; };
 
 template <ICodeKeyTypeImpl> struct ICodeKeyTypeImplToEnum;
@@ -288,4 +385,166 @@ auto cast_by_enum(const std::any& x) {
   return std::any_cast<typename EnumToType<EnumVal>::type>(x);
 }
 
+template <>
+class AttributeSlots<ICodeKeyTypeImpl> {
+public:
+  // a reference to the slot, except for ID which is returned locked
+  template <ICodeKeyTypeImpl KeyVal>
+  [[nodiscard]] decltype(auto) get() const {
+    if constexpr (KeyVal == ICodeKeyTypeImpl::LINE) {
+      return (mLine);
+    } else if constexpr (KeyVal == ICodeKeyTypeImpl::ID) {
+      return mId.lock();
+    } else {
+      return (mValue);
+    }
+  }
+  template <ICodeKeyTypeImpl KeyVal>
+  void set(const typename EnumToType<KeyVal>::type& val) {
+    if constexpr (KeyVal == ICodeKeyTypeImpl::LINE) {
+      mLine = val;
+    } else if constexpr (KeyVal == ICodeKeyTypeImpl::ID) {
+      mId = val;
+      mSlot = val ? val->slot() : -1;
+      mSlotLevel = -1;
+      if (mSlot >= 0) {
+        // the result of a function is in the function's own record, one level deeper
+        const bool result = (val->getDefinition() == DefinitionImpl::FUNCTION);
+        mSlotLevel = static_cast<std::int16_t>(val->symbolTable()->nestingLevel() + (result ? 1 : 0));
+      }
+    } else {
+      mValue = val;
+    }
+    mPresent |= mask(KeyVal);
+  }
+  [[nodiscard]] bool contains(ICodeKeyTypeImpl key) const {
+    return (mPresent & mask(key)) != 0;
+  }
+  // untyped access, an empty std::any means a missing attribute
+  [[nodiscard]] std::any get(ICodeKeyTypeImpl key) const {
+    if (!contains(key)) return std::any{};
+    switch (key) {
+      case ICodeKeyTypeImpl::LINE: return mLine;
+      case ICodeKeyTypeImpl::ID: return mId.lock();
+      case ICodeKeyTypeImpl::VALUE: return mValue;
+    }
+    return std::any{};
+  }
+  void set(ICodeKeyTypeImpl key, const std::any& value) {
+    switch (key) {
+      case ICodeKeyTypeImpl::LINE: set<ICodeKeyTypeImpl::LINE>(cast_by_enum<ICodeKeyTypeImpl::LINE>(value)); break;
+      case ICodeKeyTypeImpl::ID: set<ICodeKeyTypeImpl::ID>(cast_by_enum<ICodeKeyTypeImpl::ID>(value)); break;
+      case ICodeKeyTypeImpl::VALUE: set<ICodeKeyTypeImpl::VALUE>(cast_by_enum<ICodeKeyTypeImpl::VALUE>(value)); break;
+    }
+  }
+  [[nodiscard]] int slotLevel() const {
+    return mSlotLevel;
+  }
+  [[nodiscard]] int slot() const {
+    return mSlot;
+  }
+private:
+  static constexpr std::uint8_t mask(ICodeKeyTypeImpl key) {
+    return static_cast<std::uint8_t>(1u << static_cast<unsigned>(key));
+  }
+  VariableValueT mValue;
+  // the symbol tables own the entries, and a routine's entry owns its ICode,
+  // so a node referring to its own routine (a recursive call, or the result
+  // of a function) would form a cycle if this held the entry
+  std::weak_ptr<SymbolTableEntryImplBase> mId;
+  int mLine = 0;
+  int mSlot = -1;
+  std::int16_t mSlotLevel = -1;
+  std::uint8_t mPresent = 0;
+};
+
+template <>
+class AttributeSlots<TypeKeyImpl> {
+public:
+  template <TypeKeyImpl KeyVal>
+  [[nodiscard]] const auto& get() const {
+    if constexpr (KeyVal == TypeKeyImpl::ENUMERATION_CONSTANTS) {
+      return mEnumerationConstants;
+    } else if constexpr (KeyVal == TypeKeyImpl::SUBRANGE_BASE_TYPE) {
+      return mBaseType;
+    } else if constexpr (KeyVal == TypeKeyImpl::SUBRANGE_MIN_VALUE) {
+      return mMinValue;
+    } else if constexpr (KeyVal == TypeKeyImpl::SUBRANGE_MAX_VALUE) {
+      return mMaxValue;
+    } else if constexpr (KeyVal == TypeKeyImpl::ARRAY_INDEX_TYPE) {
+      return mIndexType;
+    } else if constexpr (KeyVal == TypeKeyImpl::ARRAY_ELEMENT_TYPE) {
+      return mElementType;
+    } else if constexpr (KeyVal == TypeKeyImpl::ARRAY_ELEMENT_COUNT) {
+      return mElementCount;
+    } else {
+      return mRecordSymtab;
+    }
+  }
+  template <TypeKeyImpl KeyVal>
+  void set(const typename EnumToType<KeyVal>::type& val) {
+    if constexpr (KeyVal == TypeKeyImpl::ENUMERATION_CONSTANTS) {
+      mEnumerationConstants = val;
+    } else if constexpr (KeyVal == TypeKeyImpl::SUBRANGE_BASE_TYPE) {
+      mBaseType = val;
+    } else if constexpr (KeyVal == TypeKeyImpl::SUBRANGE_MIN_VALUE) {
+      mMinValue = val;
+    } else if constexpr (KeyVal == TypeKeyImpl::SUBRANGE_MAX_VALUE) {
+      mMaxValue = val;
+    } else if constexpr (KeyVal == TypeKeyImpl::ARRAY_INDEX_TYPE) {
+      mIndexType = val;
+    } else if constexpr (KeyVal == TypeKeyImpl::ARRAY_ELEMENT_TYPE) {
+      mElementType = val;
+    } else if constexpr (KeyVal == TypeKeyImpl::ARRAY_ELEMENT_COUNT) {
+      mElementCount = val;
+    } else {
+      mRecordSymtab = val;
+    }
+    mPresent |= mask(KeyVal);
+  }
+  [[nodiscard]] bool contains(TypeKeyImpl key) const {
+    return (mPresent & mask(key)) != 0;
+  }
+  // untyped access, an empty std::any means a missing attribute
+  [[nodiscard]] std::any get(TypeKeyImpl key) const {
+    if (!contains(key)) return std::any{};
+    switch (key) {
+      case TypeKeyImpl::ENUMERATION_CONSTANTS: return mEnumerationConstants;
+      case TypeKeyImpl::SUBRANGE_BASE_TYPE: return mBaseType;
+      case TypeKeyImpl::SUBRANGE_MIN_VALUE: return mMinValue;
+      case TypeKeyImpl::SUBRANGE_MAX_VALUE: return mMaxValue;
+      case TypeKeyImpl::ARRAY_INDEX_TYPE: return mIndexType;
+      case TypeKeyImpl::ARRAY_ELEMENT_TYPE: return mElementType;
+      case TypeKeyImpl::ARRAY_ELEMENT_COUNT: return mElementCount;
+      case TypeKeyImpl::RECORD_SYMTAB: return mRecordSymtab;
+    }
+    return std::any{};
+  }
+  void set(TypeKeyImpl key, const std::any& value) {
+    switch (key) {
+      case TypeKeyImpl::ENUMERATION_CONSTANTS: set<TypeKeyImpl::ENUMERATION_CONSTANTS>(cast_by_enum<TypeKeyImpl::ENUMERATION_CONSTANTS>(value)); break;
+      case TypeKeyImpl::SUBRANGE_BASE_TYPE: set<TypeKeyImpl::SUBRANGE_BASE_TYPE>(cast_by_enum<TypeKeyImpl::SUBRANGE_BASE_TYPE>(value)); break;
+      case TypeKeyImpl::SUBRANGE_MIN_VALUE: set<TypeKeyImpl::SUBRANGE_MIN_VALUE>(cast_by_enum<TypeKeyImpl::SUBRANGE_MIN_VALUE>(value)); break;
+      case TypeKeyImpl::SUBRANGE_MAX_VALUE: set<TypeKeyImpl::SUBRANGE_MAX_VALUE>(cast_by_enum<TypeKeyImpl::SUBRANGE_MAX_VALUE>(value)); break;
+      case TypeKeyImpl::ARRAY_INDEX_TYPE: set<TypeKeyImpl::ARRAY_INDEX_TYPE>(cast_by_enum<TypeKeyImpl::ARRAY_INDEX_TYPE>(value)); break;
+      case TypeKeyImpl::ARRAY_ELEMENT_TYPE: set<TypeKeyImpl::ARRAY_ELEMENT_TYPE>(cast_by_enum<TypeKeyImpl::ARRAY_ELEMENT_TYPE>(value)); break;
+      case TypeKeyImpl::ARRAY_ELEMENT_COUNT: set<TypeKeyImpl::ARRAY_ELEMENT_COUNT>(cast_by_enum<TypeKeyImpl::ARRAY_ELEMENT_COUNT>(value)); break;
+      case TypeKeyImpl::RECORD_SYMTAB: set<TypeKeyImpl::RECORD_SYMTAB>(cast_by_enum<TypeKeyImpl::RECORD_SYMTAB>(value)); break;
+    }
+  }
+private:
+  static constexpr std::uint8_t mask(TypeKeyImpl key) {
+    return static_cast<std::uint8_t>(1u << static_cast<unsigned>(key));
+  }
+  std::vector<std::weak_ptr<SymbolTableEntryImplBase>> mEnumerationConstants;
+  std::shared_ptr<TypeSpecImplBase> mBaseType;
+  std::shared_ptr<TypeSpecImplBase> mIndexType;
+  std::shared_ptr<TypeSpecImplBase> mElementType;
+  std::shared_ptr<SymbolTableImplBase> mRecordSymtab;
+  VariableValueT mMinValue;
+  VariableValueT mMaxValue;
+  PascalInteger mElementCount = 0;
+  std::uint8_t mPresent = 0;
+};
+
 #endif // INTERMEDIATE_H
@@ -1,7 +1,12 @@
 #include "IntermediateImpl.h"
 #include "Predefined.h"
 
+#include <algorithm>
 #include <iostream>
+#include <map>
+#include <optional>
+#include <tuple>
+#include <utility>
 #include <boost/range/adaptor/reversed.hpp>
 
 SymbolTableStackImpl::SymbolTableStackImpl() : SymbolTableStack() {
@@ -34,10 +39,26 @@ SymbolTableStackImpl::lookupLocal(const std::string &name) const {
 }
 
 std::shared_ptr<SymbolTableEntryImplBase> SymbolTableStackImpl::lookup(const std::string &name) const {
+  // a name that was never interned is not in any symbol table
+  const auto name_id = NameTable::instance().find(name);
+  if (name_id == invalidNameId) return nullptr;
+  return lookup(name_id);
+}
+
+std::shared_ptr<SymbolTableEntryImplBase> SymbolTableStackImpl::enterLocal(NameId name_id) {
+  return mStack[mCurrentNestingLevel]->enter(name_id);
+}
+
+std::shared_ptr<SymbolTableEntryImplBase>
+SymbolTableStackImpl::lookupLocal(NameId name_id) const {
+  return mStack[mCurrentNestingLevel]->lookup(name_id);
+}
+
+std::shared_ptr<SymbolTableEntryImplBase> SymbolTableStackImpl::lookup(NameId name_id) const {
   std::shared_ptr<SymbolTableEntryImplBase> result = nullptr;
   // search the current and enclosing scopes
   for (int i = mCurrentNestingLevel; i >= 0; --i) {
-    result = mStack[i]->lookup(name);
+    result = mStack[i]->lookup(name_id);
     if (result != nullptr) break;
   }
   return result;
@@ -69,16 +90,15 @@ std::shared_ptr<SymbolTableImplBase> SymbolTableStackImpl::push(std::shared_ptr<
 
 std::shared_ptr<SymbolTableImplBase> SymbolTableStackImpl::pop()
 {
-  // auto symbol_table = mStack.back();
-  auto symbol_table = mStack.at(mCurrentNestingLevel);
-  // mStack.pop_back();
-  mStack.erase(mStack.begin() + mCurrentNestingLevel);
- --mCurrentNestingLevel;
+  // the current table is always the top of the stack
+  auto symbol_table = std::move(mStack.back());
+  mStack.pop_back();
+  --mCurrentNestingLevel;
   return symbol_table;
 }
 
 SymbolTableImpl::SymbolTableImpl(int nesting_level)
-    : SymbolTable(nesting_level) {
+    : SymbolTable(nesting_level), mSlotCount(0) {
   mNestingLevel = nesting_level;
 }
 
@@ -91,25 +111,38 @@ SymbolTableImpl::~SymbolTableImpl() {
 int SymbolTableImpl::nestingLevel() const { return mNestingLevel; }
 
 std::shared_ptr<SymbolTableEntryImplBase> SymbolTableImpl::lookup(const std::string &name) const {
-  auto search = mSymbolMap.find(name);
-  if (search != mSymbolMap.end()) {
-    return search->second;
+  const auto name_id = NameTable::instance().find(name);
+  if (name_id == invalidNameId) return nullptr;
+  return lookup(name_id);
+}
+
+std::shared_ptr<SymbolTableEntryImplBase>
+SymbolTableImpl::enter(const std::string &name) {
+  return enter(NameTable::instance().intern(name));
+}
+
+std::shared_ptr<SymbolTableEntryImplBase> SymbolTableImpl::lookup(NameId name_id) const {
+  const auto* search = mSymbolMap.find(name_id);
+  if (search != nullptr) {
+    return *search;
   } else {
     return nullptr;
   }
 }
 
 std::shared_ptr<SymbolTableEntryImplBase>
-SymbolTableImpl::enter(const std::string &name) {
-  mSymbolMap[name] = std::shared_ptr(createSymbolTableEntry(name, weak_from_this()));
-  return mSymbolMap[name];
+SymbolTableImpl::enter(NameId name_id) {
+  auto& entry = mSymbolMap[name_id];
+  entry = std::shared_ptr(createSymbolTableEntry(NameTable::instance().name(name_id), weak_from_this()));
+  return entry;
 }
 
 std::vector<std::shared_ptr<SymbolTableEntryImplBase> > SymbolTableImpl::sortedEntries() const {
   std::vector<std::shared_ptr<SymbolTableEntryImplBase>> result;
-  for (auto it = mSymbolMap.begin(); it != mSymbolMap.end(); ++it) {
-    result.push_back(it->second);
-  }
+  result.reserve(mSymbolMap.size());
+  mSymbolMap.forEach([&result](NameId, const std::shared_ptr<SymbolTableEntryImplBase>& entry){
+    result.push_back(entry);
+  });
   std::sort(result.begin(), result.end(), [](
     const std::shared_ptr<SymbolTableEntryImplBase>& x,
     const std::shared_ptr<SymbolTableEntryImplBase>& y){
@@ -118,9 +151,13 @@ std::vector<std::shared_ptr<SymbolTableEntryImplBase> > SymbolTableImpl::sortedE
   return result;
 }
 
+int SymbolTableImpl::allocateSlot() { return mSlotCount++; }
+
+int SymbolTableImpl::slotCount() const { return mSlotCount; }
+
 SymbolTableEntryImpl::SymbolTableEntryImpl(const std::string &name, const std::weak_ptr<SymbolTableImplBase>& symbol_table)
     : SymbolTableEntry(name, symbol_table), mSymbolTable(symbol_table), mName(name),
-      mDefinition(DefinitionImpl::UNDEFINED), mTypeSpec(nullptr) {
+      mDefinition(DefinitionImpl::UNDEFINED), mTypeSpec(nullptr), mSlot(-1) {
 }
 
 SymbolTableEntryImpl::~SymbolTableEntryImpl() {
@@ -141,7 +178,7 @@ void SymbolTableEntryImpl::appendLineNumber(int line_number) {
   mLineNumbers.push_back(line_number);
 }
 
-std::vector<int> SymbolTableEntryImpl::lineNumbers() const {
+const std::vector<int>& SymbolTableEntryImpl::lineNumbers() const {
   return mLineNumbers;
 }
 
@@ -163,6 +200,11 @@ std::any SymbolTableEntryImpl::getAttribute(const SymbolTableKeyTypeImpl &key) c
   }
 }
 
+std::any* SymbolTableEntryImpl::findAttribute(const SymbolTableKeyTypeImpl &key) {
+  auto search = mEntryMap.find(key);
+  return (search != mEntryMap.end()) ? &(search->second) : nullptr;
+}
+
 void SymbolTableEntryImpl::setDefinition(const DefinitionImpl& definition)
 {
   mDefinition = definition;
@@ -183,7 +225,17 @@ std::shared_ptr<TypeSpecImplBase> SymbolTableEntryImpl::getTypeSpec() const
   return mTypeSpec;
 }
 
-ICodeImpl::ICodeImpl() : ICode() {}
+void SymbolTableEntryImpl::setSlot(int slot)
+{
+  mSlot = slot;
+}
+
+int SymbolTableEntryImpl::slot() const
+{
+  return mSlot;
+}
+
+ICodeImpl::ICodeImpl() : ICode(), mArena(std::make_shared<ICodeArena>()) {}
 
 ICodeImpl::~ICodeImpl() {
 #ifdef DEBUG_DESTRUCTOR
@@ -193,12 +245,32 @@ ICodeImpl::~ICodeImpl() {
 
 void ICodeImpl::setRoot(const std::shared_ptr<ICodeNodeImplBase>& node) {
   mRoot = node;
+  mRootLoader = nullptr;
 }
 
 std::shared_ptr<ICodeNodeImplBase> ICodeImpl::getRoot() const {
+  if (mRootLoader) {
+    // the loader runs only once, even if it asks for the root again
+    const auto loader = std::exchange(mRootLoader, nullptr);
+    ICodeArena::Scope arena_scope(mArena);
+    mRoot = loader();
+  }
   return mRoot;
 }
 
+void ICodeImpl::setRootLoader(std::function<std::shared_ptr<ICodeNodeImplBase>()> loader) {
+  mRoot = nullptr;
+  mRootLoader = std::move(loader);
+}
+
+bool ICodeImpl::isLoaded() const {
+  return !mRootLoader;
+}
+
+const std::shared_ptr<ICodeArena>& ICodeImpl::arena() const {
+  return mArena;
+}
+
 ICodeNodeImpl::ICodeNodeImpl(const ICodeNodeTypeImpl &pType)
     : ICodeNodeImplBase(pType), mType(pType),
       mParent(std::weak_ptr<ICodeNodeImplBase>()), mTypeSpec(nullptr) {}
@@ -207,6 +279,24 @@ ICodeNodeImpl::~ICodeNodeImpl() {
 #ifdef DEBUG_DESTRUCTOR
   std::cerr << "Destructor: " << BOOST_CURRENT_FUNCTION << std::endl;
 #endif
+  // release the subtrees without recursion, since a long expression
+  // is a tree as deep as the number of its operands
+  std::vector<std::shared_ptr<ICodeNodeImplBase>> pending;
+  for (auto& child: mChildren) {
+    if (child != nullptr && child.use_count() == 1) {
+      pending.push_back(std::move(child));
+    }
+  }
+  while (!pending.empty()) {
+    auto node = std::move(pending.back());
+    pending.pop_back();
+    // this is the last owner: take the children before destroying the node
+    for (auto it = node->childrenBegin(); it != node->childrenEnd(); ++it) {
+      if (*it != nullptr && it->use_count() == 1) {
+        pending.push_back(std::move(*it));
+      }
+    }
+  }
 }
 
 ICodeNodeTypeImpl ICodeNodeImpl::type() const { return mType; }
@@ -226,27 +316,11 @@ ICodeNodeImpl::addChild(std::shared_ptr<ICodeNodeImplBase> node) {
   return node;
 }
 
-void ICodeNodeImpl::setAttribute(const ICodeKeyTypeImpl &key,
-                                 const std::any &value) {
-  mHashTable[key] = value;
-}
-
-std::any ICodeNodeImpl::getAttribute(const ICodeKeyTypeImpl &key) const {
-  const auto search = mHashTable.find(key);
-  if (search != mHashTable.end()) {
-    return search->second;
-  } else {
-    return std::any();
-  }
-}
-
-std::unique_ptr<ICodeNodeImplBase> ICodeNodeImpl::copy() const {
+std::shared_ptr<ICodeNodeImplBase> ICodeNodeImpl::copy() const {
   // only copy this node itself, not the parent and children!
   auto new_node = createICodeNode(this->mType);
   auto tmp_ptr = dynamic_cast<ICodeNodeImpl *>(new_node.get());
-  for (auto it = mHashTable.cbegin(); it != mHashTable.cend(); ++it) {
-    tmp_ptr->mHashTable[it->first] = it->second;
-  }
+  tmp_ptr->mAttributes = mAttributes;
   return new_node;
 }
 
@@ -341,14 +415,6 @@ std::shared_ptr<TypeSpecImplBase> ICodeNodeImpl::getTypeSpec() const
   return mTypeSpec;
 }
 
-ICodeNodeImpl::AttributeMapImpl &ICodeNodeImpl::attributeMap() {
-  return mHashTable;
-}
-
-const ICodeNodeImpl::AttributeMapImpl &ICodeNodeImpl::attributeMap() const {
-  return mHashTable;
-}
-
 ICodeNodeImpl::ChildrenContainerImpl &ICodeNodeImpl::children() {
   return mChildren;
 }
@@ -367,11 +433,16 @@ std::unique_ptr<ICodeImplBase> createICode() {
 }
 
 template <>
-std::unique_ptr<ICodeNodeImplBase> createICodeNode(const ICodeNodeTypeImpl &type) {
-  return std::make_unique<ICodeNodeImpl>(type);
+std::shared_ptr<ICodeNodeImplBase> createICodeNode(const ICodeNodeTypeImpl &type) {
+  const auto& arena = ICodeArena::current();
+  if (arena != nullptr) {
+    // the node and its control block in one bump allocation
+    return std::allocate_shared<ICodeNodeImpl>(ICodeArenaAllocator<ICodeNodeImpl>(arena), type);
+  }
+  return std::make_shared<ICodeNodeImpl>(type);
 }
 
-std::unique_ptr<ICodeNodeImplBase> createICodeNode(const ICodeNodeTypeImpl &type) {
+std::shared_ptr<ICodeNodeImplBase> createICodeNode(const ICodeNodeTypeImpl &type) {
   return createICodeNode<ICodeNodeTypeImpl, ICodeKeyTypeImpl, AttributeMapTImpl, ChildrenContainerTImpl, TypeSpecImplBase>(type);
 }
 
@@ -410,18 +481,6 @@ TypeSpecImpl::TypeSpecImpl(TypeFormImpl form)
     : TypeSpecImplBase(form),
       mForm(form), mIdentifier() {}
 
-TypeSpecImpl::TypeSpecImpl(const std::string& value)
-    : TypeSpecImplBase(value), mIdentifier() {
-  mForm = TypeFormImpl::ARRAY;
-  std::shared_ptr<TypeSpecImplBase> index_type = createType(TypeFormImpl::SUBRANGE);
-  index_type->setAttribute<TypeKeyImpl::SUBRANGE_BASE_TYPE>(Predefined::instance().integerType);
-  index_type->setAttribute<TypeKeyImpl::SUBRANGE_MIN_VALUE>(VariableValueT{1ll});
-  index_type->setAttribute<TypeKeyImpl::SUBRANGE_MAX_VALUE>(VariableValueT{static_cast<PascalInteger>(value.size())});
-  TypeSpecImpl::setAttribute(TypeKeyImpl::ARRAY_INDEX_TYPE, index_type);
-  TypeSpecImpl::setAttribute(TypeKeyImpl::ARRAY_ELEMENT_TYPE, Predefined::instance().charType);
-  TypeSpecImpl::setAttribute(TypeKeyImpl::ARRAY_ELEMENT_COUNT, static_cast<PascalInteger>(value.size()));
-}
-
 TypeSpecImpl::~TypeSpecImpl()
 {
 }
@@ -443,30 +502,22 @@ std::shared_ptr<SymbolTableEntryImplBase> TypeSpecImpl::getIdentifier() const
 
 void TypeSpecImpl::setAttribute(TypeKeyImpl key, const std::any& value)
 {
-  mTypeSpecMap[key] = value;
+  mAttributes.set(key, value);
 }
 
 std::any TypeSpecImpl::getAttribute(TypeKeyImpl key) const
 {
-  auto search = mTypeSpecMap.find(key);
-  if (search != mTypeSpecMap.end()) {
-    return search->second;
-  } else {
-    return nullptr;
-  }
+  return mAttributes.get(key);
 }
 
 bool TypeSpecImpl::isPascalString() const
 {
   if (mForm == TypeFormImpl::ARRAY) {
-    const auto element_type = std::any_cast<std::shared_ptr<TypeSpecImplBase>>(getAttribute(TypeKeyImpl::ARRAY_ELEMENT_TYPE));
-    const auto index_type = std::any_cast<std::shared_ptr<TypeSpecImplBase>>(getAttribute(TypeKeyImpl::ARRAY_INDEX_TYPE));
-    if (element_type->baseType() == Predefined::instance().charType &&
-        index_type->baseType() == Predefined::instance().integerType) {
-      return true;
-    } else {
-      return false;
-    }
+    const auto& element_type = mAttributes.get<TypeKeyImpl::ARRAY_ELEMENT_TYPE>();
+    const auto& index_type = mAttributes.get<TypeKeyImpl::ARRAY_INDEX_TYPE>();
+    return (element_type != nullptr) && (index_type != nullptr) &&
+           (element_type->rawBaseType() == Predefined::instance().charType.get()) &&
+           (index_type->rawBaseType() == Predefined::instance().integerType.get());
   } else {
     return false;
   }
@@ -475,12 +526,28 @@ bool TypeSpecImpl::isPascalString() const
 std::shared_ptr<TypeSpecImplBase> TypeSpecImpl::baseType()
 {
   if (mForm == TypeFormImpl::SUBRANGE) {
-    return std::any_cast<std::shared_ptr<TypeSpecImplBase>>(getAttribute(TypeKeyImpl::SUBRANGE_BASE_TYPE));
+    return mAttributes.get<TypeKeyImpl::SUBRANGE_BASE_TYPE>();
   } else {
     return shared_from_this();
   }
 }
 
+const TypeSpecImplBase* TypeSpecImpl::rawBaseType() const
+{
+  if (mForm == TypeFormImpl::SUBRANGE) {
+    return mAttributes.get<TypeKeyImpl::SUBRANGE_BASE_TYPE>().get();
+  } else {
+    return this;
+  }
+}
+
+std::shared_ptr<TypeSpecImplBase> TypeSpecImpl::copy() const
+{
+  auto result = std::make_shared<TypeSpecImpl>(mForm);
+  result->mAttributes = mAttributes;
+  return result;
+}
+
 std::string TypeSpecImpl::anonymousName() const {
   std::string type_form_name;
   switch (form()) {
@@ -546,6 +613,102 @@ std::unique_ptr<TypeSpecImplBase> createType(const TypeFormImpl& form) {
   return createType<SymbolTableKeyTypeImpl, DefinitionImpl, TypeFormImpl, TypeKeyImpl, AttributeMapTImpl>(form);
 }
 
-std::unique_ptr<TypeSpecImplBase> createStringType(const std::string& value) {
-  return std::make_unique<TypeSpecImpl>(value);
+namespace {
+
+// the interned anonymous types
+// the pool does not own them: they go away with the last compilation unit
+// using them, and an expired slot is refilled by the next request for its key.
+// a key may name a dead base type whose address is reused, but then the slot
+// has expired too, since an interned type holds its base types.
+struct TypePool {
+  using SubrangeKeyT = std::tuple<const TypeSpecImplBase*, VariableValueT, VariableValueT>;
+  using ArrayKeyT = std::tuple<const TypeSpecImplBase*, const TypeSpecImplBase*, std::optional<PascalInteger>>;
+  std::map<SubrangeKeyT, std::weak_ptr<TypeSpecImplBase>> subranges;
+  std::map<ArrayKeyT, std::weak_ptr<TypeSpecImplBase>> arrays;
+  // drop the expired slots when the pool has doubled since the last sweep
+  size_t sweepSize = 1024;
+};
+
+TypePool& typePool() {
+  static TypePool pool;
+  return pool;
+}
+
+void sweepTypePool(TypePool& pool) {
+  if (pool.subranges.size() + pool.arrays.size() < pool.sweepSize) return;
+  std::erase_if(pool.subranges, [](const auto& slot) { return slot.second.expired(); });
+  std::erase_if(pool.arrays, [](const auto& slot) { return slot.second.expired(); });
+  pool.sweepSize = std::max<size_t>(1024, 2 * (pool.subranges.size() + pool.arrays.size()));
+}
+
+TypePool::SubrangeKeyT subrangeKey(const TypeSpecImplBase& type_spec) {
+  return {type_spec.getAttribute<TypeKeyImpl::SUBRANGE_BASE_TYPE>().get(),
+          type_spec.getAttribute<TypeKeyImpl::SUBRANGE_MIN_VALUE>(),
+          type_spec.getAttribute<TypeKeyImpl::SUBRANGE_MAX_VALUE>()};
+}
+
+TypePool::ArrayKeyT arrayKey(const TypeSpecImplBase& type_spec) {
+  return {type_spec.getAttribute<TypeKeyImpl::ARRAY_INDEX_TYPE>().get(),
+          type_spec.getAttribute<TypeKeyImpl::ARRAY_ELEMENT_TYPE>().get(),
+          typeAttribute<TypeKeyImpl::ARRAY_ELEMENT_COUNT>(type_spec)};
+}
+
+}
+
+std::shared_ptr<TypeSpecImplBase> createSubrangeType(const std::shared_ptr<TypeSpecImplBase>& base_type,
+                                                     const VariableValueT& min_value,
+                                                     const VariableValueT& max_value) {
+  auto& pool = typePool();
+  auto& slot = pool.subranges[{base_type.get(), min_value, max_value}];
+  std::shared_ptr<TypeSpecImplBase> subrange_type = slot.lock();
+  if (subrange_type == nullptr) {
+    subrange_type = createType(TypeFormImpl::SUBRANGE);
+    subrange_type->setAttribute<TypeKeyImpl::SUBRANGE_BASE_TYPE>(base_type);
+    subrange_type->setAttribute<TypeKeyImpl::SUBRANGE_MIN_VALUE>(min_value);
+    subrange_type->setAttribute<TypeKeyImpl::SUBRANGE_MAX_VALUE>(max_value);
+    slot = subrange_type;
+    sweepTypePool(pool);
+  }
+  return subrange_type;
+}
+
+std::shared_ptr<TypeSpecImplBase> createArrayType(const std::shared_ptr<TypeSpecImplBase>& index_type,
+                                                  const std::shared_ptr<TypeSpecImplBase>& element_type,
+                                                  const std::optional<PascalInteger>& element_count) {
+  auto& pool = typePool();
+  auto& slot = pool.arrays[{index_type.get(), element_type.get(), element_count}];
+  std::shared_ptr<TypeSpecImplBase> array_type = slot.lock();
+  if (array_type == nullptr) {
+    array_type = createType(TypeFormImpl::ARRAY);
+    array_type->setAttribute<TypeKeyImpl::ARRAY_INDEX_TYPE>(index_type);
+    array_type->setAttribute<TypeKeyImpl::ARRAY_ELEMENT_TYPE>(element_type);
+    if (element_count) {
+      array_type->setAttribute<TypeKeyImpl::ARRAY_ELEMENT_COUNT>(element_count.value());
+    }
+    slot = array_type;
+    sweepTypePool(pool);
+  }
+  return array_type;
+}
+
+std::shared_ptr<TypeSpecImplBase> createStringType(const std::string& value) {
+  const auto length = static_cast<PascalInteger>(value.size());
+  const auto index_type = createSubrangeType(Predefined::instance().integerType,
+                                             VariableValueT{1ll}, VariableValueT{length});
+  return createArrayType(index_type, Predefined::instance().charType, length);
+}
+
+std::shared_ptr<TypeSpecImplBase> ownedType(const std::shared_ptr<TypeSpecImplBase>& type_spec) {
+  if (type_spec == nullptr || type_spec->getIdentifier() != nullptr) return type_spec;
+  // interned if the pool holds this very type under its key
+  const auto& pool = typePool();
+  bool interned = false;
+  if (type_spec->form() == TypeFormImpl::SUBRANGE) {
+    const auto slot = pool.subranges.find(subrangeKey(*type_spec));
+    interned = (slot != pool.subranges.end()) && (slot->second.lock() == type_spec);
+  } else if (type_spec->form() == TypeFormImpl::ARRAY) {
+    const auto slot = pool.arrays.find(arrayKey(*type_spec));
+    interned = (slot != pool.arrays.end()) && (slot->second.lock() == type_spec);
+  }
+  return interned ? type_spec->copy() : type_spec;
 }
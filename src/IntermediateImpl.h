@@ -16,22 +16,8 @@ public:
   [[nodiscard]] const std::shared_ptr<const ICodeNodeImplBase> parent() const override;
   void setParent(const std::weak_ptr<const ICodeNodeImplBase>& new_parent) override;
   std::shared_ptr<ICodeNodeImplBase> addChild(std::shared_ptr<ICodeNodeImplBase> node) override;
-  void setAttribute(const ICodeKeyTypeImpl& key, const std::any& value) override;
-  [[nodiscard]] std::any getAttribute(const ICodeKeyTypeImpl& key) const override;
-  [[nodiscard]] std::unique_ptr<ICodeNodeImplBase> copy() const override;
+  [[nodiscard]] std::shared_ptr<ICodeNodeImplBase> copy() const override;
   [[nodiscard]] std::string toString() const override;
-  attribute_map_iterator attributeMapBegin() override {
-    return attributeMap().begin();
-  }
-  attribute_map_iterator attributeMapEnd() override {
-    return attributeMap().end();
-  }
-  const_attribute_map_iterator attributeMapBegin() const override {
-    return attributeMap().cbegin();
-  }
-  const_attribute_map_iterator attributeMapEnd() const override {
-    return attributeMap().cend();
-  }
   children_iterator childrenBegin() override {
     return children().begin();
   }
@@ -50,14 +36,11 @@ public:
   void setTypeSpec(const std::shared_ptr<TypeSpecImplBase>& type_spec) override;
   [[nodiscard]] std::shared_ptr<TypeSpecImplBase> getTypeSpec() const override;
 protected:
-  virtual AttributeMapImpl& attributeMap();
-  virtual const AttributeMapImpl& attributeMap() const;
   virtual ChildrenContainerImpl& children();
   virtual const ChildrenContainerImpl& children() const;
 private:
   ICodeNodeTypeImpl mType;
   std::weak_ptr<const ICodeNodeImplBase> mParent;
-  AttributeMapImpl mHashTable;
   ChildrenContainerImpl mChildren;
   std::shared_ptr<TypeSpecImplBase> mTypeSpec;
 };
@@ -68,9 +51,14 @@ public:
   ~ICodeImpl() override;
   void setRoot(const std::shared_ptr<ICodeNodeImplBase>& node) override;
   [[nodiscard]] std::shared_ptr<ICodeNodeImplBase> getRoot() const override;
+  void setRootLoader(std::function<std::shared_ptr<ICodeNodeImplBase>()> loader) override;
+  [[nodiscard]] bool isLoaded() const override;
+  [[nodiscard]] const std::shared_ptr<ICodeArena>& arena() const override;
 
 private:
-  std::shared_ptr<ICodeNodeImplBase> mRoot;
+  mutable std::shared_ptr<ICodeNodeImplBase> mRoot;
+  mutable std::function<std::shared_ptr<ICodeNodeImplBase>()> mRootLoader;
+  std::shared_ptr<ICodeArena> mArena;
 };
 
 class SymbolTableEntryImpl : public SymbolTableEntryImplBase {
@@ -80,13 +68,16 @@ public:
   [[nodiscard]] std::string name() const override;
   [[nodiscard]] std::shared_ptr<SymbolTableImplBase> symbolTable() const override;
   void appendLineNumber(int line_number) override;
-  [[nodiscard]] std::vector<int> lineNumbers() const override;
+  [[nodiscard]] const std::vector<int>& lineNumbers() const override;
   void setAttribute(const SymbolTableKeyTypeImpl &key, const std::any &value) override;
   [[nodiscard]] std::any getAttribute(const SymbolTableKeyTypeImpl &key) const override;
+  [[nodiscard]] std::any* findAttribute(const SymbolTableKeyTypeImpl &key) override;
   void setDefinition(const DefinitionImpl& definition) override;
   [[nodiscard]] DefinitionImpl getDefinition() const override;
   void setTypeSpec(std::shared_ptr<TypeSpecImplBase> type_spec) override;
   [[nodiscard]] std::shared_ptr<TypeSpecImplBase> getTypeSpec() const override;
+  void setSlot(int slot) override;
+  [[nodiscard]] int slot() const override;
 private:
   std::weak_ptr<SymbolTableImplBase> mSymbolTable;
   std::vector<int> mLineNumbers;
@@ -94,6 +85,7 @@ private:
   AttributeMapImpl mEntryMap;
   DefinitionImpl mDefinition;
   std::shared_ptr<TypeSpecImplBase> mTypeSpec;
+  int mSlot;
 };
 
 class SymbolTableImpl : public SymbolTableImplBase {
@@ -103,10 +95,15 @@ public:
   [[nodiscard]] int nestingLevel() const override;
   [[nodiscard]] std::shared_ptr<SymbolTableEntryImplBase> lookup(const std::string &name) const override;
   std::shared_ptr<SymbolTableEntryImplBase> enter(const std::string &name) override;
+  [[nodiscard]] std::shared_ptr<SymbolTableEntryImplBase> lookup(NameId name_id) const override;
+  std::shared_ptr<SymbolTableEntryImplBase> enter(NameId name_id) override;
   [[nodiscard]] std::vector<std::shared_ptr<SymbolTableEntryImplBase>> sortedEntries() const override;
+  int allocateSlot() override;
+  [[nodiscard]] int slotCount() const override;
 private:
   int mNestingLevel;
   SymbolTableMapT mSymbolMap;
+  int mSlotCount;
 };
 
 class SymbolTableStackImpl : public SymbolTableStackImplBase {
@@ -118,6 +115,9 @@ public:
   [[nodiscard]] std::shared_ptr<SymbolTableEntryImplBase> enterLocal(const std::string &name) override;
   [[nodiscard]] std::shared_ptr<SymbolTableEntryImplBase> lookupLocal(const std::string &name) const override;
   [[nodiscard]] std::shared_ptr<SymbolTableEntryImplBase> lookup(const std::string &name) const override;
+  [[nodiscard]] std::shared_ptr<SymbolTableEntryImplBase> enterLocal(NameId name_id) override;
+  [[nodiscard]] std::shared_ptr<SymbolTableEntryImplBase> lookupLocal(NameId name_id) const override;
+  [[nodiscard]] std::shared_ptr<SymbolTableEntryImplBase> lookup(NameId name_id) const override;
   void setProgramId(const std::weak_ptr<SymbolTableEntryImplBase>& entry) override;
   [[nodiscard]] std::shared_ptr<SymbolTableEntryImplBase> programId() const override;
   std::shared_ptr<SymbolTableImplBase> push() override;
@@ -133,7 +133,6 @@ private:
 class TypeSpecImpl : public TypeSpecImplBase {
 public:
   explicit TypeSpecImpl(TypeFormImpl form);
-  explicit TypeSpecImpl(const std::string& value);
   ~TypeSpecImpl() override;
   [[nodiscard]] TypeFormImpl form() const override;
   void setIdentifier(const std::weak_ptr<SymbolTableEntryImplBase>& identifier) override;
@@ -142,11 +141,12 @@ public:
   [[nodiscard]] std::any getAttribute(TypeKeyImpl key) const override;
   [[nodiscard]] bool isPascalString() const override;
   [[nodiscard]] std::shared_ptr<TypeSpecImplBase> baseType() override;
+  [[nodiscard]] const TypeSpecImplBase* rawBaseType() const override;
+  [[nodiscard]] std::shared_ptr<TypeSpecImplBase> copy() const override;
   std::string anonymousName() const override;
 private:
   TypeFormImpl mForm;
   std::weak_ptr<SymbolTableEntryImplBase> mIdentifier;
-  typespec_map_impl mTypeSpecMap;
 };
 
 template <>
@@ -164,9 +164,16 @@ template <>
 std::unique_ptr<ICodeImplBase> createICode();
 
 template <>
-std::unique_ptr<ICodeNodeImplBase> createICodeNode(const ICodeNodeTypeImpl &type);
+std::shared_ptr<ICodeNodeImplBase> createICodeNode(const ICodeNodeTypeImpl &type);
 
 template <>
 std::unique_ptr<TypeSpecImplBase> createType(const TypeFormImpl& form);
 
+// the attribute, or nullopt if the type does not have it
+template <TypeKeyImpl KeyVal>
+std::optional<typename EnumToType<KeyVal>::type> typeAttribute(const TypeSpecImplBase& type_spec) {
+  if (!type_spec.hasAttribute(KeyVal)) return std::nullopt;
+  return type_spec.getAttribute<KeyVal>();
+}
+
 #endif // INTERMEDIATEIMPL_H
@@ -1,11 +1,12 @@
 #include "Interpreter.h"
 #include "StatementExecutor.h"
+#include "OutputBuffer.h"
 
 #include <chrono>
 
 Executor::Executor():
   Backend(), mErrorHandler(std::make_unique<RuntimeErrorHandler>()),
-  mExecutionCount(0)
+  mExecutionCount(0), mStackBase(0)
 {
 }
 
@@ -21,13 +22,23 @@ void Executor::process(
     std::shared_ptr<SymbolTableStackImplBase> symbol_table_stack) {
   mICode = iCode;
   mSymbolTableStack = symbol_table_stack;
+  const char stack_marker = 0;
+  mStackBase = reinterpret_cast<std::uintptr_t>(&stack_marker);
   const auto start_time = std::chrono::high_resolution_clock::now();
   auto root_node = iCode->getRoot();
+  // the activation record of the main program
+  const auto program_symtab = symbol_table_stack->programId()->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_SYMTAB>();
+  if (program_symtab) {
+    mRuntimeStack.push(program_symtab.value()->nestingLevel(), program_symtab.value()->slotCount());
+    mRuntimeStack.activate();
+  }
   StatementExecutor executor(std::dynamic_pointer_cast<std::remove_reference<decltype(*this)>::type>(shared_from_this()));
   executor.execute(root_node);
+  if (program_symtab) mRuntimeStack.pop();
   const auto end_time = std::chrono::high_resolution_clock::now();
   const std::chrono::duration<double> elapsed_time = end_time - start_time;
   summary(mExecutionCount, mErrorHandler->errorCount(), elapsed_time.count());
+  OutputBuffer::instance().flush();
 }
 
 SubExecutorBase::SubExecutorBase(const std::shared_ptr<Executor>& executor): mExecutor(executor)
@@ -42,9 +53,8 @@ SubExecutorBase::~SubExecutorBase()
 
 void SubExecutorBase::sendSourceLineMessage(const std::shared_ptr<ICodeNodeImplBase>& node)
 {
-  const auto line_number_obj = node->getAttribute(ICodeKeyTypeImpl::LINE);
-  if (line_number_obj.has_value()) {
-    const int line_number = cast_by_enum<ICodeKeyTypeImpl::LINE>(line_number_obj);
+  if (node->hasAttribute(ICodeKeyTypeImpl::LINE)) {
+    const int line_number = node->getAttribute<ICodeKeyTypeImpl::LINE>();
     mExecutor->sourceLineMessage(line_number);
   }
 }
@@ -63,3 +73,16 @@ int &SubExecutorBase::executionCount()
 {
   return mExecutor->mExecutionCount;
 }
+
+RuntimeStack &SubExecutorBase::runtimeStack()
+{
+  return mExecutor->mRuntimeStack;
+}
+
+size_t SubExecutorBase::nativeStackUsed() const
+{
+  // the stack grows downwards on the supported platforms
+  const char stack_marker = 0;
+  const auto here = reinterpret_cast<std::uintptr_t>(&stack_marker);
+  return (here < mExecutor->mStackBase) ? (mExecutor->mStackBase - here) : 0;
+}
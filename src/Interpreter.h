@@ -3,6 +3,9 @@
 
 #include "Backend.h"
 #include "Intermediate.h"
+#include "RuntimeStack.h"
+
+#include <cstdint>
 
 class Executor: public Backend {
 public:
@@ -21,6 +24,9 @@ public:
 private:
   std::shared_ptr<RuntimeErrorHandler> mErrorHandler;
   int mExecutionCount;
+  RuntimeStack mRuntimeStack;
+  // address near the bottom of the native stack used by the executors
+  std::uintptr_t mStackBase;
 };
 
 class SubExecutorBase {
@@ -32,6 +38,9 @@ public:
   std::shared_ptr<Executor> currentExecutor();
   std::shared_ptr<RuntimeErrorHandler> errorHandler();
   int& executionCount();
+  RuntimeStack& runtimeStack();
+  // bytes of the native stack used by the executors so far
+  size_t nativeStackUsed() const;
 private:
   std::shared_ptr<Executor> mExecutor;
 };
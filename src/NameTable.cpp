@@ -0,0 +1,91 @@
+#include "NameTable.h"
+
+namespace {
+
+// FNV-1a
+size_t hashName(std::string_view name) {
+  std::uint64_t h = 14695981039346656037ull;
+  for (const char c: name) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ull;
+  }
+  return static_cast<size_t>(h);
+}
+
+}
+
+NameTable& NameTable::instance()
+{
+  static NameTable s;
+  return s;
+}
+
+NameTable::NameTable()
+{
+  rehash(1024);
+}
+
+size_t NameTable::findSlot(std::string_view name, size_t hash) const
+{
+  const size_t mask = mSlots.size() - 1;
+  for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+    const NameId id = mSlots[i];
+    if (id == invalidNameId || (mHashes[id] == hash && mNames[id] == name)) {
+      return i;
+    }
+  }
+}
+
+void NameTable::rehash(size_t capacity)
+{
+  mSlots.assign(capacity, invalidNameId);
+  const size_t mask = capacity - 1;
+  for (NameId id = 0; id < mNames.size(); ++id) {
+    size_t i = mHashes[id] & mask;
+    while (mSlots[i] != invalidNameId) i = (i + 1) & mask;
+    mSlots[i] = id;
+  }
+}
+
+NameId NameTable::intern(std::string_view name)
+{
+  const size_t hash = hashName(name);
+  size_t i = findSlot(name, hash);
+  if (mSlots[i] != invalidNameId) {
+    return mSlots[i];
+  }
+  const auto id = static_cast<NameId>(mNames.size());
+  mNames.emplace_back(name);
+  mHashes.push_back(hash);
+  mSlots[i] = id;
+  // keep the load factor below 1/2
+  if (2 * mNames.size() > mSlots.size()) {
+    rehash(2 * mSlots.size());
+  }
+  return id;
+}
+
+NameId NameTable::internLower(std::string_view name)
+{
+  mLowerBuffer.resize(name.size());
+  for (size_t i = 0; i < name.size(); ++i) {
+    const char c = name[i];
+    mLowerBuffer[i] = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+  }
+  return intern(mLowerBuffer);
+}
+
+NameId NameTable::find(std::string_view name) const
+{
+  return mSlots[findSlot(name, hashName(name))];
+}
+
+const std::string& NameTable::name(NameId id) const
+{
+  return mNames.at(id);
+}
+
+size_t NameTable::size() const
+{
+  return mNames.size();
+}
@@ -0,0 +1,113 @@
+#ifndef NAMETABLE_H
+#define NAMETABLE_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// small integer id of an interned name
+using NameId = std::uint32_t;
+inline constexpr NameId invalidNameId = static_cast<NameId>(-1);
+
+// global table of interned identifier names
+// the scanner interns every identifier once, so that the parsers and
+// the symbol tables can compare and hash names as integers.
+// not thread-safe: only the thread running the parser should intern names.
+class NameTable {
+public:
+  static NameTable& instance();
+  // return the id of the name, interning it if necessary
+  NameId intern(std::string_view name);
+  // same as intern, but lowercase the name first
+  NameId internLower(std::string_view name);
+  // return the id of the name, or invalidNameId if it was never interned
+  [[nodiscard]] NameId find(std::string_view name) const;
+  [[nodiscard]] const std::string& name(NameId id) const;
+  [[nodiscard]] size_t size() const;
+  NameTable(const NameTable&) = delete;
+  NameTable& operator=(const NameTable&) = delete;
+private:
+  NameTable();
+  [[nodiscard]] size_t findSlot(std::string_view name, size_t hash) const;
+  void rehash(size_t capacity);
+  // id -> name, the deque keeps the references stable
+  std::deque<std::string> mNames;
+  std::vector<size_t> mHashes;
+  // open addressing table of ids, invalidNameId marks an empty slot
+  std::vector<NameId> mSlots;
+  std::string mLowerBuffer;
+};
+
+// open addressing hash map keyed by interned names
+template <typename ValueT>
+class FlatIdMap {
+public:
+  FlatIdMap(): mSize(0), mShift(64) {}
+  [[nodiscard]] const ValueT* find(NameId id) const {
+    if (mSize == 0) return nullptr;
+    const size_t mask = mKeys.size() - 1;
+    for (size_t i = slot(id); ; i = (i + 1) & mask) {
+      if (mKeys[i] == id) return &mValues[i];
+      if (mKeys[i] == invalidNameId) return nullptr;
+    }
+  }
+  ValueT* find(NameId id) {
+    return const_cast<ValueT*>(std::as_const(*this).find(id));
+  }
+  // return the value of the id, inserting a default value if it is missing
+  ValueT& operator[](NameId id) {
+    // keep the load factor below 1/2
+    if (2 * (mSize + 1) > mKeys.size()) {
+      rehash(mKeys.empty() ? 8 : 2 * mKeys.size());
+    }
+    const size_t mask = mKeys.size() - 1;
+    size_t i = slot(id);
+    while (mKeys[i] != id) {
+      if (mKeys[i] == invalidNameId) {
+        mKeys[i] = id;
+        ++mSize;
+        break;
+      }
+      i = (i + 1) & mask;
+    }
+    return mValues[i];
+  }
+  [[nodiscard]] size_t size() const { return mSize; }
+  [[nodiscard]] bool empty() const { return mSize == 0; }
+  // call f(id, value) for each element in unspecified order
+  template <typename F>
+  void forEach(F&& f) const {
+    for (size_t i = 0; i < mKeys.size(); ++i) {
+      if (mKeys[i] != invalidNameId) f(mKeys[i], mValues[i]);
+    }
+  }
+private:
+  [[nodiscard]] size_t slot(NameId id) const {
+    // Fibonacci hashing spreads the consecutive ids
+    return static_cast<size_t>((static_cast<std::uint64_t>(id) * 0x9E3779B97F4A7C15ull) >> mShift);
+  }
+  void rehash(size_t capacity) {
+    std::vector<NameId> keys(capacity, invalidNameId);
+    std::vector<ValueT> values(capacity);
+    std::swap(keys, mKeys);
+    std::swap(values, mValues);
+    mShift = 64 - static_cast<unsigned>(__builtin_ctzll(capacity));
+    const size_t mask = capacity - 1;
+    for (size_t j = 0; j < keys.size(); ++j) {
+      if (keys[j] == invalidNameId) continue;
+      size_t i = slot(keys[j]);
+      while (mKeys[i] != invalidNameId) i = (i + 1) & mask;
+      mKeys[i] = keys[j];
+      mValues[i] = std::move(values[j]);
+    }
+  }
+  std::vector<NameId> mKeys;
+  std::vector<ValueT> mValues;
+  size_t mSize;
+  unsigned mShift;
+};
+
+#endif // NAMETABLE_H
@@ -0,0 +1,89 @@
+#include "OutputBuffer.h"
+
+#include <charconv>
+#include <iostream>
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#define OUTPUT_DETECT_TERMINAL
+#endif
+
+OutputBuffer& OutputBuffer::instance()
+{
+  static OutputBuffer output;
+  return output;
+}
+
+OutputBuffer::OutputBuffer(): mLineBuffered(false)
+{
+#ifdef OUTPUT_DETECT_TERMINAL
+  mLineBuffered = (isatty(STDOUT_FILENO) != 0);
+#endif
+  mBuffer.reserve(CAPACITY);
+}
+
+OutputBuffer::~OutputBuffer()
+{
+#ifdef DEBUG_DESTRUCTOR
+  std::cerr << "Destructor: " << BOOST_CURRENT_FUNCTION << std::endl;
+#endif
+  // also reached through std::exit()
+  flush();
+}
+
+void OutputBuffer::writeInteger(PascalInteger value, int width)
+{
+  char digits[24];
+  const auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+  const auto length = static_cast<size_t>(result.ptr - digits);
+  pad(length, width);
+  mBuffer.append(digits, length);
+  afterWrite();
+}
+
+void OutputBuffer::writeReal(PascalFloat value, int width, int precision)
+{
+  fmt::format_to(std::back_inserter(mBuffer), "{:>{}.{}f}", value, width, precision);
+  afterWrite();
+}
+
+void OutputBuffer::writeString(std::string_view value, int width)
+{
+  pad(value.size(), width);
+  mBuffer.append(value);
+  afterWrite();
+}
+
+void OutputBuffer::newline()
+{
+  mBuffer.push_back('\n');
+  if (mLineBuffered) {
+    flush();
+  } else {
+    afterWrite();
+  }
+}
+
+void OutputBuffer::flush()
+{
+  if (mBuffer.empty()) return;
+  std::fwrite(mBuffer.data(), 1, mBuffer.size(), stdout);
+  std::fflush(stdout);
+  mBuffer.clear();
+}
+
+void OutputBuffer::pad(size_t length, int width)
+{
+  if (width > 0 && length < static_cast<size_t>(width)) {
+    mBuffer.append(static_cast<size_t>(width) - length, ' ');
+  }
+}
+
+void OutputBuffer::afterWrite()
+{
+  if (mBuffer.size() >= CAPACITY) {
+    flush();
+  } else if (mLineBuffered && !mBuffer.empty() && mBuffer.back() == '\n') {
+    flush();
+  }
+}
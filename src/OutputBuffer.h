@@ -0,0 +1,46 @@
+#ifndef OUTPUTBUFFER_H
+#define OUTPUTBUFFER_H
+
+#include "Common.h"
+
+#include <fmt/format.h>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+// buffered standard output of the interpreter
+// the program output and the interpreter messages are formatted straight
+// into one large buffer, which goes to stdout when it is full, on flush(),
+// and after every line if stdout is a terminal.
+// everything printed to stdout while a program runs must go through this
+// buffer, or flush() must be called first, to keep the order of the lines.
+class OutputBuffer {
+public:
+  static OutputBuffer& instance();
+  ~OutputBuffer();
+  OutputBuffer(const OutputBuffer&) = delete;
+  OutputBuffer& operator=(const OutputBuffer&) = delete;
+  template <typename... Args>
+  void print(fmt::format_string<Args...> format, Args&&... args) {
+    fmt::format_to(std::back_inserter(mBuffer), format, std::forward<Args>(args)...);
+    afterWrite();
+  }
+  // the Pascal write formats, right-aligned in width
+  void writeInteger(PascalInteger value, int width);
+  // fixed point with precision digits
+  void writeReal(PascalFloat value, int width, int precision);
+  void writeString(std::string_view value, int width);
+  void newline();
+  // hand the buffered text over to stdout
+  void flush();
+private:
+  OutputBuffer();
+  void pad(size_t length, int width);
+  void afterWrite();
+  static const size_t CAPACITY = 1 << 16;
+  std::string mBuffer;
+  bool mLineBuffered;
+};
+
+#endif // OUTPUTBUFFER_H
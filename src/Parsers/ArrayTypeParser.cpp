@@ -2,7 +2,7 @@
 #include "SimpleTypeParser.h"
 #include "TypeSpecificationParser.h"
 
-ArrayTypeParser::ArrayTypeParser(const std::shared_ptr<PascalParserTopDown>& parent): PascalSubparserTopDownBase(parent)
+ArrayTypeParser::ArrayTypeParser(PascalParserTopDown& parent): PascalSubparserTopDownBase(parent)
 {
 
 }
@@ -14,7 +14,6 @@ ArrayTypeParser::~ArrayTypeParser()
 
 std::shared_ptr<TypeSpecImplBase> ArrayTypeParser::parseSpec(std::shared_ptr<PascalToken> token)
 {
-  auto array_type = std::shared_ptr(createType(TypeFormImpl::ARRAY));
   // consume ARRAY
   nextToken();
   // synchronize at [
@@ -23,7 +22,7 @@ std::shared_ptr<TypeSpecImplBase> ArrayTypeParser::parseSpec(std::shared_ptr<Pas
     errorHandler()->flag(token, PascalErrorCode::MISSING_LEFT_BRACKET, currentParser());
   }
   // parse the list of index types
-  auto element_type = parseIndexTypeList(token, array_type);
+  const auto index_types = parseIndexTypeList(token);
   // synchronize ]
   token = synchronize(ArrayTypeParser::rightBracketSet());
   if (token->type() != PascalTokenTypeImpl::RIGHT_BRACKET) {
@@ -39,15 +38,20 @@ std::shared_ptr<TypeSpecImplBase> ArrayTypeParser::parseSpec(std::shared_ptr<Pas
   } else {
     errorHandler()->flag(token, PascalErrorCode::MISSING_OF, currentParser());
   }
-  element_type->setAttribute<TypeKeyImpl::ARRAY_ELEMENT_TYPE>(parseElementType(token));
+  // array[i, j] of t is array[i] of array[j] of t,
+  // built from the innermost dimension since the array types are interned
+  auto array_type = parseElementType(token);
+  for (auto it = index_types.rbegin(); it != index_types.rend(); ++it) {
+    array_type = createArrayType(it->first, array_type, it->second);
+  }
   return array_type;
 }
 
-std::shared_ptr<TypeSpecImplBase> ArrayTypeParser::parseIndexTypeList(
-  std::shared_ptr<PascalToken>& token, std::shared_ptr<TypeSpecImplBase> array_type)
+std::vector<ArrayTypeParser::IndexT> ArrayTypeParser::parseIndexTypeList(std::shared_ptr<PascalToken>& token)
 {
-  auto element_type = array_type;
+  std::vector<IndexT> index_types;
   bool another_index = false;
+  bool missing_comma = false;
   // consume [
   token = nextToken();
   // parse the list of index type specifications
@@ -55,7 +59,10 @@ std::shared_ptr<TypeSpecImplBase> ArrayTypeParser::parseIndexTypeList(
     another_index = false;
     // parse the index type
     token = synchronize(ArrayTypeParser::indexStartSet());
-    parseIndexType(token, element_type);
+    // an index after a missing comma replaces the previous one
+    if (missing_comma) index_types.pop_back();
+    missing_comma = false;
+    index_types.push_back(parseIndexType(token));
     // synchronize at the , token
     token = synchronize(ArrayTypeParser::indexFollowSet());
     const auto token_type = token->type();
@@ -64,47 +71,41 @@ std::shared_ptr<TypeSpecImplBase> ArrayTypeParser::parseIndexTypeList(
       if (ArrayTypeParser::indexStartSet().contains(token_type)) {
         errorHandler()->flag(token, PascalErrorCode::MISSING_COMMA, currentParser());
         another_index = true;
+        missing_comma = true;
       }
     } else if (token_type == PascalTokenTypeImpl::COMMA) {
-      auto new_element_type = std::shared_ptr(createType(TypeFormImpl::ARRAY));
-      element_type->setAttribute<TypeKeyImpl::ARRAY_ELEMENT_TYPE>(new_element_type);
-      // is this work?
-      element_type = std::move(new_element_type);
       token = nextToken();
       another_index = true;
     }
   } while (another_index);
-  return element_type;
+  return index_types;
 }
 
-void ArrayTypeParser::parseIndexType(std::shared_ptr<PascalToken>& token,
-                                     const std::shared_ptr<TypeSpecImplBase>& array_type)
+ArrayTypeParser::IndexT ArrayTypeParser::parseIndexType(std::shared_ptr<PascalToken>& token)
 {
   SimpleTypeParser simple_type_parser(currentParser());
   const auto index_type = simple_type_parser.parseSpec(token);
-  array_type->setAttribute<TypeKeyImpl::ARRAY_INDEX_TYPE>(index_type);
   if (index_type == nullptr) {
-    return;
+    return {nullptr, std::nullopt};
   }
   const auto form = index_type->form();
   PascalInteger count = 0;
   // check the index type and set the element count
   if (form == TypeFormImpl::SUBRANGE) {
-    const auto min_value = index_type->getAttribute<TypeKeyImpl::SUBRANGE_MIN_VALUE>();
-    const auto max_value = index_type->getAttribute<TypeKeyImpl::SUBRANGE_MAX_VALUE>();
-    if (std::holds_alternative<PascalInteger>(max_value) &&
+    const auto& min_value = index_type->getAttribute<TypeKeyImpl::SUBRANGE_MIN_VALUE>();
+    const auto& max_value = index_type->getAttribute<TypeKeyImpl::SUBRANGE_MAX_VALUE>();
+    if (std::holds_alternative<PascalInteger>(min_value) &&
         std::holds_alternative<PascalInteger>(max_value)) {
       count = std::get<PascalInteger>(max_value) - std::get<PascalInteger>(min_value) + 1;
     }
   } else if (form == TypeFormImpl::ENUMERATION) {
-    const auto constants = index_type->getAttribute(TypeKeyImpl::ENUMERATION_CONSTANTS);
-    if (constants.has_value()) {
-      count = static_cast<PascalInteger>(cast_by_enum<TypeKeyImpl::ENUMERATION_CONSTANTS>(constants).size());
+    if (index_type->hasAttribute(TypeKeyImpl::ENUMERATION_CONSTANTS)) {
+      count = static_cast<PascalInteger>(index_type->getAttribute<TypeKeyImpl::ENUMERATION_CONSTANTS>().size());
     }
   } else {
     errorHandler()->flag(token, PascalErrorCode::INVALID_INDEX_TYPE, currentParser());
   }
-  array_type->setAttribute<TypeKeyImpl::ARRAY_ELEMENT_COUNT>(count);
+  return {index_type, count};
 }
 
 std::shared_ptr<TypeSpecImplBase> ArrayTypeParser::parseElementType(std::shared_ptr<PascalToken> token)
@@ -121,7 +122,7 @@ PascalSubparserTopDownBase::TokenTypeSet ArrayTypeParser::leftBracketSet() {
 }
 
 PascalSubparserTopDownBase::TokenTypeSet ArrayTypeParser::rightBracketSet() {
-  PascalSubparserTopDownBase::TokenTypeSet s{
+  constexpr PascalSubparserTopDownBase::TokenTypeSet s{
     PascalTokenTypeImpl::RIGHT_BRACKET,
     PascalTokenTypeImpl::OF,
     PascalTokenTypeImpl::SEMICOLON};
@@ -148,7 +149,7 @@ PascalSubparserTopDownBase::TokenTypeSet ArrayTypeParser::indexFollowSet() {
 }
 
 PascalSubparserTopDownBase::TokenTypeSet ArrayTypeParser::indexEndSet() {
-  PascalSubparserTopDownBase::TokenTypeSet s{
+  constexpr PascalSubparserTopDownBase::TokenTypeSet s{
     PascalTokenTypeImpl::RIGHT_BRACKET,
     PascalTokenTypeImpl::OF,
     PascalTokenTypeImpl::SEMICOLON
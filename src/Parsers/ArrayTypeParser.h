@@ -4,6 +4,10 @@
 #include "PascalFrontend.h"
 #include "Intermediate.h"
 
+#include <optional>
+#include <utility>
+#include <vector>
+
 // Pascal array type examples:
 // ========================================================
 // type
@@ -27,14 +31,14 @@ public:
   static TokenTypeSet indexStartSet();
   static TokenTypeSet indexFollowSet();
   static TokenTypeSet indexEndSet();
-  explicit ArrayTypeParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit ArrayTypeParser(PascalParserTopDown& parent);
   virtual ~ArrayTypeParser();
   std::shared_ptr<TypeSpecImplBase> parseSpec(std::shared_ptr<PascalToken> token);
 private:
-  std::shared_ptr<TypeSpecImplBase> parseIndexTypeList(
-    std::shared_ptr<PascalToken>& token, std::shared_ptr<TypeSpecImplBase> array_type);
-  void parseIndexType(std::shared_ptr<PascalToken>& token,
-                      const std::shared_ptr<TypeSpecImplBase>& array_type);
+  // an index type and the element count it gives
+  using IndexT = std::pair<std::shared_ptr<TypeSpecImplBase>, std::optional<PascalInteger>>;
+  std::vector<IndexT> parseIndexTypeList(std::shared_ptr<PascalToken>& token);
+  IndexT parseIndexType(std::shared_ptr<PascalToken>& token);
   std::shared_ptr<TypeSpecImplBase> parseElementType(std::shared_ptr<PascalToken> token);
 };
 
@@ -4,7 +4,7 @@
 #include "VariableParser.h"
 #include "TypeChecker.h"
 
-AssignmentStatementParser::AssignmentStatementParser(const std::shared_ptr<PascalParserTopDown>& parent):
+AssignmentStatementParser::AssignmentStatementParser(PascalParserTopDown& parent):
 PascalSubparserTopDownBase(parent), isFunctionTarget(false)
 {
 
@@ -2,7 +2,7 @@
 #include "StatementParser.h"
 #include "DeclarationsParser.h"
 
-BlockParser::BlockParser(const std::shared_ptr<PascalParserTopDown>& parent)
+BlockParser::BlockParser(PascalParserTopDown& parent)
     : PascalSubparserTopDownBase(parent) {}
 
 /* In pascal, the statements are followed by variable declarations.
@@ -27,10 +27,29 @@ end;
 std::shared_ptr<ICodeNodeImplBase> BlockParser::parse(std::shared_ptr<PascalToken> token,
                    std::shared_ptr<SymbolTableEntryImplBase> parent_id) {
   DeclarationsParser declarations_parser(currentParser());
-  StatementParser statement_parser(currentParser());
   // parse any declarations
   declarations_parser.parse(token, parent_id);
   token = synchronize(StatementParser::statementStartSet());
+  return parseStatements(token, parent_id);
+}
+
+void BlockParser::parseDeferred(std::shared_ptr<PascalToken> token,
+                                std::shared_ptr<SymbolTableEntryImplBase> parent_id,
+                                ICodeImplBase& intermediate_code) {
+  DeclarationsParser declarations_parser(currentParser());
+  declarations_parser.parse(token, parent_id);
+  token = synchronize(StatementParser::statementStartSet());
+  if (token->type() == PascalTokenTypeImpl::BEGIN) {
+    currentParser().deferStatements(parent_id, intermediate_code);
+  } else {
+    // report a missing BEGIN now
+    intermediate_code.setRoot(parseStatements(token, parent_id));
+  }
+}
+
+std::shared_ptr<ICodeNodeImplBase> BlockParser::parseStatements(std::shared_ptr<PascalToken> token,
+                   std::shared_ptr<SymbolTableEntryImplBase> parent_id) {
+  StatementParser statement_parser(currentParser());
   const auto token_type = token->type();
   std::shared_ptr<ICodeNodeImplBase> root_node = nullptr;
   if (token_type == PascalTokenTypeImpl::BEGIN) {
@@ -6,9 +6,15 @@
 class BlockParser : public PascalSubparserTopDownBase
 {
 public:
-  explicit BlockParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit BlockParser(PascalParserTopDown& parent);
   virtual std::shared_ptr<ICodeNodeImplBase>
   parse(std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> parent_id) override;
+  // parse the declarations, but leave the statements to the ICode of the routine
+  void parseDeferred(std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> parent_id,
+                     ICodeImplBase& intermediate_code);
+private:
+  std::shared_ptr<ICodeNodeImplBase>
+  parseStatements(std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> parent_id);
 };
 
 #endif // BLOCKPARSER_H
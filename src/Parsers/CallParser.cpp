@@ -3,7 +3,7 @@
 #include "ExpressionParser.h"
 #include "TypeChecker.h"
 
-CallParser::CallParser(const std::shared_ptr <PascalParserTopDown> &parent) : PascalSubparserTopDownBase(parent) {
+CallParser::CallParser(PascalParserTopDown& parent) : PascalSubparserTopDownBase(parent) {
 
 }
 
@@ -13,7 +13,7 @@ CallParser::~CallParser() {
 
 std::shared_ptr<ICodeNodeImplBase>
 CallParser::parse(std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> parent_id) {
-  auto pfId = getSymbolTableStack()->lookup(boost::algorithm::to_lower_copy(token->text()));
+  auto pfId = getSymbolTableStack()->lookup(tokenNameId(*token));
   auto routine_code = pfId->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_CODE>();
   // I think this is ill-formed
 //  StatementParser parser =
@@ -36,7 +36,7 @@ std::shared_ptr<ICodeNodeImplBase>
 CallParser::parseActualParameters(std::shared_ptr<PascalToken> token, const std::shared_ptr<SymbolTableEntryImplBase>& pfId,
                                   bool isDeclared, bool isReadReadln, bool isWriteWriteln) {
   auto expressionParser = ExpressionParser(currentParser());
-  auto parmsNode = to_shared(createICodeNode(ICodeNodeTypeImpl::PARAMETERS));
+  auto parmsNode = createICodeNode(ICodeNodeTypeImpl::PARAMETERS);
   std::vector<std::shared_ptr<SymbolTableEntryImplBase>> formalParms;
   int parmCount = 0;
   int parmIndex = -1;
@@ -155,7 +155,7 @@ PascalSubparserTopDownBase::TokenTypeSet CallParser::commaSet() {
   return s;
 }
 
-CallDeclaredParser::CallDeclaredParser(const std::shared_ptr<PascalParserTopDown> &parent) : CallParser(
+CallDeclaredParser::CallDeclaredParser(PascalParserTopDown& parent) : CallParser(
     parent) {
 
 }
@@ -168,8 +168,8 @@ CallDeclaredParser::~CallDeclaredParser() {
 std::shared_ptr<ICodeNodeImplBase>
 CallDeclaredParser::parse(std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> parent_id) {
   // create the CALL node
-  auto callNode = to_shared(createICodeNode(ICodeNodeTypeImpl::CALL));
-  auto pfId = getSymbolTableStack()->lookup(boost::algorithm::to_lower_copy(token->text()));
+  auto callNode = createICodeNode(ICodeNodeTypeImpl::CALL);
+  auto pfId = getSymbolTableStack()->lookup(tokenNameId(*token));
   callNode->setAttribute<ICodeKeyTypeImpl::ID>(pfId);
   callNode->setTypeSpec(pfId->getTypeSpec());
   // consume procedure of function identifier
@@ -179,7 +179,7 @@ CallDeclaredParser::parse(std::shared_ptr<PascalToken> token, std::shared_ptr<Sy
   return callNode;
 }
 
-CallStandardParser::CallStandardParser(const std::shared_ptr<PascalParserTopDown> &parent) : CallParser(
+CallStandardParser::CallStandardParser(PascalParserTopDown& parent) : CallParser(
     parent) {
 
 }
@@ -191,8 +191,8 @@ CallStandardParser::~CallStandardParser() {
 // function calls to the standard functions
 std::shared_ptr<ICodeNodeImplBase>
 CallStandardParser::parse(std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> parent_id) {
-  auto callNode = to_shared(createICodeNode(ICodeNodeTypeImpl::CALL));
-  auto pfId = getSymbolTableStack()->lookup(boost::algorithm::to_lower_copy(token->text()));
+  auto callNode = createICodeNode(ICodeNodeTypeImpl::CALL);
+  auto pfId = getSymbolTableStack()->lookup(tokenNameId(*token));
   auto routineCode = pfId->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_CODE>();
   callNode->setAttribute<ICodeKeyTypeImpl::ID>(pfId);
   token = nextToken();
@@ -7,7 +7,7 @@ class CallParser : public PascalSubparserTopDownBase
 {
 public:
   static TokenTypeSet commaSet();
-  explicit CallParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit CallParser(PascalParserTopDown& parent);
   virtual ~CallParser() override;
   virtual std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> parent_id) override;
@@ -25,7 +25,7 @@ private:
 class CallDeclaredParser : public CallParser
 {
 public:
-  explicit CallDeclaredParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit CallDeclaredParser(PascalParserTopDown& parent);
   virtual ~CallDeclaredParser() override;
   virtual std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> parent_id) override;
@@ -34,7 +34,7 @@ public:
 class CallStandardParser : public  CallParser
 {
 public:
-  explicit CallStandardParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit CallStandardParser(PascalParserTopDown& parent);
   virtual ~CallStandardParser() override;
   virtual std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> parent_id) override;
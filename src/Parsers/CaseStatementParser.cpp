@@ -4,7 +4,7 @@
 #include "TypeChecker.h"
 //#include "ExpressionExecutor.h"
 
-CaseStatementParser::CaseStatementParser(const std::shared_ptr<PascalParserTopDown>& parent)
+CaseStatementParser::CaseStatementParser(PascalParserTopDown& parent)
     : PascalSubparserTopDownBase(parent) {}
 
 std::shared_ptr<ICodeNodeImplBase> CaseStatementParser::parse(
@@ -34,7 +34,7 @@ std::shared_ptr<ICodeNodeImplBase> CaseStatementParser::parse(
     errorHandler()->flag(token, PascalErrorCode::MISSING_OF, currentParser());
   }
   // record the branch constants to avoid duplicates
-  std::vector<VariableValueT> constant_set;
+  CaseConstantSetT constant_set;
   // loop to parse each CASE until the END token
   while (!token->isEof() && token->type() != PascalTokenTypeImpl::END) {
     select_node->addChild(parseBranch(token, constant_set, expr_type));
@@ -64,7 +64,7 @@ std::shared_ptr<ICodeNodeImplBase> CaseStatementParser::parse(
 
 std::shared_ptr<ICodeNodeImplBase>
 CaseStatementParser::parseBranch(std::shared_ptr<PascalToken> token,
-                                 std::vector<VariableValueT> &constant_set,
+                                 CaseConstantSetT &constant_set,
                                  const std::shared_ptr<TypeSpecImplBase>& expression_type) {
   // create an SELECT_BRANCH node and a SELECT_CONSTANTS node
   auto branch_node = std::shared_ptr(createICodeNode(ICodeNodeTypeImpl::SELECT_BRANCH));
@@ -88,7 +88,7 @@ CaseStatementParser::parseBranch(std::shared_ptr<PascalToken> token,
 
 void CaseStatementParser::parseConstantList(std::shared_ptr<PascalToken> token,
     std::shared_ptr<ICodeNodeImplBase>& constants_node,
-    std::vector<VariableValueT> &constant_set, const std::shared_ptr<TypeSpecImplBase>& expression_type) {
+    CaseConstantSetT &constant_set, const std::shared_ptr<TypeSpecImplBase>& expression_type) {
   // loop to parse each constant
   const auto constant_start_set = CaseStatementParser::constantStartSet();
 //  auto search = constant_start_set.find(token->type());
@@ -112,7 +112,7 @@ void CaseStatementParser::parseConstantList(std::shared_ptr<PascalToken> token,
 
 std::shared_ptr<ICodeNodeImplBase>
 CaseStatementParser::parseConstant(std::shared_ptr<PascalToken> token,
-                                   std::vector<VariableValueT> &constant_set,
+                                   CaseConstantSetT &constant_set,
                                    const std::shared_ptr<TypeSpecImplBase>& expression_type) {
   token = synchronize(CaseStatementParser::constantStartSet());
   std::shared_ptr<ICodeNodeImplBase> constant_node = nullptr;
@@ -155,14 +155,9 @@ CaseStatementParser::parseConstant(std::shared_ptr<PascalToken> token,
     const auto constant_value = constant_node->type() == ICodeNodeTypeImpl::NEGATE ?
                                 VariableValueT(getNegateNodeValue(constant_node)) :
         constant_node->getAttribute<ICodeKeyTypeImpl::VALUE>();
-    const bool in_constant_set = std::any_of(
-        constant_set.begin(), constant_set.end(),
-        [&](const auto &a) { return a == constant_value; });
-    if (in_constant_set) {
+    if (!constant_set.insert(constant_value).second) {
       errorHandler()->flag(token, PascalErrorCode::CASE_CONSTANT_REUSED,
                            currentParser());
-    } else {
-      constant_set.push_back(constant_value);
     }
   }
   // type check: the constant type must be comparison compatible with the CASE expression type
@@ -180,7 +175,7 @@ std::shared_ptr<ICodeNodeImplBase> CaseStatementParser::parseIdentifierConstant(
   std::shared_ptr<ICodeNodeImplBase> constant_node = nullptr;
   std::shared_ptr<TypeSpecImplBase> constant_type = nullptr;
   // lookup the identifier in the symbol table stack
-  const auto name = boost::to_lower_copy(token->text());
+  const auto name = tokenNameId(*token);
   auto id = getSymbolTableStack()->lookup(name);
   // undefined
   if (id == nullptr) {
@@ -264,7 +259,7 @@ PascalInteger CaseStatementParser::getNegateNodeValue(const std::shared_ptr<ICod
 }
 
 PascalSubparserTopDownBase::TokenTypeSet CaseStatementParser::constantStartSet() {
-  PascalSubparserTopDownBase::TokenTypeSet s{
+  constexpr PascalSubparserTopDownBase::TokenTypeSet s{
     PascalTokenTypeImpl::IDENTIFIER,
     PascalTokenTypeImpl::INTEGER,
     PascalTokenTypeImpl::PLUS,
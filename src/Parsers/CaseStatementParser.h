@@ -3,23 +3,27 @@
 
 #include "PascalFrontend.h"
 
+#include <unordered_set>
+
 class CaseStatementParser : public PascalSubparserTopDownBase {
 public:
   static TokenTypeSet constantStartSet();
   static TokenTypeSet ofSet();
   static TokenTypeSet commaSet();
-  explicit CaseStatementParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit CaseStatementParser(PascalParserTopDown& parent);
   std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token,
       std::shared_ptr<SymbolTableEntryImplBase> parent_id) override;
 private:
+  // the constants of the branches seen so far, to flag the duplicates
+  using CaseConstantSetT = std::unordered_set<VariableValueT>;
   virtual std::shared_ptr<ICodeNodeImplBase> parseBranch(std::shared_ptr<PascalToken> token,
-              std::vector<VariableValueT> &constant_set, const std::shared_ptr<TypeSpecImplBase>& expression_type);
+              CaseConstantSetT &constant_set, const std::shared_ptr<TypeSpecImplBase>& expression_type);
   virtual void parseConstantList(std::shared_ptr<PascalToken> token,
       std::shared_ptr<ICodeNodeImplBase>& constants_node,
-      std::vector<VariableValueT> &constant_set, const std::shared_ptr<TypeSpecImplBase>& expression_type);
+      CaseConstantSetT &constant_set, const std::shared_ptr<TypeSpecImplBase>& expression_type);
   virtual std::shared_ptr<ICodeNodeImplBase> parseConstant(std::shared_ptr<PascalToken> token,
-                std::vector<VariableValueT> &constant_set, const std::shared_ptr<TypeSpecImplBase>& expression_type);
+                CaseConstantSetT &constant_set, const std::shared_ptr<TypeSpecImplBase>& expression_type);
   virtual std::shared_ptr<ICodeNodeImplBase> parseIdentifierConstant(const std::shared_ptr<PascalToken>& token,
                           PascalTokenTypeImpl sign);
   virtual std::shared_ptr<ICodeNodeImplBase>
@@ -1,7 +1,7 @@
 #include "CompoundStatementParser.h"
 #include "StatementParser.h"
 
-CompoundStatementParser::CompoundStatementParser(const std::shared_ptr<PascalParserTopDown> &parent)
+CompoundStatementParser::CompoundStatementParser(PascalParserTopDown& parent)
   : PascalSubparserTopDownBase(parent) {}
 
 CompoundStatementParser::~CompoundStatementParser()
@@ -6,7 +6,7 @@
 class CompoundStatementParser : public PascalSubparserTopDownBase
 {
 public:
-  explicit CompoundStatementParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit CompoundStatementParser(PascalParserTopDown& parent);
   virtual ~CompoundStatementParser();
   virtual std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token,
@@ -2,7 +2,7 @@
 #include "DeclarationsParser.h"
 #include "ExpressionParser.h"
 
-ConstantDefinitionsParser::ConstantDefinitionsParser(const std::shared_ptr<PascalParserTopDown>& parent)
+ConstantDefinitionsParser::ConstantDefinitionsParser(PascalParserTopDown& parent)
   : PascalSubparserTopDownBase(parent) {}
 
 ConstantDefinitionsParser::~ConstantDefinitionsParser()
@@ -19,7 +19,7 @@ std::shared_ptr<ICodeNodeImplBase> ConstantDefinitionsParser::parse(
   const auto next_start_set = ConstantDefinitionsParser::nextStartSet();
   // loop to parse a sequence of constant definitions
   while (token->type() == PascalTokenTypeImpl::IDENTIFIER) {
-    const auto name = boost::algorithm::to_lower_copy(token->text());
+    const auto name = tokenNameId(*token);
     auto constant_id = getSymbolTableStack()->lookupLocal(name);
     // enter the new identifier into the symbol table
     if (constant_id == nullptr) {
@@ -197,7 +197,7 @@ PascalSubparserTopDownBase::TokenTypeSet ConstantDefinitionsParser::identifierSe
 }
 
 PascalSubparserTopDownBase::TokenTypeSet ConstantDefinitionsParser::constantStartSet() {
-  PascalSubparserTopDownBase::TokenTypeSet s{
+  constexpr PascalSubparserTopDownBase::TokenTypeSet s{
     PascalTokenTypeImpl::IDENTIFIER,
     PascalTokenTypeImpl::INTEGER,
     PascalTokenTypeImpl::REAL,
@@ -12,7 +12,7 @@ public:
   static TokenTypeSet constantStartSet();
   static TokenTypeSet equalsSet();
   static TokenTypeSet nextStartSet();
-  explicit ConstantDefinitionsParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit ConstantDefinitionsParser(PascalParserTopDown& parent);
   ~ConstantDefinitionsParser() override;
   std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token,
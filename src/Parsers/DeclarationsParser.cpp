@@ -4,7 +4,7 @@
 #include "VariableDeclarationsParser.h"
 #include "DeclaredRoutineParser.h"
 
-DeclarationsParser::DeclarationsParser(const std::shared_ptr<PascalParserTopDown>& parent)
+DeclarationsParser::DeclarationsParser(PascalParserTopDown& parent)
   : PascalSubparserTopDownBase(parent) {}
 
 DeclarationsParser::~DeclarationsParser()
@@ -56,7 +56,7 @@ std::shared_ptr<ICodeNodeImplBase> DeclarationsParser::parse(
 }
 
 PascalSubparserTopDownBase::TokenTypeSet DeclarationsParser::declarationStartSet() {
-  PascalSubparserTopDownBase::TokenTypeSet s{
+  constexpr PascalSubparserTopDownBase::TokenTypeSet s{
     PascalTokenTypeImpl::CONST,     PascalTokenTypeImpl::TYPE,
     PascalTokenTypeImpl::VAR,       PascalTokenTypeImpl::PROCEDURE,
     PascalTokenTypeImpl::FUNCTION,  PascalTokenTypeImpl::BEGIN
@@ -11,7 +11,7 @@ public:
   static TokenTypeSet typeStartSet();
   static TokenTypeSet varStartSet();
   static TokenTypeSet routineStartSet();
-  explicit DeclarationsParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit DeclarationsParser(PascalParserTopDown& parent);
   virtual ~DeclarationsParser();
   virtual std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token,
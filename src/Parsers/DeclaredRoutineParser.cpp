@@ -4,7 +4,7 @@
 #include "BlockParser.h"
 #include <fmt/format.h>
 
-DeclaredRoutineParser::DeclaredRoutineParser(const std::shared_ptr<PascalParserTopDown> &parent)
+DeclaredRoutineParser::DeclaredRoutineParser(PascalParserTopDown& parent)
     : PascalSubparserTopDownBase(parent), mRootNode(nullptr), mDummyCounter(0) {
 
 }
@@ -67,11 +67,9 @@ std::shared_ptr<SymbolTableEntryImplBase> DeclaredRoutineParser::parseToSymbolTa
     getSymbolTableStack()->setProgramId(routine_id);
   } else if (!current_routine_code || (current_routine_code.value() != RoutineCodeImpl::forward)) {
     // non-forwarded procedure of function: append to the parent's list of routines
-    auto subroutines = parent_id->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_ROUTINES>();
-    // set it back?
-    if (subroutines) {
-      subroutines.value().push_back(routine_id);
-      parent_id->setAttribute<SymbolTableKeyTypeImpl::ROUTINE_ROUTINES>(subroutines.value());
+    // in place, since copying the list for every routine is quadratic
+    if (auto subroutines = parent_id->findAttribute<SymbolTableKeyTypeImpl::ROUTINE_ROUTINES>()) {
+      subroutines->push_back(routine_id);
     }
   }
   // if the routine was forwarded, there should not be any formal parameters or a function return type.
@@ -98,15 +96,22 @@ std::shared_ptr<SymbolTableEntryImplBase> DeclaredRoutineParser::parseToSymbolTa
   // create new intermediate code for the routine
   auto intermediate_code = std::shared_ptr<ICodeImplBase>(createICode());
   if ((token->type() == PascalTokenTypeImpl::IDENTIFIER) &&
-      (boost::algorithm::to_lower_copy(token->text()) == "forward")) {
+      (tokenNameId(*token) == NameTable::instance().intern("forward"))) {
     // consume "forward"
     token = nextToken();
     routine_id->setAttribute<SymbolTableKeyTypeImpl::ROUTINE_CODE>(RoutineCodeImpl::forward);
   } else {
     routine_id->setAttribute<SymbolTableKeyTypeImpl::ROUTINE_CODE>(RoutineCodeImpl::declared);
+    // the nodes of the routine body go to its own arena
+    ICodeArena::Scope arena_scope(intermediate_code->arena());
     BlockParser block_parser(currentParser());
-    mRootNode = block_parser.parse(token, routine_id);
-    intermediate_code->setRoot(mRootNode);
+    // the statements of the main program are always needed
+    if (currentParser().defersRoutineBodies() && (routine_defn != DefinitionImpl::PROGRAM)) {
+      block_parser.parseDeferred(token, routine_id, *intermediate_code);
+    } else {
+      mRootNode = block_parser.parse(token, routine_id);
+      intermediate_code->setRoot(mRootNode);
+    }
   }
   routine_id->setAttribute<SymbolTableKeyTypeImpl::ROUTINE_ICODE>(intermediate_code);
   getSymbolTableStack()->pop();
@@ -118,7 +123,7 @@ DeclaredRoutineParser::parseRoutineName(std::shared_ptr<PascalToken> token, cons
   std::shared_ptr<SymbolTableEntryImplBase> routine_id = nullptr;
   // parse the routine name identifier
   if (token->type() == PascalTokenTypeImpl::IDENTIFIER) {
-    const auto routine_name = boost::algorithm::to_lower_copy(token->text());
+    const auto routine_name = tokenNameId(*token);
     routine_id = getSymbolTableStack()->lookupLocal(routine_name);
     // not already defined locally: enter into the local symbol table
     if (routine_id == nullptr) {
@@ -163,6 +168,8 @@ void DeclaredRoutineParser::parseHeader(
       type = Predefined::instance().undefinedType;
     }
     routine_id->setTypeSpec(type);
+    // the result follows the parameters in the function's activation record
+    routine_id->setSlot(getSymbolTableStack()->localSymbolTable()->allocateSlot());
     token = currentToken();
   }
 }
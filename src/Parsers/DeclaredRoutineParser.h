@@ -11,7 +11,7 @@ public:
   static TokenTypeSet rightParenSet();
   static TokenTypeSet parameterFollowSet();
   static TokenTypeSet commaSet();
-  explicit DeclaredRoutineParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit DeclaredRoutineParser(PascalParserTopDown& parent);
   virtual ~DeclaredRoutineParser();
   std::shared_ptr<SymbolTableEntryImplBase> parseToSymbolTableEntry(
       std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> parent_id);
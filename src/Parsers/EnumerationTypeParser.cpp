@@ -1,7 +1,7 @@
 #include "EnumerationTypeParser.h"
 #include "DeclarationsParser.h"
 
-EnumerationTypeParser::EnumerationTypeParser(const std::shared_ptr<PascalParserTopDown>& parent): PascalSubparserTopDownBase(parent)
+EnumerationTypeParser::EnumerationTypeParser(PascalParserTopDown& parent): PascalSubparserTopDownBase(parent)
 {
 
 }
@@ -49,7 +49,7 @@ void EnumerationTypeParser::parseEnumerationIdentifier(
 {
   const auto token_type = token->type();
   if (token_type == PascalTokenTypeImpl::IDENTIFIER) {
-    const auto name = boost::algorithm::to_lower_copy(token->text());
+    const auto name = tokenNameId(*token);
     auto constant_id = getSymbolTableStack()->lookupLocal(name);
     if (constant_id != nullptr) {
       errorHandler()->flag(token, PascalErrorCode::IDENTIFIER_REDEFINED, currentParser());
@@ -68,7 +68,7 @@ void EnumerationTypeParser::parseEnumerationIdentifier(
 }
 
 PascalSubparserTopDownBase::TokenTypeSet EnumerationTypeParser::enumConstantStartSet() {
-  TokenTypeSet s{
+  constexpr TokenTypeSet s{
     PascalTokenTypeImpl::IDENTIFIER,
     PascalTokenTypeImpl::COMMA
   };
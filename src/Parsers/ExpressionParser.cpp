@@ -3,7 +3,7 @@
 #include "TypeChecker.h"
 #include "CallParser.h"
 
-ExpressionParser::ExpressionParser(const std::shared_ptr<PascalParserTopDown>& parent):
+ExpressionParser::ExpressionParser(PascalParserTopDown& parent):
   PascalSubparserTopDownBase(parent)
 {
 
@@ -16,264 +16,269 @@ ExpressionParser::~ExpressionParser()
 //#endif
 }
 
+namespace {
+
+// from the loosest to the tightest binding
+enum class Precedence {
+  // the bottom of the whole expression or of a parenthesized one
+  PARENTHESIS,
+  RELATIONAL,
+  ADDITIVE,
+  // a leading sign applies to the first term of a simple expression
+  SIGN,
+  MULTIPLICATIVE,
+  // NOT applies to a single factor
+  NOT
+};
+
+}
+
+struct ExpressionParser::PendingOperator {
+  Precedence precedence;
+  PascalTokenTypeImpl op;
+  ICodeNodeTypeImpl nodeType;
+  // the left operand of a binary operator
+  std::shared_ptr<ICodeNodeImplBase> left;
+  // the token to flag if the type check fails
+  std::shared_ptr<PascalToken> token;
+  // for parentheses: the enclosing one, and whether
+  // the relational operator has already been seen
+  size_t outer;
+  bool hasRelational;
+};
+
 std::shared_ptr<ICodeNodeImplBase> ExpressionParser::parse(
     std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> parent_id)
 {
-  using namespace TypeChecker::TypeCompatibility;
-  // parse a simple expression and make the root of its tree the root node
-  auto root_node = std::shared_ptr(parseSimpleExpression(token));
-  auto result_type = (root_node != nullptr) ? root_node->getTypeSpec() : Predefined::instance().undefinedType;
-  token = currentToken();
-  const auto token_type = token->type();
-  const auto search = relOpsMap.find(token_type);
-  if (search != relOpsMap.end()) {
-    // relational operator found
-    const auto node_type = relOpsMap.at(token_type);
-    auto op_node = std::shared_ptr(createICodeNode(node_type));
-    op_node->addChild(std::move(root_node));
-    // now root_node should be nullptr
-    // consume the operator
-    token = nextToken();
-    // parse the second simple expression
-    auto simple_expr_node = std::shared_ptr(parseSimpleExpression(token));
-    // type check: the operands must be comparison compatible
-    const auto simple_expr_type = (simple_expr_node != nullptr) ? simple_expr_node->getTypeSpec() : Predefined::instance().undefinedType;
-    if (areComparisonCompatible(result_type, simple_expr_type)) {
-      result_type = Predefined::instance().booleanType;
-    } else {
-      errorHandler()->flag(token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
-      result_type = Predefined::instance().undefinedType;
+  // operator precedence parsing with explicit stacks, so that long or
+  // deeply parenthesized expressions do not recurse on the C++ stack.
+  // the shapes of the trees and the order of the error messages are
+  // the same as with the recursive expression, simple expression,
+  // term and factor productions
+  std::vector<PendingOperator> pending;
+  pending.push_back({Precedence::PARENTHESIS, PascalTokenTypeImpl::UNKNOWN,
+                     ICodeNodeTypeImpl::NO_OP, nullptr, nullptr, 0, false});
+  size_t parenthesis = 0;
+  std::shared_ptr<ICodeNodeImplBase> operand = nullptr;
+  // a sign is only allowed at the start of a simple expression
+  bool sign_allowed = true;
+  while (true) {
+    // parse an operand
+    auto token_type = token->type();
+    if (sign_allowed && (token_type == PascalTokenTypeImpl::PLUS ||
+                         token_type == PascalTokenTypeImpl::MINUS)) {
+      pending.push_back({Precedence::SIGN, token_type, ICodeNodeTypeImpl::NEGATE, nullptr, token, 0, false});
+      token = nextToken();
+      token_type = token->type();
+    }
+    sign_allowed = false;
+    switch (token_type) {
+      case PascalTokenTypeImpl::IDENTIFIER: {
+        operand = parseIdentifier(token);
+        break;
+      }
+      case PascalTokenTypeImpl::INTEGER:
+      case PascalTokenTypeImpl::REAL:
+      case PascalTokenTypeImpl::STRING: {
+        operand = parseConstant(token);
+        token = nextToken();
+        break;
+      }
+      case PascalTokenTypeImpl::NOT: {
+        token = nextToken();
+        pending.push_back({Precedence::NOT, PascalTokenTypeImpl::NOT, ICodeNodeTypeImpl::NOT, nullptr, token, 0, false});
+        continue;
+      }
+      case PascalTokenTypeImpl::LEFT_PAREN: {
+        // consume the (
+        token = nextToken();
+        pending.push_back({Precedence::PARENTHESIS, PascalTokenTypeImpl::LEFT_PAREN,
+                           ICodeNodeTypeImpl::NO_OP, nullptr, nullptr, parenthesis, false});
+        parenthesis = pending.size() - 1;
+        sign_allowed = true;
+        continue;
+      }
+      default: {
+        errorHandler()->flag(token, PascalErrorCode::UNEXPECTED_TOKEN, currentParser());
+        operand = nullptr;
+        break;
+      }
+    }
+    // look for an operator after the operand
+    while (true) {
+      token = currentToken();
+      const auto op = token_type = token->type();
+      Precedence precedence;
+      decltype(relOpsMap)::const_iterator search;
+      if ((search = multOpsMap.find(op)) != multOpsMap.end()) {
+        precedence = Precedence::MULTIPLICATIVE;
+      } else if ((search = addOpsMap.find(op)) != addOpsMap.end()) {
+        precedence = Precedence::ADDITIVE;
+      } else if ((search = relOpsMap.find(op)) != relOpsMap.end() &&
+                 !pending[parenthesis].hasRelational) {
+        // an expression has at most one relational operator
+        precedence = Precedence::RELATIONAL;
+      } else {
+        // the end of the (parenthesized) expression
+        while (pending.size() - 1 > parenthesis) {
+          reduce(pending.back(), operand);
+          pending.pop_back();
+        }
+        if (parenthesis == 0) {
+          return operand;
+        }
+        parenthesis = pending.back().outer;
+        pending.pop_back();
+        if (op == PascalTokenTypeImpl::RIGHT_PAREN) {
+          // consume )
+          token = nextToken();
+        } else {
+          errorHandler()->flag(token, PascalErrorCode::MISSING_RIGHT_PAREN, currentParser());
+        }
+        // the parenthesized expression is an operand of the enclosing one
+        continue;
+      }
+      // left associative
+      while (pending.back().precedence >= precedence) {
+        reduce(pending.back(), operand);
+        pending.pop_back();
+      }
+      if (precedence == Precedence::RELATIONAL) {
+        pending[parenthesis].hasRelational = true;
+        sign_allowed = true;
+      }
+      // consume the operator
+      token = nextToken();
+      pending.push_back({precedence, op, search->second, std::move(operand), token, 0, false});
+      break;
     }
-    op_node->addChild(simple_expr_node);
-    root_node = std::move(op_node);
-    root_node->setTypeSpec(result_type);
   }
-  return root_node;
 }
 
-std::shared_ptr<ICodeNodeImplBase> ExpressionParser::parseFactor(std::shared_ptr<PascalToken> token)
+void ExpressionParser::reduce(PendingOperator& pending, std::shared_ptr<ICodeNodeImplBase>& operand)
 {
-  std::shared_ptr<ICodeNodeImplBase> root_node = nullptr;
-  auto token_type = token->type();
-  auto symbol_table_stack = getSymbolTableStack();
-  switch (token_type) {
-    case PascalTokenTypeImpl::IDENTIFIER: {
-      // lookup the identifier in the symbol table stack
-      // flag the identifier as undefined if it's not found
-      root_node = parseIdentifier(token);
-      break;
+  using namespace TypeChecker::TypeChecking;
+  using namespace TypeChecker::TypeCompatibility;
+  const auto& predefined = Predefined::instance();
+  const auto operand_type = (operand != nullptr) ? operand->getTypeSpec() : predefined.undefinedType;
+  switch (pending.precedence) {
+    case Precedence::NOT: {
+      auto not_node = std::shared_ptr(createICodeNode(ICodeNodeTypeImpl::NOT));
+      if (operand != nullptr) {
+        if (!isBoolean(operand_type)) {
+          errorHandler()->flag(pending.token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
+        }
+      }
+      not_node->setTypeSpec(operand_type);
+      not_node->addChild(std::move(operand));
+      operand = std::move(not_node);
+      return;
     }
-    case PascalTokenTypeImpl::INTEGER: {
-      root_node = createICodeNode(ICodeNodeTypeImpl::INTEGER_CONSTANT);
-      root_node->setAttribute<ICodeKeyTypeImpl::VALUE>(token->value());
-      root_node->setTypeSpec(Predefined::instance().integerType);
-      token = nextToken();
-      break;
+    case Precedence::SIGN: {
+      // type check: leading sign
+      if (!isIntegerOrReal(operand_type)) {
+        errorHandler()->flag(pending.token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
+      }
+      // was there a leading minus sign?
+      if (pending.op == PascalTokenTypeImpl::MINUS) {
+        // create a NEGATE node and adopt the current tree
+        auto negate_node = std::shared_ptr(createICodeNode(ICodeNodeTypeImpl::NEGATE));
+        negate_node->setTypeSpec(operand_type);
+        negate_node->addChild(std::move(operand));
+        operand = std::move(negate_node);
+      }
+      return;
     }
-    case PascalTokenTypeImpl::REAL: {
-      root_node = createICodeNode(ICodeNodeTypeImpl::REAL_CONSTANT);
-      root_node->setAttribute<ICodeKeyTypeImpl::VALUE>(token->value());
-      root_node->setTypeSpec(Predefined::instance().realType);
-      token = nextToken();
+    default: {
       break;
     }
-    case PascalTokenTypeImpl::STRING: {
-      const std::string s = std::get<std::string>(token->value());
-      root_node = createICodeNode(ICodeNodeTypeImpl::STRING_CONSTANT);
-      root_node->setAttribute<ICodeKeyTypeImpl::VALUE>(s);
-      root_node->setTypeSpec(s.size() == 1 ? Predefined::instance().charType : createStringType(s));
-      token = nextToken();
+  }
+  // binary operators: the operator node adopts both operands
+  auto result_type = (pending.left != nullptr) ? pending.left->getTypeSpec() : predefined.undefinedType;
+  auto op_node = std::shared_ptr(createICodeNode(pending.nodeType));
+  op_node->addChild(std::move(pending.left));
+  op_node->addChild(std::move(operand));
+  using enum PascalTokenTypeImpl;
+  switch (pending.op) {
+    case PLUS:
+    case MINUS:
+    case STAR: {
+      if (areBothInteger(result_type, operand_type)) {
+        // both are integer
+        result_type = predefined.integerType;
+      } else if (isAtLeastOneReal(result_type, operand_type)) {
+        result_type = predefined.realType;
+      } else {
+        errorHandler()->flag(pending.token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
+      }
       break;
     }
-    case PascalTokenTypeImpl::NOT: {
-      token = nextToken();
-      root_node = createICodeNode(ICodeNodeTypeImpl::NOT);
-      // parse the factor. The NOT node adopts it as child
-      auto factor_node = parseFactor(token);
-      if (factor_node != nullptr) {
-        using namespace TypeChecker::TypeChecking;
-        if (!isBoolean(factor_node->getTypeSpec())) {
-          errorHandler()->flag(token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
-        }
-        root_node->setTypeSpec(factor_node->getTypeSpec());
+    case SLASH: {
+      // all integer and real operand combinations are real results
+      if (areBothInteger(result_type, operand_type) ||
+          isAtLeastOneReal(result_type, operand_type)) {
+        result_type = predefined.realType;
       } else {
-        root_node->setTypeSpec(Predefined::instance().undefinedType);
+        errorHandler()->flag(pending.token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
       }
-      root_node->addChild(factor_node);
       break;
     }
-    case PascalTokenTypeImpl::LEFT_PAREN: {
-      // consume the (
-      token = nextToken();
-      // parse the expression as the root node
-      root_node = parse(token, nullptr);
-      if (root_node == nullptr) {
-        root_node->setTypeSpec(Predefined::instance().undefinedType);
+    case DIV:
+    case MOD: {
+      if (areBothInteger(result_type, operand_type)) {
+        result_type = predefined.integerType;
+      } else {
+        errorHandler()->flag(pending.token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
       }
-      token = currentToken();
-      if (token->type() == PascalTokenTypeImpl::RIGHT_PAREN) {
-        // consume )
-        token = nextToken();
+      break;
+    }
+    case AND:
+    case OR: {
+      if (areBothBoolean(result_type, operand_type)) {
+        result_type = predefined.booleanType;
       } else {
-        errorHandler()->flag(token, PascalErrorCode::MISSING_RIGHT_PAREN, currentParser());
+        errorHandler()->flag(pending.token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
       }
       break;
     }
     default: {
-      errorHandler()->flag(token, PascalErrorCode::UNEXPECTED_TOKEN, currentParser());
+      // type check: the operands must be comparison compatible
+      if (areComparisonCompatible(result_type, operand_type)) {
+        result_type = predefined.booleanType;
+      } else {
+        errorHandler()->flag(pending.token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
+        result_type = predefined.undefinedType;
+      }
       break;
     }
   }
-  return root_node;
+  op_node->setTypeSpec(result_type);
+  operand = std::move(op_node);
 }
 
-std::shared_ptr<ICodeNodeImplBase> ExpressionParser::parseTerm(std::shared_ptr<PascalToken> token)
+std::shared_ptr<ICodeNodeImplBase> ExpressionParser::parseConstant(const std::shared_ptr<PascalToken>& token)
 {
-
-  // parse a factor and make its node the root node
-  auto root_node = parseFactor(token);
-  auto result_type = (root_node != nullptr) ? root_node->getTypeSpec() : Predefined::instance().undefinedType;
-  token = currentToken();
-  auto token_type = token->type();
-  while (multOpsMap.find(token_type) != multOpsMap.end()) {
-    const auto op = token_type;
-    const auto node_type = multOpsMap.at(op);
-    auto op_node = std::shared_ptr(createICodeNode(node_type));
-    op_node->addChild(std::move(root_node));
-    token = nextToken();
-    auto factor_node = parseFactor(token);
-    const auto factor_type = (factor_node != nullptr) ? factor_node->getTypeSpec() : Predefined::instance().undefinedType;
-    op_node->addChild(factor_node);
-    using enum PascalTokenTypeImpl;
-    using namespace TypeChecker::TypeChecking;
-    switch (op) {
-      case STAR: {
-        if (areBothInteger(result_type, factor_type)) {
-          // both are integer
-          result_type = Predefined::instance().integerType;
-        } else if (isAtLeastOneReal(result_type, factor_type)) {
-          result_type = Predefined::instance().realType;
-        } else {
-          errorHandler()->flag(token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
-        }
-        break;
-      }
-      case SLASH: {
-        // all integer and real operand combinations are real results
-        if (areBothInteger(result_type, factor_type) ||
-            isAtLeastOneReal(result_type, factor_type)) {
-          result_type = Predefined::instance().realType;
-        } else {
-          errorHandler()->flag(token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
-        }
-        break;
-      }
-      case DIV:
-      case MOD: {
-        if (areBothInteger(result_type, factor_type)) {
-          result_type = Predefined::instance().integerType;
-        } else {
-          errorHandler()->flag(token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
-        }
-        break;
-      }
-      case AND: {
-        if (areBothBoolean(result_type, factor_type)) {
-          result_type = Predefined::instance().booleanType;
-        } else {
-          errorHandler()->flag(token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
-        }
-        break;
-      }
-      default: {
-        errorHandler()->flag(token, PascalErrorCode::INVALID_EXPRESSION, currentParser());
-      }
+  std::shared_ptr<ICodeNodeImplBase> root_node = nullptr;
+  switch (token->type()) {
+    case PascalTokenTypeImpl::INTEGER: {
+      root_node = createConstantNode(ICodeNodeTypeImpl::INTEGER_CONSTANT, token->value(),
+                                     Predefined::instance().integerType);
+      break;
     }
-    root_node = std::move(op_node);
-    root_node->setTypeSpec(result_type);
-    token = currentToken();
-    token_type = token->type();
-  }
-  return root_node;
-}
-
-std::shared_ptr<ICodeNodeImplBase> ExpressionParser::parseSimpleExpression(std::shared_ptr<PascalToken> token)
-{
-  using namespace TypeChecker::TypeChecking;
-  auto token_type = token->type();
-  auto sign_type = PascalTokenTypeImpl::UNKNOWN;
-  // save the token for error reporting
-  auto sign_token = token;
-  // look for a leading + or - sign
-  if ((token_type == PascalTokenTypeImpl::PLUS) ||
-      (token_type == PascalTokenTypeImpl::MINUS)) {
-    sign_type = token_type;
-    sign_token = token;
-    token = nextToken();
-  }
-  auto root_node = parseTerm(token);
-  auto result_type = (root_node != nullptr) ? root_node->getTypeSpec() : Predefined::instance().undefinedType;
-  // type check: leading sign
-  if ((sign_type == PascalTokenTypeImpl::PLUS ||
-       sign_type == PascalTokenTypeImpl::MINUS) &&
-      !isIntegerOrReal(result_type)) {
-    errorHandler()->flag(sign_token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
-  }
-  // was there a leading minus sign?
-  if (sign_type == PascalTokenTypeImpl::MINUS) {
-    // create a NEGATE node and adopt the current tree
-    auto negate_node = std::shared_ptr(createICodeNode(ICodeNodeTypeImpl::NEGATE));
-    negate_node->setTypeSpec(root_node->getTypeSpec());
-    negate_node->addChild(std::move(root_node));
-    root_node = std::move(negate_node);
-  }
-  token = currentToken();
-  token_type = token->type();
-  // loop over additive operators
-  while (addOpsMap.contains(token_type)) {
-    const auto op = token_type;
-    // create a new operator node and adopt the current tree
-    // as its first child
-    const auto node_type = addOpsMap.at(op);
-    auto op_node = std::shared_ptr(createICodeNode(node_type));
-    op_node->addChild(std::move(root_node));
-    // consume the operator
-    token = nextToken();
-    // parse another term
-    auto term_node = parseTerm(token);
-    const auto term_type = (term_node != nullptr) ? term_node->getTypeSpec() : Predefined::instance().undefinedType;
-    op_node->addChild(term_node);
-    using enum PascalTokenTypeImpl;
-    switch (op) {
-      case PLUS:
-      case MINUS: {
-        if (areBothInteger(result_type, term_type)) {
-          // both are integer
-          result_type = Predefined::instance().integerType;
-        } else if (isAtLeastOneReal(result_type, term_type)) {
-          result_type = Predefined::instance().realType;
-        } else {
-          errorHandler()->flag(token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
-        }
-        break;
-      }
-      case OR: {
-        if (areBothBoolean(result_type, term_type)) {
-          result_type = Predefined::instance().booleanType;
-        } else {
-          errorHandler()->flag(token, PascalErrorCode::INCOMPATIBLE_TYPES, currentParser());
-        }
-        break;
-      }
-      default: {
-        errorHandler()->flag(token, PascalErrorCode::INVALID_EXPRESSION, currentParser());
-      }
+    case PascalTokenTypeImpl::REAL: {
+      root_node = createConstantNode(ICodeNodeTypeImpl::REAL_CONSTANT, token->value(),
+                                     Predefined::instance().realType);
+      break;
+    }
+    case PascalTokenTypeImpl::STRING: {
+      const std::string& s = std::get<std::string>(token->value());
+      root_node = createConstantNode(ICodeNodeTypeImpl::STRING_CONSTANT, token->value(),
+                                     s.size() == 1 ? Predefined::instance().charType : createStringType(s));
+      break;
+    }
+    default: {
+      BUG("not a constant");
     }
-    // the operator node becomes the new root node
-    root_node = std::move(op_node);
-    root_node->setTypeSpec(result_type);
-    token = currentToken();
-    token_type = token->type();
   }
   return root_node;
 }
@@ -283,7 +288,7 @@ std::shared_ptr<ICodeNodeImplBase> ExpressionParser::parseIdentifier(std::shared
   // TODO: type checking
   std::shared_ptr<ICodeNodeImplBase> root_node = nullptr;
   auto symbol_table_stack = getSymbolTableStack();
-  auto name = boost::algorithm::to_lower_copy(token->text());
+  auto name = tokenNameId(*token);
   auto id = symbol_table_stack->lookup(name);
   if (id == nullptr) {
     errorHandler()->flag(token, PascalErrorCode::IDENTIFIER_UNDEFINED, currentParser());
@@ -299,34 +304,27 @@ std::shared_ptr<ICodeNodeImplBase> ExpressionParser::parseIdentifier(std::shared
       const auto type_spec = id->getTypeSpec();
       if (value) {
         if (std::holds_alternative<PascalInteger>(value.value())) {
-          root_node = createICodeNode(ICodeNodeTypeImpl::INTEGER_CONSTANT);
-          root_node->setAttribute<ICodeKeyTypeImpl::VALUE>(value.value());
+          root_node = createConstantNode(ICodeNodeTypeImpl::INTEGER_CONSTANT, value.value(), type_spec);
         } else if (std::holds_alternative<PascalFloat>(value.value())) {
-          root_node = createICodeNode(ICodeNodeTypeImpl::REAL_CONSTANT);
-          root_node->setAttribute<ICodeKeyTypeImpl::VALUE>(value.value());
+          root_node = createConstantNode(ICodeNodeTypeImpl::REAL_CONSTANT, value.value(), type_spec);
         } else if (std::holds_alternative<std::string>(value.value())) {
-          root_node = createICodeNode(ICodeNodeTypeImpl::STRING_CONSTANT);
-          root_node->setAttribute<ICodeKeyTypeImpl::VALUE>(value.value());
+          root_node = createConstantNode(ICodeNodeTypeImpl::STRING_CONSTANT, value.value(), type_spec);
         }
       } else {
         BUG("empty val");
       }
       id->appendLineNumber(token->lineNum());
       token = nextToken();
-      if (root_node != nullptr) {
-        root_node->setTypeSpec(type_spec);
-      }
       break;
     }
     case DefinitionImpl::ENUMERATION_CONSTANT: {
       const auto value = id->getAttribute<SymbolTableKeyTypeImpl::CONSTANT_VALUE>();
       const auto type_spec = id->getTypeSpec();
-      root_node = std::shared_ptr(createICodeNode(ICodeNodeTypeImpl::INTEGER_CONSTANT));
-      if (value) root_node->setAttribute<ICodeKeyTypeImpl::VALUE>(value.value());
-      else BUG("empty val");
+      if (!value) BUG("empty val");
+      root_node = createConstantNode(ICodeNodeTypeImpl::INTEGER_CONSTANT,
+                                     value.value_or(VariableValueT{}), type_spec);
       id->appendLineNumber(token->lineNum());
       token = nextToken();
-      root_node->setTypeSpec(type_spec);
       break;
     }
     case DefinitionImpl::FUNCTION: {
@@ -349,7 +347,7 @@ std::shared_ptr<ICodeNodeImplBase> ExpressionParser::parseIdentifier(std::shared
 }
 
 PascalSubparserTopDownBase::TokenTypeSet ExpressionParser::expressionStartSet() {
-  PascalSubparserTopDownBase::TokenTypeSet s{
+  constexpr PascalSubparserTopDownBase::TokenTypeSet s{
     PascalTokenTypeImpl::PLUS,
     PascalTokenTypeImpl::MINUS,
     PascalTokenTypeImpl::IDENTIFIER,
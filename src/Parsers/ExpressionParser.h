@@ -9,15 +9,17 @@ class ExpressionParser : public PascalSubparserTopDownBase
 {
 public:
   static TokenTypeSet expressionStartSet();
-  explicit ExpressionParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit ExpressionParser(PascalParserTopDown& parent);
   ~ExpressionParser() override;
   std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token,
       std::shared_ptr<SymbolTableEntryImplBase> parent_id) override;
 private:
-  std::shared_ptr<ICodeNodeImplBase> parseFactor(std::shared_ptr<PascalToken> token);
-  std::shared_ptr<ICodeNodeImplBase> parseTerm(std::shared_ptr<PascalToken> token);
-  std::shared_ptr<ICodeNodeImplBase> parseSimpleExpression(std::shared_ptr<PascalToken> token);
+  // an operator waiting for its right operand
+  struct PendingOperator;
+  // combine a pending operator with the operand, and type check
+  void reduce(PendingOperator& pending, std::shared_ptr<ICodeNodeImplBase>& operand);
+  std::shared_ptr<ICodeNodeImplBase> parseConstant(const std::shared_ptr<PascalToken>& token);
   std::shared_ptr<ICodeNodeImplBase> parseIdentifier(std::shared_ptr<PascalToken> token);
 };
 
@@ -4,7 +4,7 @@
 #include "StatementParser.h"
 #include "TypeChecker.h"
 
-ForStatementParser::ForStatementParser(const std::shared_ptr<PascalParserTopDown> &parent)
+ForStatementParser::ForStatementParser(PascalParserTopDown& parent)
     : PascalSubparserTopDownBase(parent) {}
 
 std::shared_ptr<ICodeNodeImplBase> ForStatementParser::parse(
@@ -43,9 +43,15 @@ std::shared_ptr<ICodeNodeImplBase> ForStatementParser::parse(
   auto rel_op_node = std::shared_ptr(createICodeNode(
       direction == PascalTokenTypeImpl::TO ? ICodeNodeTypeImpl::GT
                                            : ICodeNodeTypeImpl::LT));
-  // copy the control VARIABLE node from the assignment node
+  // copy the control VARIABLE node from the assignment node,
+  // or share it in the DAG mode: all its users are in this FOR statement,
+  // so a runtime error in its subscripts reports the same line from any of them
   auto control_variable_node = *(init_assign_node->childrenBegin());
-  rel_op_node->addChild(std::move(control_variable_node->copy()));
+  const bool shared = (currentParser().nodePool() != nullptr);
+  const auto control_variable = [&control_variable_node, shared]() {
+    return shared ? control_variable_node : control_variable_node->copy();
+  };
+  rel_op_node->addChild(control_variable());
   // parse the termination expression
   ExpressionParser expression_parser(currentParser());
   auto expr_node = expression_parser.parse(token, parent_id);
@@ -70,16 +76,15 @@ std::shared_ptr<ICodeNodeImplBase> ForStatementParser::parse(
   loop_node->addChild(statement_parser.parse(token, parent_id));
   // create an assignment with a copy of the control variable to advance the value of it
   auto next_assign_node = std::shared_ptr(createICodeNode(ICodeNodeTypeImpl::ASSIGN));
-  next_assign_node->addChild(std::move(control_variable_node->copy()));
+  next_assign_node->addChild(control_variable());
   // create the arithmetic operator node
   // ADD for TO, or SUBTRACT for DOWNTO
   auto arithmetic_op_node = std::shared_ptr(createICodeNode(
       direction == PascalTokenTypeImpl::TO ? ICodeNodeTypeImpl::ADD
                                            : ICodeNodeTypeImpl::SUBTRACT));
-  arithmetic_op_node->addChild(std::move(control_variable_node->copy()));
-  auto one_node = std::shared_ptr(createICodeNode(ICodeNodeTypeImpl::INTEGER_CONSTANT));
-  one_node->setAttribute<ICodeKeyTypeImpl::VALUE>(PascalInteger(1));
-  arithmetic_op_node->addChild(std::move(one_node));
+  arithmetic_op_node->addChild(control_variable());
+  arithmetic_op_node->addChild(createConstantNode(ICodeNodeTypeImpl::INTEGER_CONSTANT, PascalInteger(1),
+                                                  Predefined::instance().integerType));
   // the next ASSIGN node adopts the arithmetic operator node as its second child,
   next_assign_node->addChild(std::move(arithmetic_op_node));
   setLineNumber(next_assign_node, target_token);
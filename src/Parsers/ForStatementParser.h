@@ -8,7 +8,7 @@ class ForStatementParser : public PascalSubparserTopDownBase
 public:
   static TokenTypeSet toDownToSet();
   static TokenTypeSet doSet();
-  explicit ForStatementParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit ForStatementParser(PascalParserTopDown& parent);
   virtual std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token,
       std::shared_ptr<SymbolTableEntryImplBase> parent_id) override;
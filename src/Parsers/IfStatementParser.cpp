@@ -3,7 +3,7 @@
 #include "StatementParser.h"
 #include "TypeChecker.h"
 
-IfStatementParser::IfStatementParser(const std::shared_ptr<PascalParserTopDown> &parent): PascalSubparserTopDownBase(parent)
+IfStatementParser::IfStatementParser(PascalParserTopDown& parent): PascalSubparserTopDownBase(parent)
 {
 
 }
@@ -7,7 +7,7 @@ class IfStatementParser : public PascalSubparserTopDownBase
 {
 public:
   static TokenTypeSet thenSet();
-  explicit IfStatementParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit IfStatementParser(PascalParserTopDown& parent);
   virtual std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> parent_id);
 };
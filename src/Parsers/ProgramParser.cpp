@@ -2,7 +2,7 @@
 #include "DeclarationsParser.h"
 #include "DeclaredRoutineParser.h"
 
-ProgramParser::ProgramParser(const std::shared_ptr<PascalParserTopDown> &parent) : PascalSubparserTopDownBase(parent), mRootNode(nullptr) {
+ProgramParser::ProgramParser(PascalParserTopDown& parent) : PascalSubparserTopDownBase(parent), mRootNode(nullptr) {
 
 }
 
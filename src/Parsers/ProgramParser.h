@@ -8,7 +8,7 @@ class ProgramParser : public PascalSubparserTopDownBase
 {
 public:
   static TokenTypeSet programStartSet();
-  explicit ProgramParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit ProgramParser(PascalParserTopDown& parent);
   virtual ~ProgramParser();
   std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token,
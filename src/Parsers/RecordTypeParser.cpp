@@ -2,7 +2,7 @@
 #include "VariableDeclarationsParser.h"
 #include "DeclarationsParser.h"
 
-RecordTypeParser::RecordTypeParser(const std::shared_ptr<PascalParserTopDown>& parent): PascalSubparserTopDownBase(parent)
+RecordTypeParser::RecordTypeParser(PascalParserTopDown& parent): PascalSubparserTopDownBase(parent)
 {
 
 }
@@ -3,7 +3,7 @@
 #include "ExpressionParser.h"
 #include "TypeChecker.h"
 
-RepeatStatementParser::RepeatStatementParser(const std::shared_ptr<PascalParserTopDown>& parent): PascalSubparserTopDownBase(parent)
+RepeatStatementParser::RepeatStatementParser(PascalParserTopDown& parent): PascalSubparserTopDownBase(parent)
 {
 
 }
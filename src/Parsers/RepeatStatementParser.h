@@ -6,7 +6,7 @@
 class RepeatStatementParser : public PascalSubparserTopDownBase
 {
 public:
-  explicit RepeatStatementParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit RepeatStatementParser(PascalParserTopDown& parent);
   virtual std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token,
       std::shared_ptr<SymbolTableEntryImplBase> parent_id) override;
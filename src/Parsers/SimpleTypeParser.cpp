@@ -3,7 +3,7 @@
 #include "EnumerationTypeParser.h"
 #include "ConstantDefinitionsParser.h"
 
-SimpleTypeParser::SimpleTypeParser(const std::shared_ptr<PascalParserTopDown>& parent): PascalSubparserTopDownBase(parent)
+SimpleTypeParser::SimpleTypeParser(PascalParserTopDown& parent): PascalSubparserTopDownBase(parent)
 {
 
 }
@@ -18,7 +18,7 @@ std::shared_ptr<TypeSpecImplBase> SimpleTypeParser::parseSpec(std::shared_ptr<Pa
   token = synchronize(SimpleTypeParser::simpleTypeStartSet());
   switch (token->type()) {
     case PascalTokenTypeImpl::IDENTIFIER: {
-      const auto name = boost::algorithm::to_lower_copy(token->text());
+      const auto name = tokenNameId(*token);
       auto id = getSymbolTableStack()->lookup(name);
       if (id != nullptr) {
         auto definition = id->getDefinition();
@@ -8,7 +8,7 @@ class SimpleTypeParser : public PascalSubparserTopDownBase
 {
 public:
   static TokenTypeSet simpleTypeStartSet();
-  explicit SimpleTypeParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit SimpleTypeParser(PascalParserTopDown& parent);
   virtual ~SimpleTypeParser();
   std::shared_ptr<TypeSpecImplBase> parseSpec(std::shared_ptr<PascalToken> token);
 };
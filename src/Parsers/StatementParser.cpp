@@ -8,7 +8,7 @@
 #include "ForStatementParser.h"
 #include "CallParser.h"
 
-StatementParser::StatementParser(const std::shared_ptr<PascalParserTopDown>& parent)
+StatementParser::StatementParser(PascalParserTopDown& parent)
   : PascalSubparserTopDownBase(parent) {}
 
 StatementParser::~StatementParser()
@@ -29,7 +29,7 @@ std::shared_ptr<ICodeNodeImplBase> StatementParser::parse(
       break;
     }
     case PascalTokenTypeImpl::IDENTIFIER: {
-      auto name = boost::algorithm::to_lower_copy(token->text());
+      auto name = tokenNameId(*token);
       auto id = getSymbolTableStack()->lookup(name);
       auto id_definition = (id != nullptr) ? id->getDefinition() : DefinitionImpl::UNDEFINED;
       using enum DefinitionImpl;
@@ -130,7 +130,7 @@ void StatementParser::parseList(std::shared_ptr<PascalToken> token,
 }
 
 PascalSubparserTopDownBase::TokenTypeSet StatementParser::statementStartSet() {
-  PascalSubparserTopDownBase::TokenTypeSet s{
+  constexpr PascalSubparserTopDownBase::TokenTypeSet s{
     PascalTokenTypeImpl::BEGIN,
     PascalTokenTypeImpl::CASE,
     PascalTokenTypeImpl::FOR,
@@ -144,7 +144,7 @@ PascalSubparserTopDownBase::TokenTypeSet StatementParser::statementStartSet() {
 }
 
 PascalSubparserTopDownBase::TokenTypeSet StatementParser::statementFollowSet() {
-  PascalSubparserTopDownBase::TokenTypeSet s{
+  constexpr PascalSubparserTopDownBase::TokenTypeSet s{
     PascalTokenTypeImpl::SEMICOLON,
     PascalTokenTypeImpl::END,
     PascalTokenTypeImpl::ELSE,
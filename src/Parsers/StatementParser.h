@@ -9,7 +9,7 @@ class StatementParser : public PascalSubparserTopDownBase
 public:
   static TokenTypeSet statementStartSet();
   static TokenTypeSet statementFollowSet();
-  explicit StatementParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit StatementParser(PascalParserTopDown& parent);
   virtual ~StatementParser();
   virtual std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> parent_id) override;
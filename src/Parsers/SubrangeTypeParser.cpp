@@ -1,7 +1,7 @@
 #include "SubrangeTypeParser.h"
 #include "ConstantDefinitionsParser.h"
 
-SubrangeTypeParser::SubrangeTypeParser(const std::shared_ptr<PascalParserTopDown>& parent): PascalSubparserTopDownBase(parent)
+SubrangeTypeParser::SubrangeTypeParser(PascalParserTopDown& parent): PascalSubparserTopDownBase(parent)
 {
 
 }
@@ -11,9 +11,8 @@ SubrangeTypeParser::~SubrangeTypeParser()
 
 }
 
-std::unique_ptr<TypeSpecImplBase> SubrangeTypeParser::parseSpec(std::shared_ptr<PascalToken> token)
+std::shared_ptr<TypeSpecImplBase> SubrangeTypeParser::parseSpec(std::shared_ptr<PascalToken> token)
 {
-  auto subrange_type = createType(TypeFormImpl::SUBRANGE);
   // parse the minimum constant
   decltype(token) constant_token = token->clone();
   ConstantDefinitionsParser parser(currentParser());
@@ -59,10 +58,7 @@ std::unique_ptr<TypeSpecImplBase> SubrangeTypeParser::parseSpec(std::shared_ptr<
   } else {
     errorHandler()->flag(constant_token, PascalErrorCode::INVALID_SUBRANGE_TYPE, currentParser());
   }
-  subrange_type->setAttribute<TypeKeyImpl::SUBRANGE_BASE_TYPE>(min_type);
-  subrange_type->setAttribute<TypeKeyImpl::SUBRANGE_MIN_VALUE>(min_val);
-  subrange_type->setAttribute<TypeKeyImpl::SUBRANGE_MAX_VALUE>(max_val);
-  return subrange_type;
+  return createSubrangeType(min_type, min_val, max_val);
 }
 
 VariableValueT SubrangeTypeParser::checkValueType(
@@ -16,9 +16,9 @@
 class SubrangeTypeParser : public PascalSubparserTopDownBase
 {
 public:
-  explicit SubrangeTypeParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit SubrangeTypeParser(PascalParserTopDown& parent);
   ~SubrangeTypeParser() override;
-  std::unique_ptr<TypeSpecImplBase> parseSpec(std::shared_ptr<PascalToken> token);
+  std::shared_ptr<TypeSpecImplBase> parseSpec(std::shared_ptr<PascalToken> token);
   VariableValueT checkValueType(const std::shared_ptr<PascalToken>& token,
                                 const VariableValueT& value,
                                 const std::shared_ptr<TypeSpecImplBase>& type);
@@ -3,7 +3,7 @@
 #include "DeclarationsParser.h"
 #include "ConstantDefinitionsParser.h"
 
-TypeDefinitionsParser::TypeDefinitionsParser(const std::shared_ptr<PascalParserTopDown>& parent)
+TypeDefinitionsParser::TypeDefinitionsParser(PascalParserTopDown& parent)
   : PascalSubparserTopDownBase(parent) {}
 
 TypeDefinitionsParser::~TypeDefinitionsParser()
@@ -20,7 +20,7 @@ std::shared_ptr<ICodeNodeImplBase> TypeDefinitionsParser::parse(
   token = synchronize(TypeDefinitionsParser::identifierSet());
   // loop to parse a sequence of type definitions
   while (token->type() == PascalTokenTypeImpl::IDENTIFIER) {
-    auto name = boost::algorithm::to_lower_copy(token->text());
+    auto name = tokenNameId(*token);
     auto type_id = getSymbolTableStack()->lookupLocal(name);
     if (type_id == nullptr) {
       // enter the new identifier into the symbol table
@@ -49,6 +49,8 @@ std::shared_ptr<ICodeNodeImplBase> TypeDefinitionsParser::parse(
     // cross-link the type identifier and the type specification
     if (type_id != nullptr && type_spec != nullptr) {
       if (type_spec->getIdentifier() == nullptr) {
+        // an interned type is shared by other anonymous declarations
+        type_spec = ownedType(type_spec);
         type_spec->setIdentifier(type_id);
       }
       type_id->setTypeSpec(type_spec);
@@ -84,7 +86,7 @@ PascalSubparserTopDownBase::TokenTypeSet TypeDefinitionsParser::equalsSet() {
 }
 
 PascalSubparserTopDownBase::TokenTypeSet TypeDefinitionsParser::followSet() {
-  TokenTypeSet s{PascalTokenTypeImpl::SEMICOLON};
+  constexpr TokenTypeSet s{PascalTokenTypeImpl::SEMICOLON};
   return s;
 }
 
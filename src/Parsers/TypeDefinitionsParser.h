@@ -11,7 +11,7 @@ public:
   static TokenTypeSet equalsSet();
   static TokenTypeSet followSet();
   static TokenTypeSet nextStartSet();
-  explicit TypeDefinitionsParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit TypeDefinitionsParser(PascalParserTopDown& parent);
   virtual ~TypeDefinitionsParser();
   virtual std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> parent_id) override;
@@ -3,7 +3,7 @@
 #include "RecordTypeParser.h"
 #include "ArrayTypeParser.h"
 
-TypeSpecificationParser::TypeSpecificationParser(const std::shared_ptr<PascalParserTopDown>& parent): PascalSubparserTopDownBase(parent)
+TypeSpecificationParser::TypeSpecificationParser(PascalParserTopDown& parent): PascalSubparserTopDownBase(parent)
 {
 
 }
@@ -8,7 +8,7 @@ class TypeSpecificationParser : public PascalSubparserTopDownBase
 {
 public:
   static TokenTypeSet typeStartSet();
-  explicit TypeSpecificationParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit TypeSpecificationParser(PascalParserTopDown& parent);
   virtual ~TypeSpecificationParser();
   std::shared_ptr<TypeSpecImplBase> parseSpec(std::shared_ptr<PascalToken> token);
 };
@@ -2,7 +2,7 @@
 #include "DeclarationsParser.h"
 #include "TypeSpecificationParser.h"
 
-VariableDeclarationsParser::VariableDeclarationsParser(const std::shared_ptr<PascalParserTopDown>& parent)
+VariableDeclarationsParser::VariableDeclarationsParser(PascalParserTopDown& parent)
   : PascalSubparserTopDownBase(parent), mDefinition(DefinitionImpl::UNDEFINED) {}
 
 VariableDeclarationsParser::~VariableDeclarationsParser()
@@ -96,7 +96,7 @@ PascalSubparserTopDownBase::TokenTypeSet VariableDeclarationsParser::nextStartSe
 }
 
 PascalSubparserTopDownBase::TokenTypeSet VariableDeclarationsParser::identiferStartSet() {
-  TokenTypeSet s{
+  constexpr TokenTypeSet s{
     PascalTokenTypeImpl::IDENTIFIER,
     PascalTokenTypeImpl::COMMA
   };
@@ -113,7 +113,7 @@ PascalSubparserTopDownBase::TokenTypeSet VariableDeclarationsParser::identiferFo
 }
 
 PascalSubparserTopDownBase::TokenTypeSet VariableDeclarationsParser::commaSet() {
-  TokenTypeSet s{
+  constexpr TokenTypeSet s{
     PascalTokenTypeImpl::COMMA,
     PascalTokenTypeImpl::COLON,
     PascalTokenTypeImpl::IDENTIFIER,
@@ -126,7 +126,7 @@ std::shared_ptr<SymbolTableEntryImplBase>
 VariableDeclarationsParser::parseIdentifier(std::shared_ptr<PascalToken> token) {
   std::shared_ptr<SymbolTableEntryImplBase> id = nullptr;
   if (token->type() == PascalTokenTypeImpl::IDENTIFIER) {
-    auto name = boost::algorithm::to_lower_copy(token->text());
+    auto name = tokenNameId(*token);
     id = getSymbolTableStack()->lookupLocal(name);
     if (id == nullptr) {
       // if the identifier is not found,
@@ -136,6 +136,11 @@ VariableDeclarationsParser::parseIdentifier(std::shared_ptr<PascalToken> token)
       // mDefinition may be undefined after constructor
       id->setDefinition(mDefinition);
       id->appendLineNumber(token->lineNum());
+      // variables and parameters take the next slot of the routine's activation record
+      if (mDefinition == DefinitionImpl::VARIABLE || mDefinition == DefinitionImpl::VALUE_PARM ||
+          mDefinition == DefinitionImpl::VAR_PARM) {
+        id->setSlot(getSymbolTableStack()->localSymbolTable()->allocateSlot());
+      }
     } else {
       errorHandler()->flag(token, PascalErrorCode::IDENTIFIER_REDEFINED, currentParser());
     }
@@ -162,7 +167,7 @@ std::shared_ptr<TypeSpecImplBase> VariableDeclarationsParser::parseTypeSpec(std:
 }
 
 PascalSubparserTopDownBase::TokenTypeSet VariableDeclarationsParser::colonSet() {
-  TokenTypeSet s{
+  constexpr TokenTypeSet s{
     PascalTokenTypeImpl::COLON,
     PascalTokenTypeImpl::SEMICOLON
   };
@@ -23,7 +23,7 @@ public:
   static TokenTypeSet identiferFollowSet();
   static TokenTypeSet commaSet();
   static TokenTypeSet colonSet();
-  explicit VariableDeclarationsParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit VariableDeclarationsParser(PascalParserTopDown& parent);
   virtual ~VariableDeclarationsParser();
   virtual std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> parent_id) override;
@@ -3,14 +3,14 @@
 #include "TypeChecker.h"
 
 PascalSubparserTopDownBase::TokenTypeSet VariableParser::subscriptFieldStartSet() {
-  PascalSubparserTopDownBase::TokenTypeSet s{
+  constexpr PascalSubparserTopDownBase::TokenTypeSet s{
     PascalTokenTypeImpl::LEFT_BRACKET,
     PascalTokenTypeImpl::DOT
   };
   return s;
 }
 
-VariableParser::VariableParser(const std::shared_ptr<PascalParserTopDown> &parent) : PascalSubparserTopDownBase(
+VariableParser::VariableParser(PascalParserTopDown& parent) : PascalSubparserTopDownBase(
     parent), isFunctionTarget(false) {
 
 }
@@ -26,7 +26,7 @@ std::shared_ptr<ICodeNodeImplBase> VariableParser::parse(
 //  std::cerr << "parseVariable should be called instead of parse for VariableParser."
 //  return PascalSubparserTopDownBase::parse(token);
   // lookup the identifier in the symbol table stack
-  const auto name = boost::to_lower_copy(token->text());
+  const auto name = tokenNameId(*token);
   // TODO: if a nullptr is passed in, then lookup the name in the symbol table. Is this correct?
   if (variable_id == nullptr) {
     variable_id = getSymbolTableStack()->lookup(name);
@@ -46,22 +46,23 @@ std::shared_ptr<ICodeNodeImplBase> VariableParser::parse(
     errorHandler()->flag(token, PascalErrorCode::INVALID_IDENTIFIER_USAGE, currentParser());
   }
   variable_id->appendLineNumber(token->lineNum());
-  auto variable_node = to_shared(createICodeNode(ICodeNodeTypeImpl::VARIABLE));
-  variable_node->setAttribute<ICodeKeyTypeImpl::ID>(variable_id);
   token = nextToken(); // consume the identifier
   auto variable_type = variable_id->getTypeSpec();
-  if (!isFunctionTarget) {
-    // parse array subscripts or record fields
-    const auto set = subscriptFieldStartSet();
-    while (set.contains(token->type())) {
-      auto node = token->type() == PascalTokenTypeImpl::LEFT_BRACKET ?
-                  parseSubscripts(variable_type) : parseField(variable_type);
-      token = currentToken();
-      // update the variable's type
-      // the variable node adopts the SUBSCRIPTS or FIELD node
-      variable_type = node->getTypeSpec();
-      variable_node->addChild(node);
-    }
+  const auto set = subscriptFieldStartSet();
+  if (isFunctionTarget || !set.contains(token->type())) {
+    return createVariableNode(variable_id, variable_type);
+  }
+  auto variable_node = createICodeNode(ICodeNodeTypeImpl::VARIABLE);
+  variable_node->setAttribute<ICodeKeyTypeImpl::ID>(variable_id);
+  // parse array subscripts or record fields
+  while (set.contains(token->type())) {
+    auto node = token->type() == PascalTokenTypeImpl::LEFT_BRACKET ?
+                parseSubscripts(variable_type) : parseField(variable_type);
+    token = currentToken();
+    // update the variable's type
+    // the variable node adopts the SUBSCRIPTS or FIELD node
+    variable_type = node->getTypeSpec();
+    variable_node->addChild(node);
   }
   variable_node->setTypeSpec(variable_type);
   return variable_node;
@@ -77,13 +78,16 @@ std::shared_ptr<ICodeNodeImplBase> VariableParser::parseVariable(std::shared_ptr
     errorHandler()->flag(token, PascalErrorCode::INVALID_IDENTIFIER_USAGE, currentParser());
   }
   id->appendLineNumber(token->lineNum());
-  auto variable_node = std::shared_ptr(createICodeNode(ICodeNodeTypeImpl::VARIABLE));
-  variable_node->setAttribute<ICodeKeyTypeImpl::ID>(id);
   // consume the identifier
   token = nextToken();
   // parse array subscripts or record fields
   auto variable_type = id->getTypeSpec();
   const auto start_set = subscriptFieldStartSet();
+  if (!start_set.contains(token->type())) {
+    return createVariableNode(id, variable_type);
+  }
+  auto variable_node = std::shared_ptr(createICodeNode(ICodeNodeTypeImpl::VARIABLE));
+  variable_node->setAttribute<ICodeKeyTypeImpl::ID>(id);
   while (start_set.contains(token->type())) {
     auto subscript_field_node = (token->type() == PascalTokenTypeImpl::LEFT_BRACKET) ?
                                 parseSubscripts(variable_type) : parseField(variable_type);
@@ -140,7 +144,7 @@ std::shared_ptr<ICodeNodeImplBase> VariableParser::parseSubscripts(std::shared_p
 }
 
 PascalSubparserTopDownBase::TokenTypeSet VariableParser::rightBracketSet() {
-  PascalSubparserTopDownBase::TokenTypeSet s{
+  constexpr PascalSubparserTopDownBase::TokenTypeSet s{
       PascalTokenTypeImpl::RIGHT_BRACKET,
       PascalTokenTypeImpl::EQUALS,
       PascalTokenTypeImpl::SEMICOLON
@@ -157,7 +161,7 @@ std::shared_ptr<ICodeNodeImplBase> VariableParser::parseField(std::shared_ptr<Ty
   const auto variable_form = variable_type->form();
   if (token_type == PascalTokenTypeImpl::IDENTIFIER && variable_form == TypeFormImpl::RECORD) {
     auto symbol_table = variable_type->getAttribute<TypeKeyImpl::RECORD_SYMTAB>();
-    const auto field_name = boost::to_lower_copy(token->text());
+    const auto field_name = tokenNameId(*token);
     auto field_id = symbol_table->lookup(field_name);
     if (field_id != nullptr) {
       field_id->appendLineNumber(token->lineNum());
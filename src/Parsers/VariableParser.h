@@ -8,7 +8,7 @@ class VariableParser: public PascalSubparserTopDownBase {
 public:
   static TokenTypeSet subscriptFieldStartSet();
   static TokenTypeSet rightBracketSet();
-  explicit VariableParser(const std::shared_ptr<PascalParserTopDown>& parent);
+  explicit VariableParser(PascalParserTopDown& parent);
   ~VariableParser() override;
   std::shared_ptr<ICodeNodeImplBase> parse(
       std::shared_ptr<PascalToken> token, std::shared_ptr<SymbolTableEntryImplBase> variable_id) override;
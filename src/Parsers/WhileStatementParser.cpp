@@ -3,7 +3,7 @@
 #include "ExpressionParser.h"
 #include "TypeChecker.h"
 
-WhileStatementParser::WhileStatementParser(const std::shared_ptr<PascalParserTopDown> &parent): PascalSubparserTopDownBase(parent)
+WhileStatementParser::WhileStatementParser(PascalParserTopDown& parent): PascalSubparserTopDownBase(parent)
 {
 
 }
@@ -2,36 +2,40 @@
 #include "Utilities.h"
 #include "Compiler.h"
 #include "Interpreter.h"
+#include "ICodeImage.h"
+#include "RoutineCache.h"
+#include "OutputBuffer.h"
 
+#include <algorithm>
+#include <chrono>
+#include <climits>
 #include <iostream>
 #include <fmt/format.h>
 #include <source_location>
 
 Pascal::Pascal(const std::string &operation, const std::string &filePath,
-               const std::string &flags)
+               const std::string &flags, const unsigned lexerThreads,
+               const std::string &cacheDir)
     : mParser(nullptr),
       mSource(nullptr), mICode(nullptr), mSymbolTableStack(nullptr),
-      mBackend(nullptr), mTextStream(std::make_shared<std::ifstream>()) {
+      mBackend(nullptr) {
   auto search_xref = flags.find('x');
   auto search_intermediate = flags.find('i');
+  auto search_pipelined = flags.find('p');
   const bool xref = (search_xref == std::string::npos) ? false : true;
   const bool intermediate = (search_intermediate == std::string::npos) ? false : true;
-  mTextStream->open(filePath.c_str());
-  if (!mTextStream->is_open()) {
+  const bool pipelined = (search_pipelined == std::string::npos) ? false : true;
+  // compile and the listings need every routine, so they parse them eagerly
+  const bool lazy = (flags.find('l') != std::string::npos) && boost::iequals(operation, "interpret") &&
+                    !xref && !intermediate;
+  mSource = std::make_shared<Source>(filePath);
+  if (!mSource->isOpen()) {
     std::cerr << "Cannot open " << filePath << std::endl;
     throw std::invalid_argument("Invalid filename, please see the error above.");
   }
-  mSource = std::make_shared<Source>(mTextStream);
-  mParser = createPascalParser("Pascal", "top-down", mSource);
   mSource->sendMessage.connect(std::bind(&Pascal::sourceMessage, this,
                                          std::placeholders::_1,
                                          std::placeholders::_2));
-  mParser->parserSummary.connect(
-      std::bind(&Pascal::parserSummary, this, std::placeholders::_1,
-                std::placeholders::_2, std::placeholders::_3));
-  mParser->syntaxErrorMessage.connect(std::bind(
-      &Pascal::syntaxErrorMessage, this, std::placeholders::_1,
-      std::placeholders::_2, std::placeholders::_3, std::placeholders::_4));
   mBackend = createBackend(operation);
   const std::string backend_type = mBackend->getType();
   if (boost::iequals(backend_type, "compiler")) {
@@ -52,9 +56,58 @@ Pascal::Pascal(const std::string &operation, const std::string &filePath,
                                                        this, std::placeholders::_1,
                                                        std::placeholders::_2));
   }
-  mParser->parse();
-  if (mParser->errorCount() == 0) {
-    mSymbolTableStack = mParser->getSymbolTableStack();
+  const std::string image_path = cacheDir.empty() ? std::string() :
+                                 ICodeImage::cachePath(cacheDir, mSource->text());
+  int error_count = 0;
+  if (!image_path.empty()) {
+    // an unchanged source goes straight to the backend
+    const auto start_time = std::chrono::high_resolution_clock::now();
+    int line_count = 0;
+    mSymbolTableStack = ICodeImage::load(image_path, mSource->text(), line_count);
+    if (mSymbolTableStack) {
+      mSource->readLinesUntil(INT_MAX);
+      const auto end_time = std::chrono::high_resolution_clock::now();
+      const std::chrono::duration<float> elapsed = end_time - start_time;
+      parserSummary(line_count, 0, elapsed.count());
+    }
+  }
+  if (!mSymbolTableStack) {
+    mParser = createPascalParser("Pascal", "top-down", mSource, lexerThreads, pipelined);
+    mParser->setLazyRoutineBodies(lazy);
+    mParser->setSharedLeaves(flags.find('d') != std::string::npos);
+    // the reference listing needs the line numbers added by parsing the statements
+    std::shared_ptr<RoutineCache> routine_cache = nullptr;
+    if (!cacheDir.empty() && !xref) {
+      routine_cache = std::make_shared<RoutineCache>(RoutineCache::cachePath(cacheDir, filePath));
+      mParser->setRoutineCache(routine_cache);
+    }
+    mParser->parserSummary.connect(
+        std::bind(&Pascal::parserSummary, this, std::placeholders::_1,
+                  std::placeholders::_2, std::placeholders::_3));
+    mParser->syntaxErrorMessage.connect(std::bind(
+        &Pascal::syntaxErrorMessage, this, std::placeholders::_1,
+        std::placeholders::_2, std::placeholders::_3, std::placeholders::_4));
+    int line_count = 0;
+    mParser->parserSummary.connect([&line_count](int line_number, int, float){line_count = line_number;});
+    mParser->parse();
+    error_count = mParser->errorCount();
+    if (error_count == 0) {
+      mSymbolTableStack = mParser->getSymbolTableStack();
+      // a source with reused routines is being edited, so skip the image
+      // of the whole program, which would build the ICode of every routine
+      const auto& deferred_bodies = mParser->deferredBodies();
+      const bool reused = std::any_of(deferred_bodies.begin(), deferred_bodies.end(),
+                                      [](const DeferredBody& body){return body.reused;});
+      if (!image_path.empty() && !reused &&
+          !ICodeImage::save(image_path, mSource->text(), line_count, mSymbolTableStack)) {
+        std::cerr << "Cannot write the ICode image " << image_path << std::endl;
+      }
+      if (routine_cache && !routine_cache->save(mParser->deferredBodies(), mSymbolTableStack)) {
+        std::cerr << "Cannot write the routine cache of " << filePath << std::endl;
+      }
+    }
+  }
+  if (error_count == 0) {
     const auto program_id = mSymbolTableStack->programId();
 //    mICode = program_id->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_ICODE>();
     auto icode_opt = program_id->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_ICODE>();
@@ -76,7 +129,7 @@ Pascal::Pascal(const std::string &operation, const std::string &filePath,
     }
     mBackend->process(mICode, mSymbolTableStack);
   } else {
-    std::cout << "Number of error(s): " << mParser->errorCount() << "\n";
+    std::cout << "Number of error(s): " << error_count << "\n";
     std::cout << "Error(s) encountered, will not call backend\n";
   }
 }
@@ -104,9 +157,11 @@ void Pascal::compilerSummary(const int instructionCount, const float elapsedTime
 
 void Pascal::interpreterSummary(const int executionCount, const int runtimeErrors,
                                 const float elapsedTime) const {
-  fmt::print("\n{:10d} statements executed.", executionCount);
-  fmt::print("\n{:10d} runtime errors.", runtimeErrors);
-  fmt::print("\n{:10.5f} seconds total execution time.\n\n", elapsedTime);
+  // after the output of the program
+  auto& output = OutputBuffer::instance();
+  output.print("\n{:10d} statements executed.", executionCount);
+  output.print("\n{:10d} runtime errors.", runtimeErrors);
+  output.print("\n{:10.5f} seconds total execution time.\n\n", elapsedTime);
 }
 
 void Pascal::syntaxErrorMessage(const int lineNumber, const int position, const std::string& text,
@@ -119,10 +174,10 @@ void Pascal::syntaxErrorMessage(const int lineNumber, const int position, const
 
 void Pascal::assignmentMessage(const int line_number, const std::string& variable_name, const VariableValueT& value) const
 {
-  fmt::print("LINE {:3d}: {} = {}\n", line_number, variable_name, variable_value_to_string(value));
+  OutputBuffer::instance().print("LINE {:3d}: {} = {}\n", line_number, variable_name, variable_value_to_string(value));
 }
 
 void Pascal::runtimeErrorMessage(const int line_number, const std::string& error_message) const
 {
-  fmt::print("*** RUNTIME ERROR AT LINE {:03d} {}\n", line_number, error_message);
+  OutputBuffer::instance().print("*** RUNTIME ERROR AT LINE {:03d} {}\n", line_number, error_message);
 }
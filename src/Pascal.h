@@ -13,7 +13,8 @@
 class Pascal {
 public:
   Pascal(const std::string& operation, const std::string& filePath,
-         const std::string& flags);
+         const std::string& flags, unsigned lexerThreads = 0,
+         const std::string& cacheDir = "");
   ~Pascal();
   void sourceMessage(int lineNumber, const std::string& line) const;
   void parserSummary(int lineNumber, int errorCount, float elapsedTime) const;
@@ -29,7 +30,6 @@ private:
   std::shared_ptr<ICodeImplBase> mICode;
   std::shared_ptr<SymbolTableStackImplBase> mSymbolTableStack;
   std::shared_ptr<Backend> mBackend;
-  std::shared_ptr<std::ifstream> mTextStream;
 };
 
 #endif // PASCAL_H
@@ -4,113 +4,239 @@
 #include "Parsers/StatementParser.h"
 #include "Parsers/ProgramParser.h"
 #include "Parsers/BlockParser.h"
+#include "RoutineCache.h"
+#include "ICodeNodePool.h"
 
 //#include <QCoreApplication>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cctype>
+#include <charconv>
+#include <cstdint>
 #include <chrono>
 #include <fmt/format.h>
 #include <iostream>
 #include <ratio>
-#include <set>
-
-std::map<PascalTokenTypeImpl, std::string> initReservedWordsMap() {
-  std::map<PascalTokenTypeImpl, std::string> reserve_words_map;
-  // reserved words
-  reserve_words_map[PascalTokenTypeImpl::AND] = std::string("and");
-  reserve_words_map[PascalTokenTypeImpl::ARRAY] = std::string("array");
-  reserve_words_map[PascalTokenTypeImpl::BEGIN] = std::string("begin");
-  reserve_words_map[PascalTokenTypeImpl::CASE] = std::string("case");
-  reserve_words_map[PascalTokenTypeImpl::CONST] = std::string("const");
-  reserve_words_map[PascalTokenTypeImpl::DIV] = std::string("div");
-  reserve_words_map[PascalTokenTypeImpl::DO] = std::string("do");
-  reserve_words_map[PascalTokenTypeImpl::DOWNTO] = std::string("downto");
-  reserve_words_map[PascalTokenTypeImpl::ELSE] = std::string("else");
-  reserve_words_map[PascalTokenTypeImpl::END] = std::string("end");
-  reserve_words_map[PascalTokenTypeImpl::FILE] = std::string("file");
-  reserve_words_map[PascalTokenTypeImpl::FOR] = std::string("for");
-  reserve_words_map[PascalTokenTypeImpl::FUNCTION] = std::string("function");
-  reserve_words_map[PascalTokenTypeImpl::GOTO] = std::string("goto");
-  reserve_words_map[PascalTokenTypeImpl::IF] = std::string("if");
-  reserve_words_map[PascalTokenTypeImpl::IN] = std::string("in");
-  reserve_words_map[PascalTokenTypeImpl::LABEL] = std::string("label");
-  reserve_words_map[PascalTokenTypeImpl::MOD] = std::string("mod");
-  reserve_words_map[PascalTokenTypeImpl::NIL] = std::string("nil");
-  reserve_words_map[PascalTokenTypeImpl::NOT] = std::string("not");
-  reserve_words_map[PascalTokenTypeImpl::OF] = std::string("of");
-  reserve_words_map[PascalTokenTypeImpl::OR] = std::string("or");
-  reserve_words_map[PascalTokenTypeImpl::PACKED] = std::string("packed");
-  reserve_words_map[PascalTokenTypeImpl::PROCEDURE] = std::string("procedure");
-  reserve_words_map[PascalTokenTypeImpl::PROGRAM] = std::string("program");
-  reserve_words_map[PascalTokenTypeImpl::RECORD] = std::string("record");
-  reserve_words_map[PascalTokenTypeImpl::REPEAT] = std::string("repeat");
-  reserve_words_map[PascalTokenTypeImpl::SET] = std::string("set");
-  reserve_words_map[PascalTokenTypeImpl::THEN] = std::string("then");
-  reserve_words_map[PascalTokenTypeImpl::TO] = std::string("to");
-  reserve_words_map[PascalTokenTypeImpl::TYPE] = std::string("type");
-  reserve_words_map[PascalTokenTypeImpl::UNTIL] = std::string("until");
-  reserve_words_map[PascalTokenTypeImpl::VAR] = std::string("var");
-  reserve_words_map[PascalTokenTypeImpl::WHILE] = std::string("while");
-  reserve_words_map[PascalTokenTypeImpl::WITH] = std::string("with");
-  return reserve_words_map;
-}
-
-std::map<PascalTokenTypeImpl, std::string> initSpecialSymbolsMap() {
-  std::map<PascalTokenTypeImpl, std::string> special_symbols_map;
-  // special symbols
-  special_symbols_map[PascalTokenTypeImpl::PLUS] = std::string("+");
-  special_symbols_map[PascalTokenTypeImpl::MINUS] = std::string("-");
-  special_symbols_map[PascalTokenTypeImpl::STAR] = std::string("*");
-  special_symbols_map[PascalTokenTypeImpl::SLASH] = std::string("/");
-  special_symbols_map[PascalTokenTypeImpl::COLON_EQUALS] = std::string(":=");
-  special_symbols_map[PascalTokenTypeImpl::DOT] = std::string(".");
-  special_symbols_map[PascalTokenTypeImpl::COMMA] = std::string(",");
-  special_symbols_map[PascalTokenTypeImpl::SEMICOLON] = std::string(";");
-  special_symbols_map[PascalTokenTypeImpl::COLON] = std::string(":");
-  special_symbols_map[PascalTokenTypeImpl::QUOTE] = std::string("'");
-  special_symbols_map[PascalTokenTypeImpl::EQUALS] = std::string("=");
-  special_symbols_map[PascalTokenTypeImpl::NOT_EQUALS] = std::string("<>");
-  special_symbols_map[PascalTokenTypeImpl::LESS_THAN] = std::string("<");
-  special_symbols_map[PascalTokenTypeImpl::LESS_EQUALS] = std::string("<=");
-  special_symbols_map[PascalTokenTypeImpl::GREATER_EQUALS] = std::string(">=");
-  special_symbols_map[PascalTokenTypeImpl::GREATER_THAN] = std::string(">");
-  special_symbols_map[PascalTokenTypeImpl::LEFT_PAREN] = std::string("(");
-  special_symbols_map[PascalTokenTypeImpl::RIGHT_PAREN] = std::string(")");
-  special_symbols_map[PascalTokenTypeImpl::LEFT_BRACKET] = std::string("[");
-  special_symbols_map[PascalTokenTypeImpl::RIGHT_BRACKET] = std::string("]");
-  special_symbols_map[PascalTokenTypeImpl::LEFT_BRACE] = std::string("{");
-  special_symbols_map[PascalTokenTypeImpl::RIGHT_BRACE] = std::string("}");
-  special_symbols_map[PascalTokenTypeImpl::UP_ARROW] = std::string("^");
-  special_symbols_map[PascalTokenTypeImpl::DOT_DOT] = std::string("..");
-  return special_symbols_map;
-}
-
-std::map<PascalTokenTypeImpl, std::string> initSpecialWordsMap() {
-  std::map<PascalTokenTypeImpl, std::string> special_words_map;
-  special_words_map[PascalTokenTypeImpl::IDENTIFIER] = std::string("identifier");
-  special_words_map[PascalTokenTypeImpl::INTEGER] = std::string("integer");
-  special_words_map[PascalTokenTypeImpl::REAL] = std::string("real");
-  special_words_map[PascalTokenTypeImpl::STRING] = std::string("string");
-  special_words_map[PascalTokenTypeImpl::ERROR] = std::string("error");
-  special_words_map[PascalTokenTypeImpl::END_OF_FILE] =
-      std::string("end_of_file");
-  return special_words_map;
-}
-
-std::map<PascalTokenTypeImpl, std::string> reservedWordsMap =
-    initReservedWordsMap();
-std::map<PascalTokenTypeImpl, std::string> specialSymbolsMap =
-    initSpecialSymbolsMap();
-std::map<PascalTokenTypeImpl, std::string> specialWordsMap =
-    initSpecialWordsMap();
-std::map<std::string, PascalTokenTypeImpl> reservedWordsMapRev =
-    reverse_map(reservedWordsMap);
-std::map<std::string, PascalTokenTypeImpl> specialSymbolsMapRev =
-    reverse_map(specialSymbolsMap);
-std::map<std::string, PascalTokenTypeImpl> specialWordsMapRev =
-    reverse_map(specialWordsMap);
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace {
+
+// all the frontend tables below are built at compile time,
+// so that there is no static initialization and no allocation at lookup
+
+struct TokenTableEntry {
+  PascalTokenTypeImpl type;
+  std::string_view text;
+};
+
+constexpr std::array reservedWords{
+  TokenTableEntry{PascalTokenTypeImpl::AND, "and"},
+  TokenTableEntry{PascalTokenTypeImpl::ARRAY, "array"},
+  TokenTableEntry{PascalTokenTypeImpl::BEGIN, "begin"},
+  TokenTableEntry{PascalTokenTypeImpl::CASE, "case"},
+  TokenTableEntry{PascalTokenTypeImpl::CONST, "const"},
+  TokenTableEntry{PascalTokenTypeImpl::DIV, "div"},
+  TokenTableEntry{PascalTokenTypeImpl::DO, "do"},
+  TokenTableEntry{PascalTokenTypeImpl::DOWNTO, "downto"},
+  TokenTableEntry{PascalTokenTypeImpl::ELSE, "else"},
+  TokenTableEntry{PascalTokenTypeImpl::END, "end"},
+  TokenTableEntry{PascalTokenTypeImpl::FILE, "file"},
+  TokenTableEntry{PascalTokenTypeImpl::FOR, "for"},
+  TokenTableEntry{PascalTokenTypeImpl::FUNCTION, "function"},
+  TokenTableEntry{PascalTokenTypeImpl::GOTO, "goto"},
+  TokenTableEntry{PascalTokenTypeImpl::IF, "if"},
+  TokenTableEntry{PascalTokenTypeImpl::IN, "in"},
+  TokenTableEntry{PascalTokenTypeImpl::LABEL, "label"},
+  TokenTableEntry{PascalTokenTypeImpl::MOD, "mod"},
+  TokenTableEntry{PascalTokenTypeImpl::NIL, "nil"},
+  TokenTableEntry{PascalTokenTypeImpl::NOT, "not"},
+  TokenTableEntry{PascalTokenTypeImpl::OF, "of"},
+  TokenTableEntry{PascalTokenTypeImpl::OR, "or"},
+  TokenTableEntry{PascalTokenTypeImpl::PACKED, "packed"},
+  TokenTableEntry{PascalTokenTypeImpl::PROCEDURE, "procedure"},
+  TokenTableEntry{PascalTokenTypeImpl::PROGRAM, "program"},
+  TokenTableEntry{PascalTokenTypeImpl::RECORD, "record"},
+  TokenTableEntry{PascalTokenTypeImpl::REPEAT, "repeat"},
+  TokenTableEntry{PascalTokenTypeImpl::SET, "set"},
+  TokenTableEntry{PascalTokenTypeImpl::THEN, "then"},
+  TokenTableEntry{PascalTokenTypeImpl::TO, "to"},
+  TokenTableEntry{PascalTokenTypeImpl::TYPE, "type"},
+  TokenTableEntry{PascalTokenTypeImpl::UNTIL, "until"},
+  TokenTableEntry{PascalTokenTypeImpl::VAR, "var"},
+  TokenTableEntry{PascalTokenTypeImpl::WHILE, "while"},
+  TokenTableEntry{PascalTokenTypeImpl::WITH, "with"},
+};
+
+constexpr std::array specialSymbols{
+  TokenTableEntry{PascalTokenTypeImpl::PLUS, "+"},
+  TokenTableEntry{PascalTokenTypeImpl::MINUS, "-"},
+  TokenTableEntry{PascalTokenTypeImpl::STAR, "*"},
+  TokenTableEntry{PascalTokenTypeImpl::SLASH, "/"},
+  TokenTableEntry{PascalTokenTypeImpl::COLON_EQUALS, ":="},
+  TokenTableEntry{PascalTokenTypeImpl::DOT, "."},
+  TokenTableEntry{PascalTokenTypeImpl::COMMA, ","},
+  TokenTableEntry{PascalTokenTypeImpl::SEMICOLON, ";"},
+  TokenTableEntry{PascalTokenTypeImpl::COLON, ":"},
+  TokenTableEntry{PascalTokenTypeImpl::QUOTE, "'"},
+  TokenTableEntry{PascalTokenTypeImpl::EQUALS, "="},
+  TokenTableEntry{PascalTokenTypeImpl::NOT_EQUALS, "<>"},
+  TokenTableEntry{PascalTokenTypeImpl::LESS_THAN, "<"},
+  TokenTableEntry{PascalTokenTypeImpl::LESS_EQUALS, "<="},
+  TokenTableEntry{PascalTokenTypeImpl::GREATER_EQUALS, ">="},
+  TokenTableEntry{PascalTokenTypeImpl::GREATER_THAN, ">"},
+  TokenTableEntry{PascalTokenTypeImpl::LEFT_PAREN, "("},
+  TokenTableEntry{PascalTokenTypeImpl::RIGHT_PAREN, ")"},
+  TokenTableEntry{PascalTokenTypeImpl::LEFT_BRACKET, "["},
+  TokenTableEntry{PascalTokenTypeImpl::RIGHT_BRACKET, "]"},
+  TokenTableEntry{PascalTokenTypeImpl::LEFT_BRACE, "{"},
+  TokenTableEntry{PascalTokenTypeImpl::RIGHT_BRACE, "}"},
+  TokenTableEntry{PascalTokenTypeImpl::UP_ARROW, "^"},
+  TokenTableEntry{PascalTokenTypeImpl::DOT_DOT, ".."},
+};
+
+constexpr std::array specialWords{
+  TokenTableEntry{PascalTokenTypeImpl::IDENTIFIER, "identifier"},
+  TokenTableEntry{PascalTokenTypeImpl::INTEGER, "integer"},
+  TokenTableEntry{PascalTokenTypeImpl::REAL, "real"},
+  TokenTableEntry{PascalTokenTypeImpl::STRING, "string"},
+  TokenTableEntry{PascalTokenTypeImpl::ERROR, "error"},
+  TokenTableEntry{PascalTokenTypeImpl::END_OF_FILE, "end_of_file"},
+};
+
+// token type -> text, for typeToStr
+constexpr auto tokenTypeNames = [] {
+  std::array<std::string_view, static_cast<size_t>(PascalTokenTypeImpl::UNKNOWN) + 1> names{};
+  for (const auto& entry : reservedWords) names[static_cast<size_t>(entry.type)] = entry.text;
+  for (const auto& entry : specialSymbols) names[static_cast<size_t>(entry.type)] = entry.text;
+  for (const auto& entry : specialWords) names[static_cast<size_t>(entry.type)] = entry.text;
+  return names;
+}();
+
+// character classes used by the scanner
+enum class CharClass : unsigned char {
+  OTHER, WHITESPACE, LETTER, DIGIT, QUOTE, SPECIAL
+};
+
+constexpr auto charClassTable = [] {
+  std::array<CharClass, 256> table{};
+  table.fill(CharClass::OTHER);
+  // isspace in the C locale
+  for (const char c : std::string_view(" \t\n\v\f\r")) {
+    table[static_cast<unsigned char>(c)] = CharClass::WHITESPACE;
+  }
+  for (int c = 'a'; c <= 'z'; ++c) table[c] = CharClass::LETTER;
+  for (int c = 'A'; c <= 'Z'; ++c) table[c] = CharClass::LETTER;
+  for (int c = '0'; c <= '9'; ++c) table[c] = CharClass::DIGIT;
+  // the first characters of the special symbols
+  for (const auto& entry : specialSymbols) {
+    table[static_cast<unsigned char>(entry.text[0])] = CharClass::SPECIAL;
+  }
+  table['\''] = CharClass::QUOTE;
+  return table;
+}();
+
+// one-character special symbols
+constexpr auto singleCharSymbolTable = [] {
+  std::array<PascalTokenTypeImpl, 256> table{};
+  table.fill(PascalTokenTypeImpl::ERROR);
+  for (const auto& entry : specialSymbols) {
+    if (entry.text.size() == 1) {
+      table[static_cast<unsigned char>(entry.text[0])] = entry.type;
+    }
+  }
+  return table;
+}();
+
+inline CharClass charClass(const char c) {
+  return charClassTable[static_cast<unsigned char>(c)];
+}
+
+inline bool isLetterOrDigit(const char c) {
+  const auto char_class = charClass(c);
+  return char_class == CharClass::LETTER || char_class == CharClass::DIGIT;
+}
+
+constexpr char toLowerAscii(const char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// perfect hash of the reserved words:
+// the seed is searched at compile time so that no two reserved words
+// share a slot, then a word only needs one hash and one comparison
+constexpr size_t keywordTableSize = 128;
+
+constexpr size_t maxReservedWordLength = [] {
+  size_t length = 0;
+  for (const auto& entry : reservedWords) length = std::max(length, entry.text.size());
+  return length;
+}();
+
+constexpr uint32_t keywordHash(const std::string_view word, const uint32_t seed) {
+  // FNV-1a on the lowercase characters
+  uint32_t h = seed;
+  for (const char c : word) {
+    h ^= static_cast<unsigned char>(toLowerAscii(c));
+    h *= 16777619u;
+  }
+  h ^= h >> 15;
+  return h & (keywordTableSize - 1);
+}
+
+constexpr uint32_t keywordSeed = [] {
+  for (uint32_t seed = 2166136261u; ; ++seed) {
+    std::array<bool, keywordTableSize> used{};
+    bool collision = false;
+    for (const auto& entry : reservedWords) {
+      const auto slot = keywordHash(entry.text, seed);
+      if (used[slot]) {
+        collision = true;
+        break;
+      }
+      used[slot] = true;
+    }
+    if (!collision) return seed;
+  }
+}();
+
+// slot -> index in reservedWords, or -1 if empty
+constexpr auto keywordTable = [] {
+  std::array<int8_t, keywordTableSize> table{};
+  table.fill(-1);
+  for (size_t i = 0; i < reservedWords.size(); ++i) {
+    table[keywordHash(reservedWords[i].text, keywordSeed)] = static_cast<int8_t>(i);
+  }
+  return table;
+}();
+
+// reserved words are case-insensitive
+PascalTokenTypeImpl lookupWord(const std::string_view word) {
+  if (word.size() > maxReservedWordLength) {
+    return PascalTokenTypeImpl::IDENTIFIER;
+  }
+  const auto index = keywordTable[keywordHash(word, keywordSeed)];
+  if (index < 0) {
+    return PascalTokenTypeImpl::IDENTIFIER;
+  }
+  const auto& entry = reservedWords[static_cast<size_t>(index)];
+  if (entry.text.size() != word.size()) {
+    return PascalTokenTypeImpl::IDENTIFIER;
+  }
+  for (size_t i = 0; i < word.size(); ++i) {
+    if (toLowerAscii(word[i]) != entry.text[i]) {
+      return PascalTokenTypeImpl::IDENTIFIER;
+    }
+  }
+  return entry.type;
+}
+
+}
 
 PascalParserTopDown::PascalParserTopDown(std::shared_ptr<PascalScanner> scanner)
-    : Parser(scanner), mErrorHandler(std::make_unique<PascalErrorHandler>()), mRoutineId(nullptr) {
+    : Parser(scanner), mErrorHandler(std::make_unique<PascalErrorHandler>()), mRoutineId(nullptr),
+      mLazyRoutineBodies(false), mRoutineCache(nullptr), mNodePool(nullptr) {
 }
 
 PascalParserTopDown::~PascalParserTopDown() {
@@ -122,13 +248,20 @@ PascalParserTopDown::~PascalParserTopDown() {
 void PascalParserTopDown::parse() {
   const auto start_time = std::chrono::high_resolution_clock::now();
   auto token = nextToken();
-  ProgramParser program_parser(shared_from_this());
+  ProgramParser program_parser(*this);
   program_parser.parse(token, nullptr);
   mRootNode = program_parser.getRootNode();
-  token = currentToken();
+  const int line_count = currentToken()->lineNum();
+  // the routine cache only applies to declarations without errors
+  if ((mRoutineCache != nullptr) && (errorCount() == 0)) {
+    mRoutineCache->reuse(mDeferredBodies, mSymbolTableStack);
+  }
+  if (!mLazyRoutineBodies) {
+    parseDeferredBodies();
+  }
   const auto end_time = std::chrono::high_resolution_clock::now();
   const std::chrono::duration<double> elapsed_time_sec = end_time - start_time;
-  parserSummary(token->lineNum(), errorCount(), elapsed_time_sec.count());
+  parserSummary(line_count, errorCount(), elapsed_time_sec.count());
 }
 
 int PascalParserTopDown::errorCount() const {
@@ -136,7 +269,7 @@ int PascalParserTopDown::errorCount() const {
 }
 
 std::shared_ptr<PascalToken> PascalParserTopDown::synchronize(
-    const std::set<PascalTokenTypeImpl> &sync_set) {
+    const TokenTypeSet &sync_set) {
 #ifdef DEBUG
   if (sync_set.empty()) {
     qDebug() << "Empty synchronization set!";
@@ -145,19 +278,151 @@ std::shared_ptr<PascalToken> PascalParserTopDown::synchronize(
   auto token = currentToken();
   // if the current token is not in the synchronization set,
   // then it is unexpected and the parser must recover
-  auto search = sync_set.find(token->type());
-  if (search == sync_set.end()) {
+  if (!sync_set.contains(token->type())) {
     // flag the unexpected token
-    mErrorHandler->flag(token, PascalErrorCode::UNEXPECTED_TOKEN, shared_from_this());
+    mErrorHandler->flag(token, PascalErrorCode::UNEXPECTED_TOKEN, *this);
     // recover by skipping tokens that are not in the synchronization set
     do {
       token = nextToken();
-      search = sync_set.find(token->type());
-    } while (!token->isEof() && search == sync_set.end());
+    } while (!token->isEof() && !sync_set.contains(token->type()));
   }
   return token;
 }
 
+void PascalParserTopDown::setLazyRoutineBodies(const bool lazy) {
+  mLazyRoutineBodies = lazy;
+}
+
+void PascalParserTopDown::setRoutineCache(std::shared_ptr<RoutineCache> routine_cache) {
+  mRoutineCache = std::move(routine_cache);
+}
+
+void PascalParserTopDown::setSharedLeaves(const bool shared) {
+  mNodePool = shared ? std::make_unique<ICodeNodePool>() : nullptr;
+}
+
+const std::unique_ptr<ICodeNodePool>& PascalParserTopDown::nodePool() const {
+  return mNodePool;
+}
+
+bool PascalParserTopDown::defersRoutineBodies() const {
+  return mLazyRoutineBodies || (mRoutineCache != nullptr);
+}
+
+const std::vector<DeferredBody>& PascalParserTopDown::deferredBodies() const {
+  return mDeferredBodies;
+}
+
+void PascalParserTopDown::deferStatements(const std::shared_ptr<SymbolTableEntryImplBase>& routine_id,
+                                          ICodeImplBase& intermediate_code) {
+  DeferredBody body;
+  body.routine = routine_id;
+  body.firstLine = currentToken()->lineNum();
+  // skip to the END matching the current BEGIN,
+  // only BEGIN and CASE are closed by END in the statement part
+  std::uint64_t hash = 14695981039346656037ull;
+  const auto mix = [&hash](std::uint64_t x) {
+    hash ^= x;
+    hash *= 1099511628211ull;
+  };
+  int depth = 0;
+  auto token = currentToken();
+  do {
+    const auto token_type = token->type();
+    if ((token_type == PascalTokenTypeImpl::BEGIN) || (token_type == PascalTokenTypeImpl::CASE)) {
+      ++depth;
+    } else if (token_type == PascalTokenTypeImpl::END) {
+      --depth;
+    }
+    mix(static_cast<std::uint64_t>(token_type));
+    mix(static_cast<std::uint64_t>(token->lineNum() - body.firstLine));
+    for (const char c: token->text()) mix(static_cast<unsigned char>(c));
+    body.tokens.push_back(*token);
+    token = nextToken();
+  } while (depth > 0 && !token->isEof());
+  body.hash = hash;
+  // the body ends where the following token starts
+  PascalToken eof_token;
+  eof_token.reset(token->lineNum(), token->position());
+  eof_token.setType(PascalTokenTypeImpl::END_OF_FILE);
+  eof_token.setEof(true);
+  body.tokens.push_back(std::move(eof_token));
+  // the stack has no accessor for the enclosing tables, so take them off and put them back
+  std::vector<std::shared_ptr<SymbolTableImplBase>> tables;
+  while (mSymbolTableStack->currentNestingLevel() > 0) {
+    tables.push_back(mSymbolTableStack->pop());
+  }
+  std::reverse(tables.begin(), tables.end());
+  for (const auto& table: tables) mSymbolTableStack->push(table);
+  body.enclosingTables.assign(tables.begin(), tables.end());
+  // weak references only: the routine owns its ICode, which owns the loader
+  intermediate_code.setRootLoader(
+    [parser = weak_from_this(), index = mDeferredBodies.size()]() -> std::shared_ptr<ICodeNodeImplBase> {
+      const auto pascal_parser = parser.lock();
+      if (pascal_parser == nullptr) {
+        BUG("the parser of a deferred routine body is gone");
+        return nullptr;
+      }
+      // the cached ICode is used once, parsing the tokens is the fallback
+      auto& body = pascal_parser->mDeferredBodies[index];
+      if (body.cachedRoot) {
+        const auto cached_root = std::exchange(body.cachedRoot, nullptr);
+        if (auto root_node = cached_root()) return root_node;
+      }
+      return pascal_parser->loadDeferredStatements(index);
+    });
+  mDeferredBodies.push_back(std::move(body));
+}
+
+std::shared_ptr<ICodeNodeImplBase> PascalParserTopDown::parseDeferredStatements(const size_t index) {
+  auto& body = mDeferredBodies[index];
+  const auto routine_id = body.routine.lock();
+  if (routine_id == nullptr) {
+    BUG("the routine of a deferred body is gone");
+    return nullptr;
+  }
+  if (mSymbolTableStack->currentNestingLevel() != 0) {
+    BUG("a deferred routine body is parsed in the middle of another parse");
+    return nullptr;
+  }
+  // restore the scopes of the routine and parse with the recorded tokens
+  for (const auto& table: body.enclosingTables) {
+    mSymbolTableStack->push(table.lock());
+  }
+  auto saved_scanner = std::exchange(mScanner, std::make_shared<PascalReplayScanner>(std::move(body.tokens)));
+  body.tokens.clear();
+  auto token = nextToken();
+  StatementParser statement_parser(*this);
+  auto root_node = statement_parser.parse(token, routine_id);
+  mScanner = std::move(saved_scanner);
+  for (size_t i = 0; i < body.enclosingTables.size(); ++i) {
+    mSymbolTableStack->pop();
+  }
+  return root_node;
+}
+
+std::shared_ptr<ICodeNodeImplBase> PascalParserTopDown::loadDeferredStatements(const size_t index) {
+  const int previous_error_count = errorCount();
+  auto root_node = parseDeferredStatements(index);
+  // the program is already running, so it cannot go on with a broken routine
+  if (errorCount() > previous_error_count) {
+    PascalErrorHandler::abortTranslation(PascalErrorCode::DEFERRED_BODY_ERRORS, *this);
+  }
+  return root_node;
+}
+
+void PascalParserTopDown::parseDeferredBodies() {
+  for (size_t i = 0; i < mDeferredBodies.size(); ++i) {
+    const auto routine_id = mDeferredBodies[i].routine.lock();
+    if (routine_id == nullptr) continue;
+    const auto icode = routine_id->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_ICODE>();
+    // a cached body is built when its ICode is first needed
+    if (!icode || icode.value()->isLoaded() || mDeferredBodies[i].cachedRoot) continue;
+    ICodeArena::Scope arena_scope(icode.value()->arena());
+    icode.value()->setRoot(parseDeferredStatements(i));
+  }
+}
+
 PascalScanner::PascalScanner() : Scanner(nullptr) {}
 
 PascalScanner::PascalScanner(std::shared_ptr<Source> source)
@@ -169,56 +434,260 @@ PascalScanner::~PascalScanner() {
 #endif
 }
 
-std::shared_ptr<PascalToken> PascalScanner::extractToken() {
+void PascalScanner::extractToken(PascalToken& token) {
+  scanToken(token);
+  internName(token);
+  if (token.isEof()) {
+    std::cerr << "Reach EOF\n";
+  }
+}
+
+void PascalScanner::internName(PascalToken& token) {
+  if (token.type() == PascalTokenTypeImpl::IDENTIFIER) {
+    token.setNameId(NameTable::instance().internLower(token.text()));
+  }
+}
+
+void PascalScanner::scanToken(PascalToken& token) {
   skipWhiteSpace();
-  unique_ptr<PascalToken> token = nullptr;
   auto current_char = currentChar();
+  token.reset(mSource->lineNum(), mSource->currentPos());
   // Construct the next token
   // The current character determines the token type.
   if (current_char == std::char_traits<decltype(current_char)>::eof()) { // use char_traits
-    token = std::make_unique<PascalEofToken>(mSource);
-    std::cerr << "Reach EOF\n";
-  } else if (std::isalpha(current_char)) {
-    token = std::make_unique<PascalWordToken>(mSource);
-  } else if (std::isdigit(current_char)) {
-    token = std::make_unique<PascalNumberToken>(mSource);
-  } else if (current_char == '\'') {
-    token = std::make_unique<PascalStringToken>(mSource);
-  } else if (specialSymbolsMapRev.find(std::string{current_char}) !=
-             specialSymbolsMapRev.end()) {
-    token = std::make_unique<PascalSpecialSymbolToken>(mSource);
-  } else {
-    token = std::make_unique<PascalErrorToken>(
-        mSource, PascalErrorCode::INVALID_CHARACTER, std::string{current_char});
-    nextChar();
+    token.setType(PascalTokenTypeImpl::END_OF_FILE);
+    token.setEof(true);
+    return;
+  }
+  switch (charClass(current_char)) {
+    case CharClass::LETTER: extractWord(token); break;
+    case CharClass::DIGIT: extractNumber(token); break;
+    case CharClass::QUOTE: extractString(token); break;
+    case CharClass::SPECIAL: extractSpecialSymbol(token); break;
+    default: {
+      token.setType(PascalTokenTypeImpl::ERROR);
+      token.mutableText() += current_char;
+      nextChar();
+    }
   }
-  return token;
 }
 
 void PascalScanner::skipWhiteSpace() {
-  auto current_char = currentChar();
   // isWhiteSpace in Java also checks tabulation
-  while (std::isspace(current_char) || current_char == '{') {
+  auto current_char = mSource->skipBlanks();
+  while (current_char == '{') {
     // consume the comment characters
-    if (current_char == '{') {
-      do {
-        current_char = nextChar();
-      } while ((current_char != '}') && (current_char != std::char_traits<decltype(current_char)>::eof()));
-      if (current_char == '}') {
-        current_char = nextChar();
+    nextChar();
+    current_char = mSource->skipTo('}');
+    if (current_char == '}') {
+      nextChar();
+    }
+    current_char = mSource->skipBlanks();
+  }
+}
+
+namespace {
+
+struct ChunkBoundary {
+  size_t offset;
+  int line_offset;
+};
+
+// split the text at line starts that are not inside a comment or a string,
+// so that each chunk can be scanned on its own
+std::vector<ChunkBoundary> findChunkBoundaries(std::string_view text, size_t num_chunks) {
+  std::vector<ChunkBoundary> boundaries{{0, 0}};
+  const size_t chunk_size = std::max<size_t>(text.size() / std::max<size_t>(num_chunks, 1), 1);
+  size_t next_split = chunk_size;
+  bool in_comment = false;
+  bool in_string = false;
+  int lines = 0;
+  for (size_t i = 0; i < text.size(); ++i) {
+    const char c = text[i];
+    if (in_comment) {
+      if (c == '}') in_comment = false;
+    } else if (in_string) {
+      // a doubled quote just closes and reopens the string
+      if (c == '\'') in_string = false;
+    } else if (c == '{') {
+      in_comment = true;
+    } else if (c == '\'') {
+      in_string = true;
+    }
+    if (c == '\n') {
+      ++lines;
+      if (!in_comment && !in_string && i + 1 >= next_split && i + 1 < text.size()) {
+        boundaries.push_back({i + 1, lines});
+        next_split = i + 1 + chunk_size;
       }
-    } else { // not a comment
-      current_char = nextChar();
     }
   }
+  return boundaries;
+}
+
+}
+
+PascalParallelScanner::PascalParallelScanner(std::shared_ptr<Source> source, unsigned num_threads)
+    : PascalScanner(std::move(source)), mNumThreads(std::max(num_threads, 1u)),
+      mTokenized(false), mNextIndex(0) {}
+
+PascalParallelScanner::~PascalParallelScanner() {
+#ifdef DEBUG_DESTRUCTOR
+  std::cerr << "Destructor: " << BOOST_CURRENT_FUNCTION << std::endl;
+#endif
+}
+
+void PascalParallelScanner::tokenize() {
+  const auto text = mSource->text();
+  // a few chunks per thread to balance the load
+  const auto boundaries = findChunkBoundaries(text, mNumThreads * 4);
+  std::vector<std::vector<PascalToken>> chunk_tokens(boundaries.size());
+  std::vector<std::vector<int>> chunk_lines(boundaries.size());
+  std::atomic<size_t> next_chunk = 0;
+  auto worker = [&]() {
+    for (size_t i = next_chunk++; i < boundaries.size(); i = next_chunk++) {
+      const size_t end = (i + 1 < boundaries.size()) ? boundaries[i + 1].offset : text.size();
+      auto chunk_source = std::make_shared<Source>(
+        text.substr(boundaries[i].offset, end - boundaries[i].offset), boundaries[i].line_offset);
+      PascalScanner chunk_scanner(chunk_source);
+      PascalToken token;
+      const bool last_chunk = (i + 1 == boundaries.size());
+      while (true) {
+        chunk_scanner.scanToken(token);
+        // only the last chunk ends with the real EOF
+        if (token.isEof() && !last_chunk) break;
+        chunk_tokens[i].push_back(token);
+        chunk_lines[i].push_back(chunk_source->lineNum());
+        if (token.isEof()) break;
+      }
+    }
+  };
+  std::vector<std::jthread> threads;
+  const auto num_threads = std::min<size_t>(mNumThreads, boundaries.size());
+  for (size_t i = 1; i < num_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  threads.clear();
+  // stitch the chunks together
+  size_t num_tokens = 0;
+  for (const auto& tokens : chunk_tokens) num_tokens += tokens.size();
+  mTokens.reserve(num_tokens);
+  mLinesRead.reserve(num_tokens);
+  for (size_t i = 0; i < chunk_tokens.size(); ++i) {
+    std::move(chunk_tokens[i].begin(), chunk_tokens[i].end(), std::back_inserter(mTokens));
+    mLinesRead.insert(mLinesRead.end(), chunk_lines[i].begin(), chunk_lines[i].end());
+  }
+  mTokenized = true;
+}
+
+void PascalParallelScanner::extractToken(PascalToken& token) {
+  if (!mTokenized) {
+    tokenize();
+  }
+  // keep returning EOF at the end
+  const size_t index = std::min(mNextIndex, mTokens.size() - 1);
+  if (mNextIndex < mTokens.size()) ++mNextIndex;
+  token = mTokens[index];
+  internName(token);
+  // send the source lines that the lazy scanner would have read by now
+  mSource->readLinesUntil(mLinesRead[index]);
+  if (token.isEof()) {
+    std::cerr << "Reach EOF\n";
+  }
+}
+
+PascalReplayScanner::PascalReplayScanner(std::vector<PascalToken> tokens)
+    : PascalScanner(), mTokens(std::move(tokens)), mNextIndex(0) {}
+
+PascalReplayScanner::~PascalReplayScanner() {
+#ifdef DEBUG_DESTRUCTOR
+  std::cerr << "Destructor: " << BOOST_CURRENT_FUNCTION << std::endl;
+#endif
+}
+
+void PascalReplayScanner::extractToken(PascalToken& token) {
+  // keep returning EOF at the end
+  const size_t index = std::min(mNextIndex, mTokens.size() - 1);
+  if (mNextIndex < mTokens.size()) ++mNextIndex;
+  token = mTokens[index];
+}
+
+PascalPipelinedScanner::PascalPipelinedScanner(std::shared_ptr<Source> source)
+    : PascalScanner(std::move(source)), mReachedEof(false) {
+  mScanSource = std::make_shared<Source>(mSource->text(), 0);
+}
+
+PascalPipelinedScanner::~PascalPipelinedScanner() {
+#ifdef DEBUG_DESTRUCTOR
+  std::cerr << "Destructor: " << BOOST_CURRENT_FUNCTION << std::endl;
+#endif
+  // the parser may stop before EOF, so the scanner thread may wait for room
+  mProducer.request_stop();
+}
+
+void PascalPipelinedScanner::produce(const std::stop_token& stop) {
+  PascalScanner scanner(mScanSource);
+  while (!stop.stop_requested()) {
+    auto* slot = mRing.beginPush();
+    if (slot == nullptr) {
+      // the ring is full
+      std::this_thread::yield();
+      continue;
+    }
+    scanner.scanToken(slot->token);
+    slot->linesRead = mScanSource->lineNum();
+    const bool eof = slot->token.isEof();
+    mRing.endPush();
+    if (eof) break;
+  }
+}
+
+void PascalPipelinedScanner::extractToken(PascalToken& token) {
+  if (!mProducer.joinable() && !mReachedEof) {
+    // start scanning at the first request
+    mProducer = std::jthread([this](const std::stop_token& stop){ produce(stop); });
+  }
+  int lines_read = mEofToken.linesRead;
+  if (mReachedEof) {
+    // keep returning EOF at the end
+    token = mEofToken.token;
+  } else {
+    ScannedToken* slot;
+    while ((slot = mRing.beginPop()) == nullptr) {
+      // the ring is empty
+      std::this_thread::yield();
+    }
+    // swap so that the slot reuses the buffer of the old token
+    std::swap(token, slot->token);
+    lines_read = slot->linesRead;
+    mRing.endPop();
+    internName(token);
+    if (token.isEof()) {
+      mReachedEof = true;
+      mEofToken.token = token;
+      mEofToken.linesRead = lines_read;
+    }
+  }
+  // send the source lines that the lazy scanner would have read by now
+  mSource->readLinesUntil(lines_read);
+  if (token.isEof()) {
+    std::cerr << "Reach EOF\n";
+  }
 }
 
 std::unique_ptr<PascalParserTopDown>
 createPascalParser(const std::string &language, const std::string &type,
-                   const std::shared_ptr<Source>& source) {
+                   const std::shared_ptr<Source>& source, unsigned lexer_threads, bool pipelined) {
   if (boost::iequals(language, "Pascal") && boost::iequals(type, "top-down")) {
-    std::unique_ptr<PascalScanner> scanner =
-        std::make_unique<PascalScanner>(source);
+    std::unique_ptr<PascalScanner> scanner;
+    if (lexer_threads > 0) {
+      scanner = std::make_unique<PascalParallelScanner>(source, lexer_threads);
+    } else if (pipelined) {
+      scanner = std::make_unique<PascalPipelinedScanner>(source);
+    } else {
+      scanner = std::make_unique<PascalScanner>(source);
+    }
     return std::make_unique<PascalParserTopDown>(std::move(scanner));
   } else if (!boost::iequals(language, "Pascal")) {
     std::cerr << "Invalid language: " << language.c_str();
@@ -239,198 +708,139 @@ PascalErrorHandler::~PascalErrorHandler() {
 
 void PascalErrorHandler::flag(const std::shared_ptr<PascalToken> &token,
                               const PascalErrorCode errorCode,
-                              const std::shared_ptr<PascalParserTopDown>& parser) {
-  parser->syntaxErrorMessage(token->lineNum(), token->position(), token->text(),
-                             errorMessageMap[errorCode]);
+                              PascalParserTopDown& parser) {
+  parser.syntaxErrorMessage(token->lineNum(), token->position(), token->text(),
+                             std::string(errorMessage(errorCode)));
   if (++mErrorCount > maxError) {
     abortTranslation(PascalErrorCode::TOO_MANY_ERRORS, parser);
   }
 }
 
 void PascalErrorHandler::abortTranslation(const PascalErrorCode errorCode,
-                                          const std::shared_ptr<PascalParserTopDown>& parser) {
-  const std::string fatalText = "FATAL ERROR: " + errorMessageMap[errorCode];
+                                          PascalParserTopDown& parser) {
+  const std::string fatalText = "FATAL ERROR: " + std::string(errorMessage(errorCode));
 //  const PascalParserTopDown *pascalParser =
 //      dynamic_cast<const PascalParserTopDown *>(parser);
-  parser->syntaxErrorMessage(0, 0, "", fatalText);
+  parser.syntaxErrorMessage(0, 0, "", fatalText);
   std::exit(int(errorCode));
 }
 
 int PascalErrorHandler::errorCount() const { return mErrorCount; }
 
-std::map<PascalErrorCode, std::string> initErrorMessageMap() {
-  std::map<PascalErrorCode, std::string> errorMessageMap;
-  errorMessageMap[PascalErrorCode::ALREADY_FORWARDED] =
-      "Already specified in forward";
-  errorMessageMap[PascalErrorCode::IDENTIFIER_REDEFINED] =
-      "Redefined identifier";
-  errorMessageMap[PascalErrorCode::IDENTIFIER_UNDEFINED] =
-      "Undefined identifier";
-  errorMessageMap[PascalErrorCode::INCOMPATIBLE_ASSIGNMENT] =
-      "Incompatible assignment";
-  errorMessageMap[PascalErrorCode::INCOMPATIBLE_TYPES] = "Incompatible types";
-  errorMessageMap[PascalErrorCode::INVALID_ASSIGNMENT] =
-      "Invalid assignment statement";
-  errorMessageMap[PascalErrorCode::INVALID_CHARACTER] = "Invalid character";
-  errorMessageMap[PascalErrorCode::INVALID_CONSTANT] = "Invalid constant";
-  errorMessageMap[PascalErrorCode::INVALID_EXPONENT] = "Invalid exponent";
-  errorMessageMap[PascalErrorCode::INVALID_EXPRESSION] = "Invalid expression";
-  errorMessageMap[PascalErrorCode::INVALID_FIELD] = "Invalid field";
-  errorMessageMap[PascalErrorCode::INVALID_FRACTION] = "Invalid fraction";
-  errorMessageMap[PascalErrorCode::INVALID_IDENTIFIER_USAGE] =
-      "Invalid identifier usage";
-  errorMessageMap[PascalErrorCode::INVALID_INDEX_TYPE] = "Invalid index type";
-  errorMessageMap[PascalErrorCode::INVALID_NUMBER] = "Invalid number";
-  errorMessageMap[PascalErrorCode::INVALID_STATEMENT] = "Invalid statement";
-  errorMessageMap[PascalErrorCode::INVALID_SUBRANGE_TYPE] =
-      "Invalid subrange type";
-  errorMessageMap[PascalErrorCode::INVALID_TARGET] =
-      "Invalid assignment target";
-  errorMessageMap[PascalErrorCode::INVALID_TYPE] = "Invalid type";
-  errorMessageMap[PascalErrorCode::INVALID_VAR_PARM] = "Invalid VAR parameter";
-  errorMessageMap[PascalErrorCode::MIN_GT_MAX] =
-      "Min limit greater than max limit";
-  errorMessageMap[PascalErrorCode::MISSING_BEGIN] = "Missing BEGIN";
-  errorMessageMap[PascalErrorCode::MISSING_COLON] = "Missing :";
-  errorMessageMap[PascalErrorCode::MISSING_COLON_EQUALS] = "Missing :=";
-  errorMessageMap[PascalErrorCode::MISSING_COMMA] = "Missing ,";
-  errorMessageMap[PascalErrorCode::MISSING_CONSTANT] = "Missing constant";
-  errorMessageMap[PascalErrorCode::MISSING_DO] = "Missing DO";
-  errorMessageMap[PascalErrorCode::MISSING_DOT_DOT] = "Missing ..";
-  errorMessageMap[PascalErrorCode::MISSING_END] = "Missing END";
-  errorMessageMap[PascalErrorCode::MISSING_EQUALS] = "Missing =";
-  errorMessageMap[PascalErrorCode::MISSING_FOR_CONTROL] =
-      "Invalid FOR control variable";
-  errorMessageMap[PascalErrorCode::MISSING_IDENTIFIER] = "Missing identifier";
-  errorMessageMap[PascalErrorCode::MISSING_LEFT_BRACKET] = "Missing [";
-  errorMessageMap[PascalErrorCode::MISSING_OF] = "Missing OF";
-  errorMessageMap[PascalErrorCode::MISSING_PERIOD] = "Missing .";
-  errorMessageMap[PascalErrorCode::MISSING_PROGRAM] = "Missing PROGRAM";
-  errorMessageMap[PascalErrorCode::MISSING_RIGHT_BRACKET] = "Missing ]";
-  errorMessageMap[PascalErrorCode::MISSING_RIGHT_PAREN] = "Missing )";
-  errorMessageMap[PascalErrorCode::MISSING_SEMICOLON] = "Missing ;";
-  errorMessageMap[PascalErrorCode::MISSING_THEN] = "Missing THEN";
-  errorMessageMap[PascalErrorCode::MISSING_TO_DOWNTO] = "Missing TO or DOWNTO";
-  errorMessageMap[PascalErrorCode::MISSING_UNTIL] = "Missing UNTIL";
-  errorMessageMap[PascalErrorCode::MISSING_VARIABLE] = "Missing variable";
-  errorMessageMap[PascalErrorCode::CASE_CONSTANT_REUSED] =
-      "CASE constant reused";
-  errorMessageMap[PascalErrorCode::NOT_CONSTANT_IDENTIFIER] =
-      "Not a constant identifier";
-  errorMessageMap[PascalErrorCode::NOT_RECORD_VARIABLE] =
-      "Not a record variable";
-  errorMessageMap[PascalErrorCode::NOT_TYPE_IDENTIFIER] =
-      "Not a type identifier";
-  errorMessageMap[PascalErrorCode::RANGE_INTEGER] =
-      "Integer literal out of range";
-  errorMessageMap[PascalErrorCode::RANGE_REAL] = "Real literal out of range";
-  errorMessageMap[PascalErrorCode::STACK_OVERFLOW] = "Stack overflow";
-  errorMessageMap[PascalErrorCode::TOO_MANY_LEVELS] = "Nesting level too deep";
-  errorMessageMap[PascalErrorCode::TOO_MANY_SUBSCRIPTS] = "Too many subscripts";
-  errorMessageMap[PascalErrorCode::UNEXPECTED_EOF] = "Unexpected end of file";
-  errorMessageMap[PascalErrorCode::UNEXPECTED_TOKEN] = "Unexpected token";
-  errorMessageMap[PascalErrorCode::UNIMPLEMENTED] = "Unimplemented feature";
-  errorMessageMap[PascalErrorCode::UNRECOGNIZABLE] = "Unrecognizable input";
-  errorMessageMap[PascalErrorCode::WRONG_NUMBER_OF_PARMS] =
-      "Wrong number of actual parameters";
-  errorMessageMap[PascalErrorCode::IO_ERROR] = "Object I/O error";
-  errorMessageMap[PascalErrorCode::TOO_MANY_ERRORS] = "Too many syntax errors";
-  return errorMessageMap;
-}
-
-std::map<PascalErrorCode, std::string> PascalErrorHandler::errorMessageMap =
-    initErrorMessageMap();
+namespace {
 
-std::string typeToStr(const PascalTokenTypeImpl &tokenType, bool *ok) {
-  const auto s1 = reservedWordsMap.find(tokenType);
-  if (s1 != reservedWordsMap.end()) {
-    if (ok != nullptr) {
-      *ok = true;
-    }
-    return s1->second;
-  }
-  const auto s2 = specialSymbolsMap.find(tokenType);
-  if (s2 != specialSymbolsMap.end()) {
-    if (ok != nullptr) {
-      *ok = true;
-    }
-    return s2->second;
-  }
-  const auto s3 = specialSymbolsMap.find(tokenType);
-  if (s3 != specialSymbolsMap.end()) {
-    if (ok != nullptr) {
-      *ok = true;
-    }
-    return s3->second;
-  }
-  if (ok != nullptr) {
-    *ok = false;
-  }
-  return "UNKNOWN";
-}
+struct ErrorMessageEntry {
+  PascalErrorCode code;
+  std::string_view message;
+};
 
-PascalErrorToken::PascalErrorToken() : PascalToken() {
-  mType = PascalTokenTypeImpl::ERROR;
-}
+constexpr std::array errorMessageEntries{
+  ErrorMessageEntry{PascalErrorCode::ALREADY_FORWARDED, "Already specified in forward"},
+  ErrorMessageEntry{PascalErrorCode::IDENTIFIER_REDEFINED, "Redefined identifier"},
+  ErrorMessageEntry{PascalErrorCode::IDENTIFIER_UNDEFINED, "Undefined identifier"},
+  ErrorMessageEntry{PascalErrorCode::INCOMPATIBLE_ASSIGNMENT, "Incompatible assignment"},
+  ErrorMessageEntry{PascalErrorCode::INCOMPATIBLE_TYPES, "Incompatible types"},
+  ErrorMessageEntry{PascalErrorCode::INVALID_ASSIGNMENT, "Invalid assignment statement"},
+  ErrorMessageEntry{PascalErrorCode::INVALID_CHARACTER, "Invalid character"},
+  ErrorMessageEntry{PascalErrorCode::INVALID_CONSTANT, "Invalid constant"},
+  ErrorMessageEntry{PascalErrorCode::INVALID_EXPONENT, "Invalid exponent"},
+  ErrorMessageEntry{PascalErrorCode::INVALID_EXPRESSION, "Invalid expression"},
+  ErrorMessageEntry{PascalErrorCode::INVALID_FIELD, "Invalid field"},
+  ErrorMessageEntry{PascalErrorCode::INVALID_FRACTION, "Invalid fraction"},
+  ErrorMessageEntry{PascalErrorCode::INVALID_IDENTIFIER_USAGE, "Invalid identifier usage"},
+  ErrorMessageEntry{PascalErrorCode::INVALID_INDEX_TYPE, "Invalid index type"},
+  ErrorMessageEntry{PascalErrorCode::INVALID_NUMBER, "Invalid number"},
+  ErrorMessageEntry{PascalErrorCode::INVALID_STATEMENT, "Invalid statement"},
+  ErrorMessageEntry{PascalErrorCode::INVALID_SUBRANGE_TYPE, "Invalid subrange type"},
+  ErrorMessageEntry{PascalErrorCode::INVALID_TARGET, "Invalid assignment target"},
+  ErrorMessageEntry{PascalErrorCode::INVALID_TYPE, "Invalid type"},
+  ErrorMessageEntry{PascalErrorCode::INVALID_VAR_PARM, "Invalid VAR parameter"},
+  ErrorMessageEntry{PascalErrorCode::MIN_GT_MAX, "Min limit greater than max limit"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_BEGIN, "Missing BEGIN"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_COLON, "Missing :"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_COLON_EQUALS, "Missing :="},
+  ErrorMessageEntry{PascalErrorCode::MISSING_COMMA, "Missing ,"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_CONSTANT, "Missing constant"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_DO, "Missing DO"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_DOT_DOT, "Missing .."},
+  ErrorMessageEntry{PascalErrorCode::MISSING_END, "Missing END"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_EQUALS, "Missing ="},
+  ErrorMessageEntry{PascalErrorCode::MISSING_FOR_CONTROL, "Invalid FOR control variable"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_IDENTIFIER, "Missing identifier"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_LEFT_BRACKET, "Missing ["},
+  ErrorMessageEntry{PascalErrorCode::MISSING_OF, "Missing OF"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_PERIOD, "Missing ."},
+  ErrorMessageEntry{PascalErrorCode::MISSING_PROGRAM, "Missing PROGRAM"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_RIGHT_BRACKET, "Missing ]"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_RIGHT_PAREN, "Missing )"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_SEMICOLON, "Missing ;"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_THEN, "Missing THEN"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_TO_DOWNTO, "Missing TO or DOWNTO"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_UNTIL, "Missing UNTIL"},
+  ErrorMessageEntry{PascalErrorCode::MISSING_VARIABLE, "Missing variable"},
+  ErrorMessageEntry{PascalErrorCode::CASE_CONSTANT_REUSED, "CASE constant reused"},
+  ErrorMessageEntry{PascalErrorCode::NOT_CONSTANT_IDENTIFIER, "Not a constant identifier"},
+  ErrorMessageEntry{PascalErrorCode::NOT_RECORD_VARIABLE, "Not a record variable"},
+  ErrorMessageEntry{PascalErrorCode::NOT_TYPE_IDENTIFIER, "Not a type identifier"},
+  ErrorMessageEntry{PascalErrorCode::RANGE_INTEGER, "Integer literal out of range"},
+  ErrorMessageEntry{PascalErrorCode::RANGE_REAL, "Real literal out of range"},
+  ErrorMessageEntry{PascalErrorCode::STACK_OVERFLOW, "Stack overflow"},
+  ErrorMessageEntry{PascalErrorCode::TOO_MANY_LEVELS, "Nesting level too deep"},
+  ErrorMessageEntry{PascalErrorCode::TOO_MANY_SUBSCRIPTS, "Too many subscripts"},
+  ErrorMessageEntry{PascalErrorCode::UNEXPECTED_EOF, "Unexpected end of file"},
+  ErrorMessageEntry{PascalErrorCode::UNEXPECTED_TOKEN, "Unexpected token"},
+  ErrorMessageEntry{PascalErrorCode::UNIMPLEMENTED, "Unimplemented feature"},
+  ErrorMessageEntry{PascalErrorCode::UNRECOGNIZABLE, "Unrecognizable input"},
+  ErrorMessageEntry{PascalErrorCode::WRONG_NUMBER_OF_PARMS, "Wrong number of actual parameters"},
+  ErrorMessageEntry{PascalErrorCode::IO_ERROR, "Object I/O error"},
+  ErrorMessageEntry{PascalErrorCode::TOO_MANY_ERRORS, "Too many syntax errors"},
+  ErrorMessageEntry{PascalErrorCode::DEFERRED_BODY_ERRORS, "Syntax errors in a deferred routine body"},
+};
 
-PascalErrorToken::PascalErrorToken(std::shared_ptr<Source> source,
-                                   const PascalErrorCode errorCode,
-                                   const std::string &tokenText)
-    : PascalToken(source, false) {
-  this->mType = PascalTokenTypeImpl::ERROR;
-  this->mValue = VariableValueT();
-  this->mText = tokenText;
-  PascalErrorToken::extract();
-}
+// error code -> message
+constexpr auto errorMessages = [] {
+  std::array<std::string_view, static_cast<size_t>(PascalErrorCode::DEFERRED_BODY_ERRORS) + 1> messages{};
+  for (const auto& entry : errorMessageEntries) {
+    messages[static_cast<size_t>(entry.code)] = entry.message;
+  }
+  return messages;
+}();
 
-unique_ptr<PascalToken> PascalErrorToken::clone() const {
-  return std::make_unique<PascalErrorToken>(*this);
-}
+static_assert(std::ranges::none_of(errorMessages, [](std::string_view m){ return m.empty(); }),
+              "every PascalErrorCode needs an error message");
 
-void PascalErrorToken::extract() {}
+}
 
-PascalWordToken::PascalWordToken(std::shared_ptr<Source> source)
-    : PascalToken(source, false) {
-  PascalWordToken::extract();
-  mValue = VariableValueT();
+std::string_view PascalErrorHandler::errorMessage(const PascalErrorCode errorCode) {
+  return errorMessages[static_cast<size_t>(errorCode)];
 }
 
-unique_ptr<PascalToken> PascalWordToken::clone() const {
-  return std::make_unique<PascalWordToken>(*this);
+std::string typeToStr(const PascalTokenTypeImpl &tokenType, bool *ok) {
+  const auto name = tokenTypeNames[static_cast<size_t>(tokenType)];
+  if (ok != nullptr) {
+    *ok = !name.empty();
+  }
+  return name.empty() ? "UNKNOWN" : std::string(name);
 }
 
-void PascalWordToken::extract() {
-  std::string s;
+void PascalScanner::extractWord(PascalToken& token) {
+  auto& text = token.mutableText();
   auto current_char = currentChar();
-  while (std::isalnum(current_char)) {
-    s += current_char;
+  while (isLetterOrDigit(current_char)) {
+    text += current_char;
     current_char = nextChar();
   }
-  mText = s;
-  const auto lower_str = boost::algorithm::to_lower_copy(mText);
-  if (reservedWordsMapRev.find(lower_str) != reservedWordsMapRev.end()) {
-    mType = reservedWordsMapRev[lower_str];
-  } else {
-    mType = PascalTokenTypeImpl::IDENTIFIER;
-  }
-}
-
-PascalStringToken::PascalStringToken(std::shared_ptr<Source> source)
-    : PascalToken(source, false) {
-  PascalStringToken::extract();
+  token.setType(lookupWord(text));
 }
 
-unique_ptr<PascalToken> PascalStringToken::clone() const {
-  return std::make_unique<PascalStringToken>(*this);
-}
-
-void PascalStringToken::extract() {
-  std::string text, value;
+void PascalScanner::extractString(PascalToken& token) {
+  auto& text = token.mutableText();
+  std::string value;
   auto current_char = nextChar();
   text += '\'';
   do {
     // replace any whitespace character with a blank (why?)
-    if (std::isspace(current_char)) {
+    if (charClass(current_char) == CharClass::WHITESPACE) {
       current_char = ' ';
     }
     if (current_char != '\'' && current_char != std::char_traits<decltype(current_char)>::eof()) {
@@ -440,7 +850,7 @@ void PascalStringToken::extract() {
     }
     // quote?
     if (current_char == '\'') {
-      while (current_char == '\'' && peekChar() == '\'') {
+      while (current_char == '\'' && mSource->peekChar() == '\'') {
         text += "''";
         value += current_char;     // append single-quote
         current_char = nextChar(); // consume pair of quotes
@@ -451,64 +861,36 @@ void PascalStringToken::extract() {
   if (current_char == '\'') {
     nextChar(); // consume the final quote
     text += '\'';
-    mType = PascalTokenTypeImpl::STRING;
-    mValue = value;
+    token.setType(PascalTokenTypeImpl::STRING);
+    token.setValue(std::move(value));
   } else {
-    mType = PascalTokenTypeImpl::ERROR;
-    mValue = VariableValueT();
+    token.setType(PascalTokenTypeImpl::ERROR);
   }
-  mText = text;
-}
-
-PascalSpecialSymbolToken::PascalSpecialSymbolToken(
-    std::shared_ptr<Source> source)
-    : PascalToken(source, false) {
-  PascalSpecialSymbolToken::extract();
 }
 
-unique_ptr<PascalToken> PascalSpecialSymbolToken::clone() const {
-  return std::make_unique<PascalSpecialSymbolToken>(*this);
-}
-
-void PascalSpecialSymbolToken::extract() {
+void PascalScanner::extractSpecialSymbol(PascalToken& token) {
+  auto& text = token.mutableText();
   auto current_char = currentChar();
-  mText = std::string{current_char};
-  bool invalid_type = false;
-  //  mTypeStr = "null";
+  text += current_char;
+  token.setType(singleCharSymbolTable[static_cast<unsigned char>(current_char)]);
   switch (current_char) {
-  // single-character special symbols
-  case '+':
-  case '-':
-  case '*':
-  case '/':
-  case ',':
-  case ';':
-  case '\'':
-  case '=':
-  case '(':
-  case ')':
-  case '[':
-  case ']':
-  case '{':
-  case '}':
-  case '^': {
-    nextChar();
-    break;
-  }
   // : or :=
   case ':': {
     current_char = nextChar(); // consume ':'
     if (current_char == '=') {
-      mText += current_char;
+      text += current_char;
+      token.setType(PascalTokenTypeImpl::COLON_EQUALS);
       nextChar(); // consume '='
     }
     break;
   }
   // < or <= or <>
   case '<': {
-    current_char = nextChar(); // consume '>'
+    current_char = nextChar(); // consume '<'
     if (current_char == '=' || current_char == '>') {
-      mText += current_char;
+      text += current_char;
+      token.setType(current_char == '=' ? PascalTokenTypeImpl::LESS_EQUALS :
+                                          PascalTokenTypeImpl::NOT_EQUALS);
       nextChar(); // consume '=' or '>'
     }
     break;
@@ -517,7 +899,8 @@ void PascalSpecialSymbolToken::extract() {
   case '>': {
     current_char = nextChar(); // consume '>'
     if (current_char == '=') {
-      mText += current_char;
+      text += current_char;
+      token.setType(PascalTokenTypeImpl::GREATER_EQUALS);
       nextChar(); // consume '='
     }
     break;
@@ -526,150 +909,111 @@ void PascalSpecialSymbolToken::extract() {
   case '.': {
     current_char = nextChar(); // consume '.'
     if (current_char == '.') {
-      mText += current_char;
+      text += current_char;
+      token.setType(PascalTokenTypeImpl::DOT_DOT);
       nextChar(); // consume '.'
     }
     break;
   }
+  // single-character special symbols, or a bad character
   default: {
-    nextChar(); // consume bad character
-    invalid_type = true;
-    mType = PascalTokenTypeImpl::ERROR;
-    mValue = VariableValueT();
-  }
+    nextChar();
   }
-  if (!invalid_type) {
-    if (specialSymbolsMapRev.find(mText) != specialSymbolsMapRev.end()) {
-      mType = specialSymbolsMapRev[mText];
-    }
   }
 }
 
-PascalNumberToken::PascalNumberToken(std::shared_ptr<Source> source)
-    : PascalToken(source, false) {
-  PascalNumberToken::extract();
-}
-
-unique_ptr<PascalToken> PascalNumberToken::clone() const {
-  return std::make_unique<PascalNumberToken>(*this);
-}
-
-void PascalNumberToken::extract() {
-  std::string text;
-  PascalNumberToken::extractNumber(text);
-  mText = text;
-}
-
-void PascalNumberToken::extractNumber(std::string &text) {
+void PascalScanner::extractNumber(PascalToken& token) {
   // TODO: is it possible to parse C-style numbers
-  std::string whole_digits, fraction_digits, exponent_digits;
-  char exponent_sign = '+';
+  // the digits are only collected in the token text,
+  // and the value is converted from there
+  auto& text = token.mutableText();
   bool dot_dot = false;
   char current_char;
-  mType = PascalTokenTypeImpl::INTEGER;
-  whole_digits = PascalNumberToken::unsignedIntegerDigits(text);
-  if (mType == PascalTokenTypeImpl::ERROR) {
+  token.setType(PascalTokenTypeImpl::INTEGER);
+  if (!unsignedIntegerDigits(token)) {
     return;
   }
+  const size_t num_whole_digits = text.size();
   current_char = currentChar();
   if (current_char == '.') {
-    if (peekChar() == '.') {
+    if (mSource->peekChar() == '.') {
       dot_dot = true;
     } else {
-      mType = PascalTokenTypeImpl::REAL;
+      token.setType(PascalTokenTypeImpl::REAL);
       text += current_char;
       current_char = nextChar();
-      if (!(std::isspace(peekChar()))) {
-        fraction_digits = PascalNumberToken::unsignedIntegerDigits(text);
-      }
-      if (mType == PascalTokenTypeImpl::ERROR) {
-        return;
+      if (charClass(mSource->peekChar()) != CharClass::WHITESPACE) {
+        if (!unsignedIntegerDigits(token)) {
+          return;
+        }
       }
     }
   }
   current_char = currentChar();
   if (!dot_dot && (current_char == 'E' || current_char == 'e')) {
-    mType = PascalTokenTypeImpl::REAL;
+    token.setType(PascalTokenTypeImpl::REAL);
     text += current_char;
     current_char = nextChar();
     if (current_char == '+' || current_char == '-') {
       text += current_char;
-      exponent_sign = current_char;
       current_char = nextChar();
     }
-    exponent_digits = PascalNumberToken::unsignedIntegerDigits(text);
-  }
-  if (mType == PascalTokenTypeImpl::INTEGER) {
-    const auto integer_value = computeIntegerValue(whole_digits);
-    if (mType != PascalTokenTypeImpl::ERROR) {
-      mValue = integer_value;
+    if (!unsignedIntegerDigits(token)) {
+      return;
     }
+  }
+  if (token.type() == PascalTokenTypeImpl::INTEGER) {
+    computeIntegerValue(token, num_whole_digits);
   } else {
-    const PascalFloat float_value = computeFloatValue(
-        whole_digits, fraction_digits, exponent_digits, exponent_sign);
-    if (mType != PascalTokenTypeImpl::ERROR) {
-      mValue = float_value;
-    }
+    computeFloatValue(token);
   }
 }
 
-std::string PascalNumberToken::unsignedIntegerDigits(std::string &text) {
+bool PascalScanner::unsignedIntegerDigits(PascalToken& token) {
   char current_char = currentChar();
-  if (!std::isdigit(current_char)) {
-    mType = PascalTokenTypeImpl::ERROR;
-    mValue = VariableValueT();
-    return "null";
+  if (charClass(current_char) != CharClass::DIGIT) {
+    token.setType(PascalTokenTypeImpl::ERROR);
+    token.setValue(VariableValueT());
+    return false;
   }
-  std::string digits;
-  while (std::isdigit(current_char)) {
+  auto& text = token.mutableText();
+  while (charClass(current_char) == CharClass::DIGIT) {
     text += current_char;
-    digits += current_char;
     current_char = nextChar();
   }
-  return digits;
+  return true;
 }
 
-PascalInteger PascalNumberToken::computeIntegerValue(const std::string &digits) {
+void PascalScanner::computeIntegerValue(PascalToken& token, size_t num_digits) {
   // does not consume characters
-  PascalInteger result;
-  try {
-    result = std::stoll(digits);
-  } catch (const std::out_of_range& e) {
-    result = 0;
-    mType = PascalTokenTypeImpl::ERROR;
-    mValue = PascalErrorCode::RANGE_INTEGER;
-  } catch (const std::invalid_argument& e) {
-    result = 0;
-    mType = PascalTokenTypeImpl::ERROR;
-    mValue = PascalErrorCode::INVALID_NUMBER;
-  }
-  return result;
-}
-
-PascalFloat PascalNumberToken::computeFloatValue(const std::string &whole_digits,
-                                            const std::string &fraction_digits,
-                                            const std::string &exponent_digits,
-                                            char exponent_sign) {
-  std::string s = whole_digits;
-  if (!fraction_digits.empty()) {
-    s += "." + fraction_digits;
-  }
-  if (!exponent_digits.empty()) {
-    s += 'e' + std::string{exponent_sign} + exponent_digits;
-  }
-  PascalFloat result;
-  try {
-    result = std::stod(s);
-  } catch (const std::invalid_argument&) {
-    result = 0;
-    mType = PascalTokenTypeImpl::ERROR;
-    mValue = PascalErrorCode::INVALID_NUMBER;
-  } catch (const std::out_of_range&) {
-    result = 0;
-    mType = PascalTokenTypeImpl::ERROR;
-    mValue = PascalErrorCode::RANGE_REAL;
-  }
-  return result;
+  const char* first = token.text().data();
+  PascalInteger result = 0;
+  const auto [ptr, ec] = std::from_chars(first, first + num_digits, result);
+  if (ec == std::errc::result_out_of_range) {
+    token.setType(PascalTokenTypeImpl::ERROR);
+    token.setValue(PascalErrorCode::RANGE_INTEGER);
+  } else if (ec != std::errc()) {
+    token.setType(PascalTokenTypeImpl::ERROR);
+    token.setValue(PascalErrorCode::INVALID_NUMBER);
+  } else {
+    token.setValue(result);
+  }
+}
+
+void PascalScanner::computeFloatValue(PascalToken& token) {
+  // the text is "whole[.fraction][e[sign]exponent]"
+  const auto& text = token.text();
+  PascalFloat result = 0;
+  const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), result);
+  if (ec == std::errc::result_out_of_range) {
+    token.setType(PascalTokenTypeImpl::ERROR);
+    token.setValue(PascalErrorCode::RANGE_REAL);
+  } else if (ec != std::errc()) {
+    token.setType(PascalTokenTypeImpl::ERROR);
+    token.setValue(PascalErrorCode::INVALID_NUMBER);
+  } else {
+    token.setValue(result);
+  }
 }
 
 const std::unordered_map<PascalTokenTypeImpl, ICodeNodeTypeImpl> PascalSubparserTopDownBase::relOpsMap =
@@ -692,45 +1036,45 @@ const std::unordered_map<PascalTokenTypeImpl, ICodeNodeTypeImpl> PascalSubparser
    {PascalTokenTypeImpl::MOD,   ICodeNodeTypeImpl::MOD},
    {PascalTokenTypeImpl::AND,   ICodeNodeTypeImpl::AND}};
 
-PascalSubparserTopDownBase::PascalSubparserTopDownBase(const std::shared_ptr<PascalParserTopDown>& pascal_parser)
+PascalSubparserTopDownBase::PascalSubparserTopDownBase(PascalParserTopDown& pascal_parser)
     : mPascalParser(pascal_parser) {}
 
 PascalSubparserTopDownBase::~PascalSubparserTopDownBase() {}
 
-std::shared_ptr<PascalToken> PascalSubparserTopDownBase::currentToken() const {
-  return mPascalParser->currentToken();
+const std::shared_ptr<PascalToken>& PascalSubparserTopDownBase::currentToken() const {
+  return mPascalParser.currentToken();
 }
 
-std::shared_ptr<PascalToken> PascalSubparserTopDownBase::nextToken() {
-  return mPascalParser->nextToken();
+const std::shared_ptr<PascalToken>& PascalSubparserTopDownBase::nextToken() {
+  return mPascalParser.nextToken();
 }
 
 std::shared_ptr<PascalToken> PascalSubparserTopDownBase::synchronize(
-    const std::set<PascalTokenTypeImpl> &sync_set) {
-  return mPascalParser->synchronize(sync_set);
+    const TokenTypeSet &sync_set) {
+  return mPascalParser.synchronize(sync_set);
 }
 
-std::shared_ptr<SymbolTableStackImplBase> PascalSubparserTopDownBase::getSymbolTableStack() {
-  return mPascalParser->getSymbolTableStack();
+const std::shared_ptr<SymbolTableStackImplBase>& PascalSubparserTopDownBase::getSymbolTableStack() {
+  return mPascalParser.getSymbolTableStack();
 }
 
 //std::shared_ptr<ICodeImplBase> PascalSubparserTopDownBase::getICode() const {
 //  return mPascalParser.getICode();
 //}
 
-std::shared_ptr<PascalScanner> PascalSubparserTopDownBase::scanner() const {
-  return mPascalParser->scanner();
+const std::shared_ptr<PascalScanner>& PascalSubparserTopDownBase::scanner() const {
+  return mPascalParser.scanner();
 }
 
 int PascalSubparserTopDownBase::errorCount() {
-  return mPascalParser->errorCount();
+  return mPascalParser.errorCount();
 }
 
-std::shared_ptr<PascalErrorHandler> PascalSubparserTopDownBase::errorHandler() {
-  return mPascalParser->mErrorHandler;
+const std::shared_ptr<PascalErrorHandler>& PascalSubparserTopDownBase::errorHandler() {
+  return mPascalParser.mErrorHandler;
 }
 
-std::shared_ptr<PascalParserTopDown> PascalSubparserTopDownBase::currentParser() {
+PascalParserTopDown& PascalSubparserTopDownBase::currentParser() {
   return mPascalParser;
 }
 
@@ -753,9 +1097,26 @@ void PascalSubparserTopDownBase::setLineNumber(
   }
 }
 
-PascalEofToken::PascalEofToken() { mType = PascalTokenTypeImpl::END_OF_FILE; }
+std::shared_ptr<ICodeNodeImplBase> PascalSubparserTopDownBase::createConstantNode(
+    const ICodeNodeTypeImpl type, const VariableValueT& value,
+    const std::shared_ptr<TypeSpecImplBase>& type_spec) {
+  if (mPascalParser.mNodePool != nullptr) {
+    return mPascalParser.mNodePool->constant(type, value, type_spec);
+  }
+  auto node = createICodeNode(type);
+  node->setAttribute<ICodeKeyTypeImpl::VALUE>(value);
+  node->setTypeSpec(type_spec);
+  return node;
+}
 
-PascalEofToken::PascalEofToken(std::shared_ptr<Source> source)
-    : EofToken<PascalTokenTypeImpl>(source) {
-  mType = PascalTokenTypeImpl::END_OF_FILE;
+std::shared_ptr<ICodeNodeImplBase> PascalSubparserTopDownBase::createVariableNode(
+    const std::shared_ptr<SymbolTableEntryImplBase>& id,
+    const std::shared_ptr<TypeSpecImplBase>& type_spec) {
+  if (mPascalParser.mNodePool != nullptr) {
+    return mPascalParser.mNodePool->variable(id, type_spec);
+  }
+  auto node = createICodeNode(ICodeNodeTypeImpl::VARIABLE);
+  node->setAttribute<ICodeKeyTypeImpl::ID>(id);
+  node->setTypeSpec(type_spec);
+  return node;
 }
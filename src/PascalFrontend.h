@@ -7,30 +7,172 @@
 #include "Common.h"
 
 #include <boost/signals2/connection.hpp>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
 #include <map>
-#include <set>
+#include <thread>
+#include <vector>
 
 class PascalErrorHandler;
 class PascalSubparserTopDownBase;
+class RoutineCache;
+class ICodeNodePool;
 
 typedef Token<PascalTokenTypeImpl> PascalToken;
 
-class PascalEofToken: public EofToken<PascalTokenTypeImpl> {
+std::string typeToStr(const PascalTokenTypeImpl &tokenType, bool *ok = nullptr);
+
+// fixed-size bitset of token types for the start, follow and
+// synchronization sets, so that they never allocate
+class TokenTypeSet {
 public:
-  PascalEofToken();
-  explicit PascalEofToken(std::shared_ptr<Source> source);
+  constexpr TokenTypeSet(): mBits{} {}
+  constexpr TokenTypeSet(std::initializer_list<PascalTokenTypeImpl> types): mBits{} {
+    insert(types);
+  }
+  constexpr void insert(PascalTokenTypeImpl type) {
+    const auto i = index(type);
+    mBits[i / 64] |= std::uint64_t{1} << (i % 64);
+  }
+  constexpr void insert(std::initializer_list<PascalTokenTypeImpl> types) {
+    for (const auto type: types) insert(type);
+  }
+  constexpr void erase(PascalTokenTypeImpl type) {
+    const auto i = index(type);
+    mBits[i / 64] &= ~(std::uint64_t{1} << (i % 64));
+  }
+  // add all the types of the other set
+  constexpr void merge(const TokenTypeSet& other) {
+    for (size_t i = 0; i < numWords; ++i) mBits[i] |= other.mBits[i];
+  }
+  [[nodiscard]] constexpr bool contains(PascalTokenTypeImpl type) const {
+    const auto i = index(type);
+    return (mBits[i / 64] >> (i % 64)) & 1;
+  }
+  [[nodiscard]] constexpr bool empty() const {
+    for (const auto word: mBits) {
+      if (word != 0) return false;
+    }
+    return true;
+  }
+  constexpr TokenTypeSet& operator|=(const TokenTypeSet& other) {
+    merge(other);
+    return *this;
+  }
+  friend constexpr TokenTypeSet operator|(TokenTypeSet x, const TokenTypeSet& y) {
+    x.merge(y);
+    return x;
+  }
+  friend constexpr bool operator==(const TokenTypeSet&, const TokenTypeSet&) = default;
+private:
+  static constexpr size_t numTypes = static_cast<size_t>(PascalTokenTypeImpl::UNKNOWN) + 1;
+  static constexpr size_t numWords = (numTypes + 63) / 64;
+  static constexpr size_t index(PascalTokenTypeImpl type) {
+    return static_cast<size_t>(type);
+  }
+  std::array<std::uint64_t, numWords> mBits;
 };
 
-std::string typeToStr(const PascalTokenTypeImpl &tokenType, bool *ok = nullptr);
+// the interned lowercase name of the token,
+// the text of a token that the scanner did not intern is interned here
+inline NameId tokenNameId(const PascalToken& token) {
+  const auto name_id = token.nameId();
+  return (name_id != invalidNameId) ? name_id : NameTable::instance().internLower(token.text());
+}
 
 class PascalScanner: public Scanner<PascalTokenTypeImpl> {
 public:
   PascalScanner();
   explicit PascalScanner(std::shared_ptr<Source> source);
   ~PascalScanner() override;
-  std::shared_ptr<PascalToken> extractToken() override;
+  void extractToken(PascalToken& token) override;
+  // extract the next token without any message
+  void scanToken(PascalToken& token);
+protected:
+  // intern the name of an identifier on the parser's thread
+  static void internName(PascalToken& token);
 private:
   void skipWhiteSpace();
+  // extract the different kinds of tokens into a recycled token
+  void extractWord(PascalToken& token);
+  void extractString(PascalToken& token);
+  void extractSpecialSymbol(PascalToken& token);
+  void extractNumber(PascalToken& token);
+  bool unsignedIntegerDigits(PascalToken& token);
+  void computeIntegerValue(PascalToken& token, size_t num_digits);
+  void computeFloatValue(PascalToken& token);
+};
+
+// tokenize the whole source on several threads before parsing,
+// then hand out the tokens from the vector
+class PascalParallelScanner: public PascalScanner {
+public:
+  PascalParallelScanner(std::shared_ptr<Source> source, unsigned num_threads);
+  ~PascalParallelScanner() override;
+  void extractToken(PascalToken& token) override;
+private:
+  void tokenize();
+  unsigned mNumThreads;
+  bool mTokenized;
+  std::vector<PascalToken> mTokens;
+  // the number of source lines read after scanning each token,
+  // used to send the source lines at the same time as the lazy scanner
+  std::vector<int> mLinesRead;
+  size_t mNextIndex;
+};
+
+// scan on a separate thread, ahead of the parser,
+// and pass the tokens through a lock-free ring
+class PascalPipelinedScanner: public PascalScanner {
+public:
+  explicit PascalPipelinedScanner(std::shared_ptr<Source> source);
+  ~PascalPipelinedScanner() override;
+  void extractToken(PascalToken& token) override;
+private:
+  struct ScannedToken {
+    PascalToken token;
+    // the number of source lines read after scanning the token
+    int linesRead = 0;
+  };
+  void produce(const std::stop_token& stop);
+  // the scanner thread works on its own view of the source text,
+  // and the source lines are sent from the parser thread
+  std::shared_ptr<Source> mScanSource;
+  SpscRing<ScannedToken, 1024> mRing;
+  bool mReachedEof;
+  ScannedToken mEofToken;
+  std::jthread mProducer;
+};
+
+// hand out recorded tokens, followed by EOF,
+// for parsing a deferred routine body after the main parse
+class PascalReplayScanner: public PascalScanner {
+public:
+  explicit PascalReplayScanner(std::vector<PascalToken> tokens);
+  ~PascalReplayScanner() override;
+  void extractToken(PascalToken& token) override;
+private:
+  std::vector<PascalToken> mTokens;
+  size_t mNextIndex;
+};
+
+// the statement part of a routine, parsed when its ICode is first needed
+struct DeferredBody {
+  std::weak_ptr<SymbolTableEntryImplBase> routine;
+  // the symbol tables of the routine and its enclosing routines, outermost first
+  std::vector<std::weak_ptr<SymbolTableImplBase>> enclosingTables;
+  // from BEGIN to the matching END, followed by EOF; released once parsed
+  std::vector<PascalToken> tokens;
+  // of the token types, texts and lines relative to the first line,
+  // so that a routine moved as a whole keeps its hash
+  std::uint64_t hash = 0;
+  int firstLine = 0;
+  // set by the routine cache, builds the ICode without parsing the tokens
+  // (or returns nullptr if the cached ICode does not fit any more)
+  std::function<std::shared_ptr<ICodeNodeImplBase>()> cachedRoot;
+  bool reused = false;
 };
 
 class PascalParserTopDown:
@@ -44,41 +186,76 @@ public:
   ~PascalParserTopDown() override;
   void parse() override;
   int errorCount() const override;
-  std::shared_ptr<PascalToken> synchronize(const std::set<PascalTokenTypeImpl>& sync_set);
+  std::shared_ptr<PascalToken> synchronize(const TokenTypeSet& sync_set);
+  // only parse the headers and declarations of procedures and functions,
+  // and parse the statements of a routine when its ICode is first needed
+  void setLazyRoutineBodies(bool lazy);
+  // take the ICode of unchanged routines from the cache, and parse the others
+  void setRoutineCache(std::shared_ptr<RoutineCache> routine_cache);
+  // share equal constant and plain variable leaves of the ICode instead of
+  // creating one node per use, which turns the trees into DAGs
+  void setSharedLeaves(bool shared);
+  // the hash-consing table of the leaves, or nullptr if they are not shared
+  [[nodiscard]] const std::unique_ptr<ICodeNodePool>& nodePool() const;
+  // whether the statements of the routines are parsed after the declarations
+  [[nodiscard]] bool defersRoutineBodies() const;
+  // record the tokens from the current BEGIN to the matching END,
+  // and let the ICode of the routine parse them on demand
+  void deferStatements(const std::shared_ptr<SymbolTableEntryImplBase>& routine_id,
+                       ICodeImplBase& intermediate_code);
+  // in source order
+  [[nodiscard]] const std::vector<DeferredBody>& deferredBodies() const;
   boost::signals2::signal<void(const int, const int, const PascalTokenTypeImpl, const std::string&, std::any)> pascalTokenMessage;
   boost::signals2::signal<void(const int, const int, const float)> parserSummary;
   boost::signals2::signal<void(const int, const int, const std::string&, const std::string&, const std::any&)> tokenMessage;
   boost::signals2::signal<void(const int, const int, const std::string&, const std::string&)> syntaxErrorMessage;
   friend class PascalSubparserTopDownBase;
 protected:
+  std::shared_ptr<ICodeNodeImplBase> parseDeferredStatements(size_t index);
+  // parse a deferred body for its ICode, while the program is running
+  std::shared_ptr<ICodeNodeImplBase> loadDeferredStatements(size_t index);
+  // parse the deferred bodies that are still unparsed, in source order
+  void parseDeferredBodies();
   std::shared_ptr<SymbolTableEntryImplBase> mRoutineId;
   std::shared_ptr<PascalErrorHandler> mErrorHandler;
   std::shared_ptr<ICodeNodeImplBase> mRootNode;
+  bool mLazyRoutineBodies;
+  std::shared_ptr<RoutineCache> mRoutineCache;
+  std::vector<DeferredBody> mDeferredBodies;
+  std::unique_ptr<ICodeNodePool> mNodePool;
 };
 
 class PascalSubparserTopDownBase {
 public:
-  using TokenTypeSet = std::set<PascalTokenTypeImpl>;
-  explicit PascalSubparserTopDownBase(const std::shared_ptr<PascalParserTopDown>& pascal_parser);
+  using TokenTypeSet = ::TokenTypeSet;
+  explicit PascalSubparserTopDownBase(PascalParserTopDown& pascal_parser);
   virtual ~PascalSubparserTopDownBase();
-  [[nodiscard]] std::shared_ptr<PascalToken> currentToken() const;
-  std::shared_ptr<PascalToken> nextToken();
-  std::shared_ptr<PascalToken> synchronize(const std::set<PascalTokenTypeImpl>& sync_set);
-  std::shared_ptr<SymbolTableStackImplBase> getSymbolTableStack();
-  [[nodiscard]] std::shared_ptr<PascalScanner> scanner() const;
+  // the accessors return references into the parser, so that creating
+  // a subparser for every production costs no reference counting
+  [[nodiscard]] const std::shared_ptr<PascalToken>& currentToken() const;
+  const std::shared_ptr<PascalToken>& nextToken();
+  std::shared_ptr<PascalToken> synchronize(const TokenTypeSet& sync_set);
+  const std::shared_ptr<SymbolTableStackImplBase>& getSymbolTableStack();
+  [[nodiscard]] const std::shared_ptr<PascalScanner>& scanner() const;
   [[nodiscard]] int errorCount();
-  std::shared_ptr<PascalErrorHandler> errorHandler();
-  std::shared_ptr<PascalParserTopDown> currentParser();
+  const std::shared_ptr<PascalErrorHandler>& errorHandler();
+  PascalParserTopDown& currentParser();
   virtual std::shared_ptr<ICodeNodeImplBase> parse(
     std::shared_ptr<PascalToken> token,
     std::shared_ptr<SymbolTableEntryImplBase> parent_id);
   static void setLineNumber(std::shared_ptr<ICodeNodeImplBase>& node,
                             const std::shared_ptr<PascalToken>& token);
+  // constant and plain variable leaves, shared with their equal leaves in the DAG mode
+  std::shared_ptr<ICodeNodeImplBase> createConstantNode(ICodeNodeTypeImpl type, const VariableValueT& value,
+                                                        const std::shared_ptr<TypeSpecImplBase>& type_spec);
+  std::shared_ptr<ICodeNodeImplBase> createVariableNode(const std::shared_ptr<SymbolTableEntryImplBase>& id,
+                                                        const std::shared_ptr<TypeSpecImplBase>& type_spec);
   static const std::unordered_map<PascalTokenTypeImpl, ICodeNodeTypeImpl> relOpsMap;
   static const std::unordered_map<PascalTokenTypeImpl, ICodeNodeTypeImpl> addOpsMap;
   static const std::unordered_map<PascalTokenTypeImpl, ICodeNodeTypeImpl> multOpsMap;
 private:
-  std::shared_ptr<PascalParserTopDown> mPascalParser;
+  // borrowed from the top-level parser, which outlives all subparsers
+  PascalParserTopDown& mPascalParser;
 };
 
 class PascalErrorHandler {
@@ -86,60 +263,18 @@ public:
   PascalErrorHandler();
   virtual ~PascalErrorHandler();
   void flag(const std::shared_ptr<PascalToken> &token, PascalErrorCode errorCode,
-            const std::shared_ptr<PascalParserTopDown>& parser);
-  static void abortTranslation(PascalErrorCode errorCode, const std::shared_ptr<PascalParserTopDown>& parser);
+            PascalParserTopDown& parser);
+  static void abortTranslation(PascalErrorCode errorCode, PascalParserTopDown& parser);
   [[nodiscard]] int errorCount() const;
+  static std::string_view errorMessage(PascalErrorCode errorCode);
 private:
   static const int maxError = 25;
-  static std::map<PascalErrorCode, std::string> errorMessageMap;
   int mErrorCount;
 };
 
-class PascalErrorToken: public PascalToken {
-public:
-  PascalErrorToken();
-  PascalErrorToken(std::shared_ptr<Source> source, PascalErrorCode errorCode,
-                   const std::string& tokenText);
-  [[nodiscard]] unique_ptr<PascalToken> clone() const override;
-  void extract() override;
-};
-
-class PascalWordToken: public PascalToken {
-public:
-  explicit PascalWordToken(std::shared_ptr<Source> source);
-  [[nodiscard]] unique_ptr<PascalToken> clone() const override;
-  void extract() override;
-};
-
-class PascalStringToken: public PascalToken {
-public:
-  explicit PascalStringToken(std::shared_ptr<Source> source);
-  [[nodiscard]] unique_ptr<PascalToken> clone() const override;
-  void extract() override;
-};
-
-class PascalSpecialSymbolToken: public PascalToken {
-public:
-  explicit PascalSpecialSymbolToken(std::shared_ptr<Source> source);
-  [[nodiscard]] unique_ptr<PascalToken> clone() const override;
-  void extract() override;
-};
-
-class PascalNumberToken: public PascalToken {
-public:
-  explicit PascalNumberToken(std::shared_ptr<Source> source);
-  [[nodiscard]] unique_ptr<PascalToken> clone() const override;
-  void extract() override;
-  void extractNumber(std::string& text);
-private:
-  std::string unsignedIntegerDigits(std::string& text);
-  PascalInteger computeIntegerValue(const std::string& digits);
-  PascalFloat computeFloatValue(
-      const std::string &whole_digits, const std::string &fraction_digits,
-      const std::string &exponent_digits, char exponent_sign);
-};
-
+// lexer_threads > 0 tokenizes the source in parallel before parsing,
+// pipelined scans on a separate thread while parsing
 std::unique_ptr<PascalParserTopDown> createPascalParser(const std::string& language, const std::string& type,
-  const std::shared_ptr<Source>& source);
+  const std::shared_ptr<Source>& source, unsigned lexer_threads = 0, bool pipelined = false);
 
 #endif // PASCALFRONTEND_H
@@ -5,12 +5,11 @@
 Predefined& Predefined::instance(std::shared_ptr<SymbolTableStackImplBase>& symbol_table_stack)
 {
   static Predefined s;
-  static bool firsttime = true;
-  if (firsttime) {
-    s.initialize(symbol_table_stack);
-    _instance = &s;
-    firsttime = false;
-  }
+  // the types are created once for the whole process, but every
+  // compilation unit gets its own identifiers, so that nothing of a
+  // unit (such as the line numbers of the references) outlives it
+  s.initialize(symbol_table_stack);
+  _instance = &s;
   return s;
 }
 
@@ -26,6 +25,19 @@ Predefined::Predefined()
 {
 }
 
+std::vector<std::shared_ptr<SymbolTableEntryImplBase>> Predefined::entries() const
+{
+  return {integerId, realId, booleanId, charId, falseId, trueId,
+          readId, readlnId, writeId, writelnId,
+          absId, arctanId, chrId, cosId, eofId, eolnId, expId, lnId, oddId,
+          ordId, predId, roundId, sinId, sqrId, sqrtId, succId, truncId};
+}
+
+std::vector<std::shared_ptr<TypeSpecImplBase>> Predefined::types() const
+{
+  return {integerType, realType, booleanType, charType, undefinedType};
+}
+
 void Predefined::initialize(std::shared_ptr<SymbolTableStackImplBase> &symbol_table_stack) {
   initializeTypes(symbol_table_stack);
   initializeConstants(symbol_table_stack);
@@ -33,32 +45,33 @@ void Predefined::initialize(std::shared_ptr<SymbolTableStackImplBase> &symbol_ta
 }
 
 void Predefined::initializeTypes(std::shared_ptr<SymbolTableStackImplBase> &symbol_table_stack) {
+  if (integerType == nullptr) {
+    integerType = std::make_unique<TypeSpecImpl>(TypeFormImpl::SCALAR);
+    realType = std::make_unique<TypeSpecImpl>(TypeFormImpl::SCALAR);
+    booleanType = std::make_unique<TypeSpecImpl>(TypeFormImpl::ENUMERATION);
+    charType = std::make_unique<TypeSpecImpl>(TypeFormImpl::SCALAR);
+    undefinedType = std::make_unique<TypeSpecImpl>(TypeFormImpl::SCALAR);
+  }
   // integer type
-  integerType = std::make_unique<TypeSpecImpl>(TypeFormImpl::SCALAR);
   integerId = symbol_table_stack->enterLocal("integer");
   integerId->setDefinition(DefinitionImpl::TYPE);
   integerId->setTypeSpec(integerType);
   integerType->setIdentifier(integerId);
   // real type
-  realType = std::make_unique<TypeSpecImpl>(TypeFormImpl::SCALAR);
   realId = symbol_table_stack->enterLocal("real");
   realId->setDefinition(DefinitionImpl::TYPE);
   realId->setTypeSpec(realType);
   realType->setIdentifier(realId);
   // boolean type
-  booleanType = std::make_unique<TypeSpecImpl>(TypeFormImpl::ENUMERATION);
   booleanId = symbol_table_stack->enterLocal("boolean");
   booleanId->setDefinition(DefinitionImpl::TYPE);
   booleanId->setTypeSpec(booleanType);
   booleanType->setIdentifier(booleanId);
   // char type
-  charType = std::make_unique<TypeSpecImpl>(TypeFormImpl::SCALAR);
   charId = symbol_table_stack->enterLocal("char");
   charId->setDefinition(DefinitionImpl::TYPE);
   charId->setTypeSpec(charType);
   charType->setIdentifier(charId);
-  // undefined type
-  undefinedType = std::make_unique<TypeSpecImpl>(TypeFormImpl::SCALAR);
 }
 
 void Predefined::initializeConstants(std::shared_ptr<SymbolTableStackImplBase> &symbol_table_stack) {
@@ -44,9 +44,13 @@ public:
 public:
   Predefined(Predefined const&) = delete;
   void operator=(Predefined const&) = delete;
+  // enter the predefined identifiers into a new symbol table stack
   static Predefined& instance(std::shared_ptr<SymbolTableStackImplBase>& symbol_table_stack);
   // this overload can only be called after initialization!
   static Predefined& instance();
+  // all predefined identifiers and types in a fixed order
+  [[nodiscard]] std::vector<std::shared_ptr<SymbolTableEntryImplBase>> entries() const;
+  [[nodiscard]] std::vector<std::shared_ptr<TypeSpecImplBase>> types() const;
 private:
   void initialize(std::shared_ptr<SymbolTableStackImplBase>& symbol_table_stack);
   void initializeTypes(std::shared_ptr<SymbolTableStackImplBase>& symbol_table_stack);
@@ -0,0 +1,677 @@
+#include "RoutineCache.h"
+#include "ICodeImage.h"
+#include "IntermediateImpl.h"
+#include "Predefined.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <fmt/format.h>
+
+namespace {
+
+constexpr char cacheMagic[8] = {'P', 'A', 'S', 'R', 'T', 'N', '\0', '\0'};
+// bump the version whenever the layout of a record changes
+constexpr std::uint32_t cacheVersion = 1;
+constexpr std::uint32_t none = static_cast<std::uint32_t>(-1);
+
+// FNV-1a over the fields fed to it
+class Hasher {
+public:
+  void add(std::uint64_t x) {
+    for (int i = 0; i < 8; ++i) {
+      mHash ^= (x >> (8 * i)) & 0xff;
+      mHash *= 1099511628211ull;
+    }
+  }
+  void addString(std::string_view s) {
+    add(static_cast<std::uint64_t>(s.size()));
+    for (const char c: s) {
+      mHash ^= static_cast<unsigned char>(c);
+      mHash *= 1099511628211ull;
+    }
+  }
+  void addValue(const VariableValueT& value) {
+    add(static_cast<std::uint64_t>(value.index()));
+    std::visit(overloaded{
+      [](const std::monostate&){},
+      [this](const bool x){add(static_cast<std::uint64_t>(x));},
+      [this](const PascalInteger x){add(static_cast<std::uint64_t>(x));},
+      [this](const PascalFloat x){add(std::bit_cast<std::uint64_t>(static_cast<double>(x)));},
+      [this](const std::string& x){addString(x);},
+      [this](const PascalErrorCode x){add(static_cast<std::uint64_t>(x));}
+    }, value);
+  }
+  [[nodiscard]] std::uint64_t value() const {return mHash;}
+private:
+  std::uint64_t mHash = 14695981039346656037ull;
+};
+
+class ByteWriter {
+public:
+  template <typename T>
+  void put(const T& x) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    mData.append(reinterpret_cast<const char*>(&x), sizeof(T));
+  }
+  void putString(std::string_view s) {
+    put(static_cast<std::uint64_t>(s.size()));
+    mData.append(s);
+  }
+  void putValue(const VariableValueT& value) {
+    put(static_cast<std::uint32_t>(value.index()));
+    std::visit(overloaded{
+      [](const std::monostate&){},
+      [this](const bool x){put(static_cast<std::uint8_t>(x));},
+      [this](const PascalInteger x){put(x);},
+      [this](const PascalFloat x){put(x);},
+      [this](const std::string& x){putString(x);},
+      [this](const PascalErrorCode x){put(static_cast<std::uint32_t>(x));}
+    }, value);
+  }
+  std::string& data() {return mData;}
+private:
+  std::string mData;
+};
+
+// throws std::runtime_error on truncated or malformed data
+class ByteReader {
+public:
+  explicit ByteReader(std::string_view data): mData(data), mPos(0) {}
+  template <typename T>
+  T get() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    check(sizeof(T) <= mData.size() - mPos);
+    T x;
+    std::memcpy(&x, mData.data() + mPos, sizeof(T));
+    mPos += sizeof(T);
+    return x;
+  }
+  std::string_view getString() {
+    const auto size = get<std::uint64_t>();
+    check(size <= mData.size() - mPos);
+    const auto s = mData.substr(mPos, size);
+    mPos += size;
+    return s;
+  }
+  VariableValueT getValue() {
+    switch (get<std::uint32_t>()) {
+      case 0: return std::monostate{};
+      case 1: return get<std::uint8_t>() != 0;
+      case 2: return get<PascalInteger>();
+      case 3: return get<PascalFloat>();
+      case 4: return std::string(getString());
+      case 5: return static_cast<PascalErrorCode>(get<std::uint32_t>());
+      default: check(false);
+    }
+    return std::monostate{};
+  }
+  [[nodiscard]] bool atEnd() const {return mPos == mData.size();}
+  static void check(bool condition) {
+    if (!condition) throw std::runtime_error("invalid routine cache");
+  }
+private:
+  std::string_view mData;
+  size_t mPos;
+};
+
+// a reference is a path of steps from the visible symbol tables
+// to a symbol table entry or a type
+enum class RefOp: std::uint8_t {
+  // the predefined type arg
+  PREDEFINED_TYPE,
+  // the entry name of the visible symbol table at nesting level arg
+  ENTRY,
+  // the type of the entry
+  TYPE,
+  // the types making up the type
+  BASE_TYPE, INDEX_TYPE, ELEMENT_TYPE,
+  // the field name of the record type
+  FIELD,
+  // a new string type of arg characters
+  STRING_TYPE
+};
+
+struct RefStep {
+  RefOp op;
+  std::uint32_t arg;
+  std::string name;
+};
+
+using Ref = std::vector<RefStep>;
+
+Ref extended(const Ref& path, RefOp op, std::uint32_t arg = 0, const std::string& name = "") {
+  Ref result(path);
+  result.push_back({op, arg, name});
+  return result;
+}
+
+// the paths of the entries and types reachable from the entries of a symbol table
+class TableIndex {
+public:
+  TableIndex(const SymbolTableImplBase& symbol_table,
+             const std::unordered_map<const void*, std::uint32_t>& predefined_types) {
+    const auto level = static_cast<std::uint32_t>(symbol_table.nestingLevel());
+    for (const auto& entry: symbol_table.sortedEntries()) {
+      const Ref path{{RefOp::ENTRY, level, entry->name()}};
+      mEntries.emplace(entry.get(), path);
+      addType(entry->getTypeSpec(), extended(path, RefOp::TYPE), predefined_types);
+    }
+  }
+  [[nodiscard]] const Ref* entry(const void* p) const {
+    const auto search = mEntries.find(p);
+    return search == mEntries.end() ? nullptr : &search->second;
+  }
+  [[nodiscard]] const Ref* type(const void* p) const {
+    const auto search = mTypes.find(p);
+    return search == mTypes.end() ? nullptr : &search->second;
+  }
+private:
+  void addType(const std::shared_ptr<TypeSpecImplBase>& type_spec, const Ref& path,
+               const std::unordered_map<const void*, std::uint32_t>& predefined_types) {
+    if (type_spec == nullptr || predefined_types.contains(type_spec.get())) return;
+    if (!mTypes.emplace(type_spec.get(), path).second) return;
+    if (const auto t = typeAttribute<TypeKeyImpl::SUBRANGE_BASE_TYPE>(*type_spec)) {
+      addType(t.value(), extended(path, RefOp::BASE_TYPE), predefined_types);
+    }
+    if (const auto t = typeAttribute<TypeKeyImpl::ARRAY_INDEX_TYPE>(*type_spec)) {
+      addType(t.value(), extended(path, RefOp::INDEX_TYPE), predefined_types);
+    }
+    if (const auto t = typeAttribute<TypeKeyImpl::ARRAY_ELEMENT_TYPE>(*type_spec)) {
+      addType(t.value(), extended(path, RefOp::ELEMENT_TYPE), predefined_types);
+    }
+    if (const auto t = typeAttribute<TypeKeyImpl::RECORD_SYMTAB>(*type_spec); t && t.value()) {
+      for (const auto& field: t.value()->sortedEntries()) {
+        const auto field_path = extended(path, RefOp::FIELD, 0, field->name());
+        mEntries.emplace(field.get(), field_path);
+        addType(field->getTypeSpec(), extended(field_path, RefOp::TYPE), predefined_types);
+      }
+    }
+  }
+  std::unordered_map<const void*, Ref> mEntries;
+  std::unordered_map<const void*, Ref> mTypes;
+};
+
+std::unordered_map<const void*, std::uint32_t> predefinedTypeIds() {
+  std::unordered_map<const void*, std::uint32_t> result;
+  const auto predefined_types = Predefined::instance().types();
+  for (std::uint32_t i = 0; i < predefined_types.size(); ++i) {
+    result.emplace(predefined_types[i].get(), i);
+  }
+  return result;
+}
+
+// the global symbol table followed by the enclosing tables of the body, by nesting level
+std::vector<std::shared_ptr<SymbolTableImplBase>> visibleTables(
+  const std::shared_ptr<SymbolTableImplBase>& global_table, const DeferredBody& body) {
+  std::vector<std::shared_ptr<SymbolTableImplBase>> result{global_table};
+  for (const auto& table: body.enclosingTables) {
+    auto symbol_table = table.lock();
+    if (symbol_table == nullptr) return {};
+    result.push_back(std::move(symbol_table));
+  }
+  for (size_t i = 0; i < result.size(); ++i) {
+    if (result[i] == nullptr || result[i]->nestingLevel() != static_cast<int>(i)) return {};
+  }
+  return result;
+}
+
+// the references and the nodes of the ICode in breadth-first order,
+// where the children of each node follow those of the previous nodes
+std::optional<std::string> encodeRoutine(const std::shared_ptr<ICodeNodeImplBase>& root, const int first_line,
+                                         const std::vector<const TableIndex*>& indexes,
+                                         const std::unordered_map<const void*, std::uint32_t>& predefined_types) {
+  std::vector<const Ref*> refs;
+  std::vector<Ref> string_refs;
+  std::unordered_map<const void*, std::uint32_t> ref_ids;
+  const auto add_ref = [&](const void* p, const Ref* path) {
+    const auto id = static_cast<std::uint32_t>(refs.size());
+    refs.push_back(path);
+    ref_ids.emplace(p, id);
+    return id;
+  };
+  // innermost first, like the lookup of the statement parser
+  const auto entry_ref = [&](const std::shared_ptr<SymbolTableEntryImplBase>& entry) -> std::optional<std::uint32_t> {
+    if (entry == nullptr) return none;
+    if (const auto search = ref_ids.find(entry.get()); search != ref_ids.end()) return search->second;
+    for (auto it = indexes.rbegin(); it != indexes.rend(); ++it) {
+      if (const auto path = (*it)->entry(entry.get())) return add_ref(entry.get(), path);
+    }
+    return std::nullopt;
+  };
+  const auto type_ref = [&](const std::shared_ptr<TypeSpecImplBase>& type_spec) -> std::optional<std::uint32_t> {
+    if (type_spec == nullptr) return none;
+    if (const auto search = ref_ids.find(type_spec.get()); search != ref_ids.end()) return search->second;
+    if (const auto search = predefined_types.find(type_spec.get()); search != predefined_types.end()) {
+      string_refs.push_back({{RefOp::PREDEFINED_TYPE, search->second, ""}});
+      return add_ref(type_spec.get(), nullptr);
+    }
+    for (auto it = indexes.rbegin(); it != indexes.rend(); ++it) {
+      if (const auto path = (*it)->type(type_spec.get())) return add_ref(type_spec.get(), path);
+    }
+    // string constants have types of their own
+    if (type_spec->isPascalString()) {
+      if (const auto count = typeAttribute<TypeKeyImpl::ARRAY_ELEMENT_COUNT>(*type_spec)) {
+        string_refs.push_back({{RefOp::STRING_TYPE, static_cast<std::uint32_t>(count.value()), ""}});
+        return add_ref(type_spec.get(), nullptr);
+      }
+    }
+    return std::nullopt;
+  };
+  // refs without an index path are kept in string_refs, in order
+  ByteWriter nodes;
+  std::vector<std::shared_ptr<ICodeNodeImplBase>> queue{root};
+  for (size_t i = 0; i < queue.size(); ++i) {
+    const auto node = queue[i];
+    std::uint32_t flags = 0;
+    std::int32_t line = 0;
+    std::uint32_t id = none;
+    if (node->hasAttribute(ICodeKeyTypeImpl::LINE)) {
+      flags |= 1u << static_cast<unsigned>(ICodeKeyTypeImpl::LINE);
+      line = node->getAttribute<ICodeKeyTypeImpl::LINE>() - first_line;
+    }
+    if (node->hasAttribute(ICodeKeyTypeImpl::ID)) {
+      flags |= 1u << static_cast<unsigned>(ICodeKeyTypeImpl::ID);
+      const auto ref = entry_ref(node->getAttribute<ICodeKeyTypeImpl::ID>());
+      if (!ref) return std::nullopt;
+      id = ref.value();
+    }
+    const auto type_spec = type_ref(node->getTypeSpec());
+    if (!type_spec) return std::nullopt;
+    nodes.put(static_cast<std::uint32_t>(node->type()));
+    nodes.put(flags);
+    nodes.put(line);
+    nodes.put(id);
+    nodes.put(type_spec.value());
+    nodes.put(static_cast<std::uint32_t>(node->numChildren()));
+    if (node->hasAttribute(ICodeKeyTypeImpl::VALUE)) {
+      nodes.put(std::uint8_t{1});
+      nodes.putValue(node->getAttribute<ICodeKeyTypeImpl::VALUE>());
+    } else {
+      nodes.put(std::uint8_t{0});
+    }
+    for (auto it = node->childrenBegin(); it != node->childrenEnd(); ++it) {
+      if (*it == nullptr) return std::nullopt;
+      queue.push_back(*it);
+    }
+  }
+  ByteWriter out;
+  out.put(static_cast<std::uint32_t>(refs.size()));
+  size_t next_string_ref = 0;
+  for (const auto* ref: refs) {
+    const Ref& path = (ref != nullptr) ? *ref : string_refs[next_string_ref++];
+    out.put(static_cast<std::uint32_t>(path.size()));
+    for (const auto& step: path) {
+      out.put(static_cast<std::uint8_t>(step.op));
+      out.put(step.arg);
+      out.putString(step.name);
+    }
+  }
+  out.put(static_cast<std::uint32_t>(queue.size()));
+  out.data() += nodes.data();
+  return std::move(out.data());
+}
+
+// build the ICode of a record against the visible tables, nullptr if a reference does not resolve
+std::shared_ptr<ICodeNodeImplBase> decodeRoutine(std::string_view data, const int first_line,
+                                                 const std::vector<std::shared_ptr<SymbolTableImplBase>>& tables) {
+  if (tables.empty()) return nullptr;
+  try {
+    ByteReader in(data);
+    const auto predefined_types = Predefined::instance().types();
+    std::vector<std::shared_ptr<SymbolTableEntryImplBase>> entries(in.get<std::uint32_t>());
+    std::vector<std::shared_ptr<TypeSpecImplBase>> types(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+      std::shared_ptr<SymbolTableEntryImplBase> entry;
+      std::shared_ptr<TypeSpecImplBase> type_spec;
+      const auto step_count = in.get<std::uint32_t>();
+      for (std::uint32_t j = 0; j < step_count; ++j) {
+        const auto op = static_cast<RefOp>(in.get<std::uint8_t>());
+        const auto arg = in.get<std::uint32_t>();
+        const auto name = std::string(in.getString());
+        switch (op) {
+          case RefOp::PREDEFINED_TYPE: {
+            if (arg >= predefined_types.size()) return nullptr;
+            type_spec = predefined_types[arg];
+            break;
+          }
+          case RefOp::ENTRY: {
+            if (arg >= tables.size()) return nullptr;
+            entry = tables[arg]->lookup(name);
+            break;
+          }
+          case RefOp::TYPE: {
+            if (entry == nullptr) return nullptr;
+            type_spec = entry->getTypeSpec();
+            entry = nullptr;
+            break;
+          }
+          case RefOp::BASE_TYPE:
+          case RefOp::INDEX_TYPE:
+          case RefOp::ELEMENT_TYPE: {
+            if (type_spec == nullptr) return nullptr;
+            const auto t = (op == RefOp::BASE_TYPE) ? typeAttribute<TypeKeyImpl::SUBRANGE_BASE_TYPE>(*type_spec) :
+                           (op == RefOp::INDEX_TYPE) ? typeAttribute<TypeKeyImpl::ARRAY_INDEX_TYPE>(*type_spec) :
+                                                       typeAttribute<TypeKeyImpl::ARRAY_ELEMENT_TYPE>(*type_spec);
+            type_spec = t.value_or(nullptr);
+            break;
+          }
+          case RefOp::FIELD: {
+            if (type_spec == nullptr) return nullptr;
+            const auto record_symtab = typeAttribute<TypeKeyImpl::RECORD_SYMTAB>(*type_spec);
+            if (!record_symtab || record_symtab.value() == nullptr) return nullptr;
+            entry = record_symtab.value()->lookup(name);
+            type_spec = nullptr;
+            break;
+          }
+          case RefOp::STRING_TYPE: {
+            type_spec = createStringType(std::string(arg, ' '));
+            break;
+          }
+          default: return nullptr;
+        }
+        if (entry == nullptr && type_spec == nullptr) return nullptr;
+      }
+      entries[i] = std::move(entry);
+      types[i] = std::move(type_spec);
+    }
+    const auto node_count = in.get<std::uint32_t>();
+    ByteReader::check(node_count > 0);
+    std::vector<std::shared_ptr<ICodeNodeImplBase>> nodes;
+    std::vector<std::uint32_t> child_counts;
+    nodes.reserve(node_count);
+    child_counts.reserve(node_count);
+    for (std::uint32_t i = 0; i < node_count; ++i) {
+      const auto type = static_cast<ICodeNodeTypeImpl>(in.get<std::uint32_t>());
+      const auto flags = in.get<std::uint32_t>();
+      const auto line = in.get<std::int32_t>();
+      const auto id = in.get<std::uint32_t>();
+      const auto type_spec = in.get<std::uint32_t>();
+      child_counts.push_back(in.get<std::uint32_t>());
+      auto node = createICodeNode(type);
+      if (flags & (1u << static_cast<unsigned>(ICodeKeyTypeImpl::LINE))) {
+        node->setAttribute<ICodeKeyTypeImpl::LINE>(line + first_line);
+      }
+      if (flags & (1u << static_cast<unsigned>(ICodeKeyTypeImpl::ID))) {
+        if (id >= entries.size() || entries[id] == nullptr) return nullptr;
+        node->setAttribute<ICodeKeyTypeImpl::ID>(entries[id]);
+      }
+      if (type_spec != none) {
+        if (type_spec >= types.size() || types[type_spec] == nullptr) return nullptr;
+        node->setTypeSpec(types[type_spec]);
+      }
+      if (in.get<std::uint8_t>() != 0) {
+        node->setAttribute<ICodeKeyTypeImpl::VALUE>(in.getValue());
+      }
+      nodes.push_back(std::move(node));
+    }
+    ByteReader::check(in.atEnd());
+    size_t next_child = 1;
+    for (std::uint32_t i = 0; i < node_count; ++i) {
+      ByteReader::check(child_counts[i] <= node_count - next_child);
+      for (std::uint32_t k = 0; k < child_counts[i]; ++k) {
+        nodes[i]->addChild(nodes[next_child++]);
+      }
+    }
+    return nodes.front();
+  } catch (const std::runtime_error&) {
+    return nullptr;
+  }
+}
+
+void hashType(Hasher& h, const std::shared_ptr<TypeSpecImplBase>& type_spec, bool definition,
+              const std::unordered_map<const void*, std::uint32_t>& predefined_types);
+
+void hashEntries(Hasher& h, const SymbolTableImplBase& symbol_table,
+                 const std::unordered_map<const void*, std::uint32_t>& predefined_types) {
+  for (const auto& entry: symbol_table.sortedEntries()) {
+    h.addString(entry->name());
+    h.add(static_cast<std::uint64_t>(entry->getDefinition()));
+    const auto type_spec = entry->getTypeSpec();
+    // a type identifier carries the structure of its type, the other entries its name
+    hashType(h, type_spec, (entry->getDefinition() == DefinitionImpl::TYPE) && (type_spec != nullptr) &&
+                           (type_spec->getIdentifier() == entry), predefined_types);
+    if (const auto v = entry->getAttribute<SymbolTableKeyTypeImpl::CONSTANT_VALUE>()) h.addValue(v.value());
+    if (const auto v = entry->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_CODE>()) {
+      h.add(static_cast<std::uint64_t>(v.value()));
+    }
+    if (const auto v = entry->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_PARMS>()) {
+      h.add(static_cast<std::uint64_t>(v.value().size()));
+      for (const auto& parm: v.value()) {
+        h.addString(parm->name());
+        h.add(static_cast<std::uint64_t>(parm->getDefinition()));
+        hashType(h, parm->getTypeSpec(), false, predefined_types);
+      }
+    }
+  }
+}
+
+void hashType(Hasher& h, const std::shared_ptr<TypeSpecImplBase>& type_spec, const bool definition,
+              const std::unordered_map<const void*, std::uint32_t>& predefined_types) {
+  if (type_spec == nullptr) {
+    h.add(std::uint64_t{0});
+    return;
+  }
+  if (const auto search = predefined_types.find(type_spec.get()); search != predefined_types.end()) {
+    h.add(std::uint64_t{1});
+    h.add(static_cast<std::uint64_t>(search->second));
+    return;
+  }
+  const auto identifier = type_spec->getIdentifier();
+  if (!definition && identifier != nullptr) {
+    h.add(std::uint64_t{2});
+    h.addString(identifier->name());
+    return;
+  }
+  h.add(std::uint64_t{3});
+  h.add(static_cast<std::uint64_t>(type_spec->form()));
+  if (const auto t = typeAttribute<TypeKeyImpl::ENUMERATION_CONSTANTS>(*type_spec)) {
+    for (const auto& constant: t.value()) {
+      const auto c = constant.lock();
+      h.addString(c ? c->name() : std::string());
+    }
+  }
+  if (const auto t = typeAttribute<TypeKeyImpl::SUBRANGE_BASE_TYPE>(*type_spec)) hashType(h, t.value(), false, predefined_types);
+  if (const auto v = typeAttribute<TypeKeyImpl::SUBRANGE_MIN_VALUE>(*type_spec)) h.addValue(v.value());
+  if (const auto v = typeAttribute<TypeKeyImpl::SUBRANGE_MAX_VALUE>(*type_spec)) h.addValue(v.value());
+  if (const auto t = typeAttribute<TypeKeyImpl::ARRAY_INDEX_TYPE>(*type_spec)) hashType(h, t.value(), false, predefined_types);
+  if (const auto t = typeAttribute<TypeKeyImpl::ARRAY_ELEMENT_TYPE>(*type_spec)) hashType(h, t.value(), false, predefined_types);
+  if (const auto v = typeAttribute<TypeKeyImpl::ARRAY_ELEMENT_COUNT>(*type_spec)) h.add(static_cast<std::uint64_t>(v.value()));
+  if (const auto t = typeAttribute<TypeKeyImpl::RECORD_SYMTAB>(*type_spec); t && t.value()) {
+    hashEntries(h, *t.value(), predefined_types);
+  }
+}
+
+}
+
+RoutineCache::RoutineCache(std::string path): mPath(std::move(path))
+{
+  std::ifstream ifs(mPath, std::ios::in | std::ios::binary);
+  if (!ifs.is_open()) return;
+  ifs.seekg(0, std::ios::end);
+  std::string buffer(static_cast<size_t>(std::max<std::streamoff>(ifs.tellg(), 0)), '\0');
+  ifs.seekg(0, std::ios::beg);
+  if (!ifs.read(buffer.data(), static_cast<std::streamsize>(buffer.size()))) return;
+  try {
+    ByteReader in(buffer);
+    for (const char c: cacheMagic) ByteReader::check(in.get<char>() == c);
+    if (in.get<std::uint32_t>() != cacheVersion) return;
+    const auto record_count = in.get<std::uint32_t>();
+    for (std::uint32_t i = 0; i < record_count; ++i) {
+      auto key = std::string(in.getString());
+      auto record = std::make_shared<Record>();
+      record->bodyHash = in.get<std::uint64_t>();
+      record->dependencyHash = in.get<std::uint64_t>();
+      record->data = in.getString();
+      mRecords.emplace(std::move(key), std::move(record));
+    }
+    ByteReader::check(in.atEnd());
+  } catch (const std::runtime_error&) {
+    mRecords.clear();
+  }
+}
+
+RoutineCache::~RoutineCache()
+{
+#ifdef DEBUG_DESTRUCTOR
+  std::cerr << "Destructor: " << BOOST_CURRENT_FUNCTION << std::endl;
+#endif
+}
+
+std::string RoutineCache::cachePath(const std::string& cache_dir, const std::string& source_path)
+{
+  std::error_code ec;
+  auto absolute_path = std::filesystem::absolute(source_path, ec);
+  if (ec) absolute_path = source_path;
+  return (std::filesystem::path(cache_dir) /
+          fmt::format("{:016x}.routines", ICodeImage::hash(absolute_path.lexically_normal().string()))).string();
+}
+
+std::unordered_map<const SymbolTableEntryImplBase*, std::string> RoutineCache::routineKeys(
+  const std::shared_ptr<SymbolTableStackImplBase>& symbol_table_stack) const
+{
+  std::unordered_map<const SymbolTableEntryImplBase*, std::string> result;
+  const auto program_id = symbol_table_stack->programId();
+  if (program_id == nullptr) return result;
+  std::vector<std::shared_ptr<SymbolTableEntryImplBase>> queue{program_id};
+  result.emplace(program_id.get(), program_id->name());
+  for (size_t i = 0; i < queue.size(); ++i) {
+    const auto routines = queue[i]->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_ROUTINES>();
+    if (!routines) continue;
+    const auto& key = result.at(queue[i].get());
+    for (const auto& routine: routines.value()) {
+      if (routine == nullptr || !result.emplace(routine.get(), key + "." + routine->name()).second) continue;
+      queue.push_back(routine);
+    }
+  }
+  return result;
+}
+
+std::uint64_t RoutineCache::dependencyHash(const std::shared_ptr<SymbolTableImplBase>& global_table,
+                                           const DeferredBody& body)
+{
+  const auto tables = visibleTables(global_table, body);
+  if (tables.empty()) return 0;
+  const auto predefined_types = predefinedTypeIds();
+  Hasher h;
+  for (const auto& table: tables) {
+    auto search = mSignatures.find(table.get());
+    if (search == mSignatures.end()) {
+      Hasher signature;
+      hashEntries(signature, *table, predefined_types);
+      search = mSignatures.emplace(table.get(), signature.value()).first;
+    }
+    h.add(search->second);
+  }
+  return h.value();
+}
+
+void RoutineCache::reuse(std::vector<DeferredBody>& deferred_bodies,
+                         const std::shared_ptr<SymbolTableStackImplBase>& symbol_table_stack)
+{
+  if (mRecords.empty()) return;
+  const auto keys = routineKeys(symbol_table_stack);
+  const auto global_table = symbol_table_stack->localSymbolTable();
+  for (auto& body: deferred_bodies) {
+    const auto routine_id = body.routine.lock();
+    if (routine_id == nullptr) continue;
+    const auto key = keys.find(routine_id.get());
+    if (key == keys.end()) continue;
+    const auto record = mRecords.find(key->second);
+    if (record == mRecords.end() || record->second->bodyHash != body.hash ||
+        record->second->dependencyHash != dependencyHash(global_table, body)) {
+      continue;
+    }
+    body.reused = true;
+    body.cachedRoot = [record = record->second, global = std::weak_ptr(global_table),
+                       tables = body.enclosingTables, first_line = body.firstLine]() {
+      DeferredBody scope;
+      scope.enclosingTables = tables;
+      return decodeRoutine(record->data, first_line, visibleTables(global.lock(), scope));
+    };
+  }
+}
+
+bool RoutineCache::save(const std::vector<DeferredBody>& deferred_bodies,
+                        const std::shared_ptr<SymbolTableStackImplBase>& symbol_table_stack)
+{
+  const auto keys = routineKeys(symbol_table_stack);
+  const auto global_table = symbol_table_stack->localSymbolTable();
+  const auto predefined_types = predefinedTypeIds();
+  std::unordered_map<const SymbolTableImplBase*, std::unique_ptr<TableIndex>> indexes;
+  std::vector<std::pair<std::string, std::shared_ptr<const Record>>> records;
+  for (const auto& body: deferred_bodies) {
+    const auto routine_id = body.routine.lock();
+    if (routine_id == nullptr) continue;
+    const auto key = keys.find(routine_id.get());
+    if (key == keys.end()) continue;
+    // an unchanged routine keeps its record
+    if (body.reused) {
+      const auto record = mRecords.find(key->second);
+      if (record != mRecords.end()) records.emplace_back(key->second, record->second);
+      continue;
+    }
+    // the statements of a lazy routine that never ran are not parsed
+    const auto icode = routine_id->getAttribute<SymbolTableKeyTypeImpl::ROUTINE_ICODE>();
+    if (!icode || icode.value() == nullptr || !icode.value()->isLoaded()) continue;
+    const auto root = icode.value()->getRoot();
+    const auto tables = visibleTables(global_table, body);
+    if (root == nullptr || tables.empty()) continue;
+    std::vector<const TableIndex*> table_indexes;
+    for (const auto& table: tables) {
+      auto& index = indexes[table.get()];
+      if (index == nullptr) index = std::make_unique<TableIndex>(*table, predefined_types);
+      table_indexes.push_back(index.get());
+    }
+    auto data = encodeRoutine(root, body.firstLine, table_indexes, predefined_types);
+    if (!data) continue;
+    auto record = std::make_shared<Record>();
+    record->bodyHash = body.hash;
+    record->dependencyHash = dependencyHash(global_table, body);
+    record->data = std::move(data.value());
+    records.emplace_back(key->second, std::move(record));
+  }
+  ByteWriter out;
+  for (const char c: cacheMagic) out.put(c);
+  out.put(cacheVersion);
+  out.put(static_cast<std::uint32_t>(records.size()));
+  for (const auto& [key, record]: records) {
+    out.putString(key);
+    out.put(record->bodyHash);
+    out.put(record->dependencyHash);
+    out.putString(record->data);
+  }
+  std::error_code ec;
+  const std::filesystem::path cache_path(mPath);
+  if (cache_path.has_parent_path()) {
+    std::filesystem::create_directories(cache_path.parent_path(), ec);
+  }
+  // write to a temporary file and rename it, so that concurrent runs
+  // never see a partial cache
+  const auto tmp_path = fmt::format("{}.{:x}.tmp", mPath,
+    std::chrono::high_resolution_clock::now().time_since_epoch().count());
+  {
+    std::ofstream ofs(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open()) return false;
+    ofs.write(out.data().data(), static_cast<std::streamsize>(out.data().size()));
+    if (!ofs) {
+      ofs.close();
+      std::filesystem::remove(tmp_path, ec);
+      return false;
+    }
+  }
+  std::filesystem::rename(tmp_path, cache_path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp_path, ec);
+    return false;
+  }
+  return true;
+}
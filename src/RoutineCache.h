@@ -0,0 +1,50 @@
+#ifndef ROUTINECACHE_H
+#define ROUTINECACHE_H
+
+#include "Intermediate.h"
+#include "PascalFrontend.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// the intermediate code of the routines from the previous run of a source file.
+// a routine whose statement tokens and visible declarations are unchanged
+// takes its ICode from the cache instead of parsing its statements again.
+// the nodes refer to symbol table entries and types by their paths from the
+// visible symbol tables, so that they resolve against the new declarations.
+class RoutineCache {
+public:
+  // read the cache file if there is a valid one
+  explicit RoutineCache(std::string path);
+  ~RoutineCache();
+  // the cache file of a source file in the cache directory, keyed by the source path
+  static std::string cachePath(const std::string& cache_dir, const std::string& source_path);
+  // let the unchanged deferred bodies build their ICode from the cache
+  void reuse(std::vector<DeferredBody>& deferred_bodies,
+             const std::shared_ptr<SymbolTableStackImplBase>& symbol_table_stack);
+  // write the ICode of the deferred bodies of an error-free program,
+  // return false if the cache file cannot be written
+  bool save(const std::vector<DeferredBody>& deferred_bodies,
+            const std::shared_ptr<SymbolTableStackImplBase>& symbol_table_stack);
+  struct Record {
+    std::uint64_t bodyHash = 0;
+    std::uint64_t dependencyHash = 0;
+    // the references and the nodes, see RoutineCache.cpp
+    std::string data;
+  };
+private:
+  // the key of each routine is the path of routine names from the program
+  std::unordered_map<const SymbolTableEntryImplBase*, std::string> routineKeys(
+    const std::shared_ptr<SymbolTableStackImplBase>& symbol_table_stack) const;
+  // of the declarations visible in the statements of a routine
+  std::uint64_t dependencyHash(const std::shared_ptr<SymbolTableImplBase>& global_table,
+                               const DeferredBody& body);
+  std::string mPath;
+  std::unordered_map<std::string, std::shared_ptr<const Record>> mRecords;
+  std::unordered_map<const SymbolTableImplBase*, std::uint64_t> mSignatures;
+};
+
+#endif // ROUTINECACHE_H
@@ -0,0 +1,46 @@
+#include "RuntimeStack.h"
+
+#include <iostream>
+#include <numeric>
+
+RuntimeStack::RuntimeStack() {}
+
+RuntimeStack::~RuntimeStack()
+{
+#ifdef DEBUG_DESTRUCTOR
+  std::cerr << "Destructor: " << BOOST_CURRENT_FUNCTION << std::endl;
+#endif
+}
+
+size_t RuntimeStack::push(int nesting_level, int slot_count)
+{
+  const auto level = static_cast<size_t>(nesting_level);
+  if (mDisplay.size() <= level) mDisplay.resize(level + 1, 0);
+  const size_t start = mValues.size();
+  const size_t end = start + static_cast<size_t>(slot_count);
+  mRecords.push_back({nesting_level, start, mDisplay[level]});
+  mValues.resize(end);
+  mLinks.resize(end);
+  std::iota(mLinks.begin() + static_cast<std::ptrdiff_t>(start), mLinks.end(), start);
+  return start;
+}
+
+void RuntimeStack::activate()
+{
+  const auto& record = mRecords.back();
+  mDisplay[static_cast<size_t>(record.nestingLevel)] = record.start;
+}
+
+void RuntimeStack::pop()
+{
+  const auto record = mRecords.back();
+  mRecords.pop_back();
+  mValues.resize(record.start);
+  mLinks.resize(record.start);
+  mDisplay[static_cast<size_t>(record.nestingLevel)] = record.previousStart;
+}
+
+void RuntimeStack::bind(size_t location, size_t target)
+{
+  mLinks[location] = target;
+}
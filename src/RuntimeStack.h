@@ -0,0 +1,58 @@
+#ifndef RUNTIMESTACK_H
+#define RUNTIMESTACK_H
+
+#include "Common.h"
+
+#include <cstddef>
+#include <vector>
+
+// the activation records of the interpreter
+// the records are contiguous in one array, and a record holds the values
+// in the slots that the parser assigned to the variables, the parameters
+// and the function result of its routine. the display keeps the start of
+// the latest record of each nesting level, so a (level, slot) pair is
+// one index away from its value.
+// the array only grows, so after the deepest call a call allocates nothing.
+class RuntimeStack {
+public:
+  RuntimeStack();
+  ~RuntimeStack();
+  RuntimeStack(const RuntimeStack&) = delete;
+  RuntimeStack& operator=(const RuntimeStack&) = delete;
+  // push a record of slot_count uninitialized values for a routine at nesting_level,
+  // and return the location of its first slot.
+  // the display does not show the record before activate(), so that the
+  // actual parameters are evaluated in the environment of the caller.
+  size_t push(int nesting_level, int slot_count);
+  // make the latest record the current one of its nesting level
+  void activate();
+  // pop the latest record, and restore the display entry it replaced
+  void pop();
+  // where the value of a slot lives, which is a slot of another record for a VAR parameter
+  [[nodiscard]] size_t location(int nesting_level, int slot) const {
+    return mLinks[mDisplay[nesting_level] + slot];
+  }
+  // only valid until the next push
+  [[nodiscard]] VariableValueT& at(size_t location) {
+    return mValues[location];
+  }
+  [[nodiscard]] VariableValueT& value(int nesting_level, int slot) {
+    return mValues[location(nesting_level, slot)];
+  }
+  // let the slot at location refer to the value at target
+  void bind(size_t location, size_t target);
+private:
+  struct Record {
+    int nestingLevel;
+    size_t start;
+    // the display entry of nestingLevel before the record was activated
+    size_t previousStart;
+  };
+  std::vector<VariableValueT> mValues;
+  // the location of the value of each slot, the slot itself unless it is bound
+  std::vector<size_t> mLinks;
+  std::vector<size_t> mDisplay;
+  std::vector<Record> mRecords;
+};
+
+#endif // RUNTIMESTACK_H
@@ -4,7 +4,7 @@
 namespace TypeChecker::TypeChecking {
   bool isInteger(const TypeSpecPtr& type_spec)
   {
-    return (type_spec != nullptr) && (type_spec->baseType() == Predefined::instance().integerType);
+    return (type_spec != nullptr) && (type_spec->rawBaseType() == Predefined::instance().integerType.get());
   }
 
   bool areBothInteger(const TypeSpecPtr& type_spec_a,
@@ -15,7 +15,7 @@ namespace TypeChecker::TypeChecking {
 
   bool isReal(const TypeSpecPtr& type_spec)
   {
-    return (type_spec != nullptr) && (type_spec->baseType() == Predefined::instance().realType);
+    return (type_spec != nullptr) && (type_spec->rawBaseType() == Predefined::instance().realType.get());
   }
 
   bool isIntegerOrReal(const TypeSpecPtr& type_spec)
@@ -33,7 +33,7 @@ namespace TypeChecker::TypeChecking {
 
   bool isBoolean(const TypeSpecPtr& type_spec)
   {
-    return (type_spec != nullptr) && (type_spec->baseType() == Predefined::instance().booleanType);
+    return (type_spec != nullptr) && (type_spec->rawBaseType() == Predefined::instance().booleanType.get());
   }
 
   bool areBothBoolean(const TypeSpecPtr& type_spec_a,
@@ -44,7 +44,7 @@ namespace TypeChecker::TypeChecking {
 
   bool isChar(const TypeSpecPtr& type_spec)
   {
-    return (type_spec != nullptr) && (type_spec->baseType() == Predefined::instance().charType);
+    return (type_spec != nullptr) && (type_spec->rawBaseType() == Predefined::instance().charType.get());
   }
 }
 
@@ -55,12 +55,13 @@ namespace TypeChecker::TypeCompatibility {
     if (target_type_spec == nullptr || value_type_spec == nullptr) {
       return false;
     }
-    const auto base_target_type_spec = target_type_spec->baseType();
-    const auto base_value_type_spec = value_type_spec->baseType();
+    // the anonymous types are interned, so identical types are the same object
+    const auto base_target_type_spec = target_type_spec->rawBaseType();
+    const auto base_value_type_spec = value_type_spec->rawBaseType();
     bool compatible = false;
     if (base_target_type_spec == base_value_type_spec) {
       compatible = true;
-    } else if (isReal(base_target_type_spec) && isInteger(base_value_type_spec)) {
+    } else if (isReal(target_type_spec) && isInteger(value_type_spec)) {
       // allow real:=integer
       compatible = true;
     } else {
@@ -76,14 +77,14 @@ namespace TypeChecker::TypeCompatibility {
     if (type_spec_a == nullptr || type_spec_b == nullptr) {
       return false;
     }
-    const auto a_base_type_spec = type_spec_a->baseType();
-    const auto b_base_type_spec = type_spec_b->baseType();
+    const auto a_base_type_spec = type_spec_a->rawBaseType();
+    const auto b_base_type_spec = type_spec_b->rawBaseType();
     bool compatible = false;
     const auto form = a_base_type_spec->form();
     if (a_base_type_spec == b_base_type_spec &&
         (form == TypeFormImpl::SCALAR || form == TypeFormImpl::ENUMERATION)) {
       compatible = true;
-    } else if (isAtLeastOneReal(a_base_type_spec, b_base_type_spec)) {
+    } else if (isAtLeastOneReal(type_spec_a, type_spec_b)) {
       compatible = true;
     } else {
       if (a_base_type_spec->isPascalString() && b_base_type_spec->isPascalString()){
@@ -1,6 +1,7 @@
 #include "Utilities.h"
 #include "Intermediate.h"
 
+#include <algorithm>
 #include <fmt/format.h>
 #include <string>
 
@@ -27,7 +28,9 @@ void CrossReferencer::printSymbolTable(const std::shared_ptr<const SymbolTableIm
   auto sorted_list = symbol_table->sortedEntries();
   // loop over the sorted list of symbol table entries
   for (const auto &elem : sorted_list) {
-    const auto line_numbers = elem->lineNumbers();
+    // deferred routine bodies add their references late
+    auto line_numbers = elem->lineNumbers();
+    std::sort(line_numbers.begin(), line_numbers.end());
     fmt::print("{: >{}}", elem->name(), NAME_WIDTH);
     std::string numbers;
     for (const auto &line_number : line_numbers) {
@@ -266,23 +269,23 @@ void ParseTreePrinter::printAttributes(const std::shared_ptr<const ICodeNodeImpl
   const auto saved_indentation = mLineIndentation;
   mLineIndentation += mIndentSpaces;
   //  const auto& attribute_table = node->attributeTable();
-  for (auto it = node->attributeMapBegin(); it != node->attributeMapEnd();
-       ++it) {
+  for (const auto key: {ICodeKeyTypeImpl::LINE, ICodeKeyTypeImpl::ID, ICodeKeyTypeImpl::VALUE}) {
+    if (!node->hasAttribute(key)) continue;
     std::string key_string;
-    switch (it->first) {
+    switch (key) {
       case ICodeKeyTypeImpl::LINE: {
         key_string += "LINE";
-        printAttribute(key_string, cast_by_enum<ICodeKeyTypeImpl::LINE>(it->second));
+        printAttribute(key_string, node->getAttribute<ICodeKeyTypeImpl::LINE>());
         break;
       }
       case ICodeKeyTypeImpl::ID: {
         key_string += "ID";
-        printAttribute(key_string, cast_by_enum<ICodeKeyTypeImpl::ID>(it->second));
+        printAttribute(key_string, node->getAttribute<ICodeKeyTypeImpl::ID>());
         break;
       }
       case ICodeKeyTypeImpl::VALUE: {
         key_string += "VALUE";
-        printAttribute(key_string, cast_by_enum<ICodeKeyTypeImpl::VALUE>(it->second));
+        printAttribute(key_string, node->getAttribute<ICodeKeyTypeImpl::VALUE>());
         break;
       }
     }
@@ -427,20 +430,19 @@ std::string ParseTreePrinterDot::printNode(const std::shared_ptr<const ICodeNode
 {
   // print current node
   std::string node_label = node->toString();
-  for (auto it = node->attributeMapBegin(); it != node->attributeMapEnd(); ++it) {
-    const auto value = it->second;
-    std::string key_string;
-    switch (it->first) {
+  for (const auto key: {ICodeKeyTypeImpl::LINE, ICodeKeyTypeImpl::ID, ICodeKeyTypeImpl::VALUE}) {
+    if (!node->hasAttribute(key)) continue;
+    switch (key) {
       case ICodeKeyTypeImpl::LINE: {
-        node_label += std::string{"\\n"} + "LINE: " + std::to_string(cast_by_enum<ICodeKeyTypeImpl::LINE>(it->second));
+        node_label += std::string{"\\n"} + "LINE: " + std::to_string(node->getAttribute<ICodeKeyTypeImpl::LINE>());
         break;
       }
       case ICodeKeyTypeImpl::ID: {
-        node_label += std::string{"\\n"} + "ID: " + cast_by_enum<ICodeKeyTypeImpl::ID>(it->second)->name();
+        node_label += std::string{"\\n"} + "ID: " + node->getAttribute<ICodeKeyTypeImpl::ID>()->name();
         break;
       }
       case ICodeKeyTypeImpl::VALUE: {
-        node_label += std::string{"\\n"} + "VALUE" + ": " + variable_value_to_string(cast_by_enum<ICodeKeyTypeImpl::VALUE>(it->second));
+        node_label += std::string{"\\n"} + "VALUE" + ": " + variable_value_to_string(node->getAttribute<ICodeKeyTypeImpl::VALUE>());
         break;
       }
     }
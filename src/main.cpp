@@ -7,6 +7,11 @@ int main(int argc, char* argv[]) {
   std::string filename;
   bool show_parse_tree = false;
   bool show_reference_listing = false;
+  bool pipelined_frontend = false;
+  bool lazy_routines = false;
+  bool shared_leaves = false;
+  unsigned lexer_threads = 0;
+  std::string cache_dir;
   app.require_subcommand(1);
   std::vector<std::string> subprogram_names{"compile", "interpret"};
   std::vector<CLI::App*> subprograms(2, nullptr);
@@ -16,6 +21,16 @@ int main(int argc, char* argv[]) {
     i->add_option("-f,--filename", filename, "Input filename");
     i->add_flag("-i", show_parse_tree, "Show the parse tree");
     i->add_flag("-x", show_reference_listing, "Show the reference listing");
+    i->add_flag("-p,--pipeline", pipelined_frontend, "Scan on a separate thread while parsing");
+    i->add_flag("-l,--lazy", lazy_routines,
+                "Parse the statements of a procedure or function when it is first needed (interpret only)");
+    i->add_flag("-d,--dag", shared_leaves,
+                "Share the equal constant and variable nodes of the intermediate code instead of copying them");
+    i->add_option("-j,--lexer-threads", lexer_threads,
+                  "Tokenize the whole source with this many threads before parsing (0: scan on demand)");
+    i->add_option("--cache", cache_dir,
+                  "Keep the parsed program in this directory and reuse it while the source is unchanged, "
+                  "or reuse the routines that are unchanged");
   }
   CLI11_PARSE(app, argc, argv);
   std::string flags;
@@ -23,7 +38,10 @@ int main(int argc, char* argv[]) {
     if (subprograms[i]->parsed()) {
       if (show_parse_tree) flags += "i";
       if (show_reference_listing) flags += "x";
-      Pascal p(subprogram_names[i], filename, flags);
+      if (pipelined_frontend) flags += "p";
+      if (lazy_routines) flags += "l";
+      if (shared_leaves) flags += "d";
+      Pascal p(subprogram_names[i], filename, flags, lexer_threads, cache_dir);
       break;
     }
   }